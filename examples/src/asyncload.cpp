@@ -0,0 +1,86 @@
+#include <axxegro/axxegro.hpp>
+
+/** @file
+ * Streams in a handful of bitmaps, a font and a sample with al::AsyncLoader
+ * while the frame loop keeps running. Bitmaps are uploaded at most 2 ms per frame.
+ * Press C to cancel whatever hasn't arrived yet.
+ */
+
+int main()
+{
+	std::set_terminate(al::Terminate);
+
+	al::Display disp(1024, 768);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+	auto builtinFont = al::Font::CreateBuiltinFont();
+
+	al::AsyncLoader loader;
+	loop.eventQueue.registerSource(loader.getEventSource());
+
+	const char* imageFiles[] = {
+		"data/bg.jpg", "data/nightsky.jpg", "data/grass.jpg",
+		"data/rock.jpg", "data/terrain.png", "data/dvdlogo.png"
+	};
+	for(int i=0; i<6; i++) {
+		/* later images are more important, so they should show up first */
+		loader.loadBitmap(imageFiles[i], i);
+	}
+	loader.loadBitmap("data/does_not_exist.png");
+	loader.loadFont("data/roboto.ttf", 32);
+	loader.loadSample("data/audio/uuhhh.ogg", 10);
+	al::ReserveSamples(1);
+
+	std::vector<std::shared_ptr<al::Bitmap>> bitmaps;
+	std::shared_ptr<al::Font> font;
+	std::vector<std::string> log;
+
+	loop.eventDispatcher.setUserEventHandler<al::AssetLoadedEvent<al::Bitmap>>([&](const auto& ev) {
+		log.push_back(al::Format("#%llu bitmap %s: %s", (unsigned long long)ev.id, ev.filename.c_str(), ev.ok() ? "ok" : ev.error.c_str()));
+		if(ev.ok()) {
+			bitmaps.push_back(ev.asset);
+		}
+	});
+	loop.eventDispatcher.setUserEventHandler<al::AssetLoadedEvent<al::Font>>([&](const auto& ev) {
+		log.push_back(al::Format("#%llu font %s: %s", (unsigned long long)ev.id, ev.filename.c_str(), ev.ok() ? "ok" : ev.error.c_str()));
+		font = ev.asset;
+	});
+	loop.eventDispatcher.setUserEventHandler<al::AssetLoadedEvent<al::Sample>>([&](const auto& ev) {
+		log.push_back(al::Format("#%llu sample %s: %s", (unsigned long long)ev.id, ev.filename.c_str(), ev.ok() ? "ok" : ev.error.c_str()));
+		if(ev.ok()) {
+			ev.asset->play();
+		}
+	});
+	loop.eventDispatcher.onKeyDown(ALLEGRO_KEY_C, [&](){
+		loader.cancelAll();
+		log.push_back("cancelled");
+	});
+
+	loop.run([&](){
+		loader.update(0.002);
+
+		al::TargetBitmap.clear();
+		float x = 0;
+		for(auto& bmp: bitmaps) {
+			float w = 160.0f;
+			float h = w * float(bmp->height()) / float(bmp->width());
+			bmp->drawScaled(al::RectF(bmp->rect()), al::RectF::XYWH(x, 200, w, h));
+			x += w + 8;
+		}
+
+		/* the frame loop never stalls: the spinner keeps moving while files load */
+		float angle = float(al::GetTime() * 4.0);
+		al::Vec2f center {980, 40};
+		al::DrawLine(center, center + al::Vec2f(std::cos(angle), std::sin(angle)) * 24.0f, al::White, 3.0f);
+
+		for(size_t i=0; i<log.size(); i++) {
+			builtinFont.drawText(log[i], al::White, {8, 15 + 12*int(i)});
+		}
+		builtinFont.drawText(al::Format("%d fps, %zu requests active", (int)loop.getFPS(), loader.numActive()), al::White, {8, 750});
+		if(font) {
+			font->drawText("TTF font loaded in the background", al::Yellow, {8, 600});
+		}
+		al::CurrentDisplay.flip();
+	});
+
+	return 0;
+}
@@ -0,0 +1,51 @@
+#include <axxegro/axxegro.hpp>
+#include <vector>
+
+/*
+ * Packs the tiles of terrain.png and a few standalone images into a texture atlas,
+ * then draws them all from the same parent bitmap so that Allegro can batch the draws.
+ */
+
+int main()
+{
+	std::set_terminate(al::Terminate);
+
+	al::Display disp(800, 600);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+
+	al::TextureAtlas atlas({1024, 1024});
+
+	const std::string layoutFile = "atlas_layout.ini";
+	try {
+		atlas.loadLayout(layoutFile);
+	} catch(al::ResourceLoadError&) {
+		/* first run: the layout will be computed and saved below */
+	}
+
+	al::Bitmap terrain = al::LoadBitmap("data/terrain.png");
+	std::vector<al::SubBitmap*> sprites;
+	for(int i=0; i<256; i++) {
+		auto tile = terrain.createSubBitmap(al::RectI::XYWH((i%16) * 16, (i/16) * 16, 16, 16));
+		sprites.push_back(&atlas.insert(al::Format("tile%d", i), tile));
+	}
+	sprites.push_back(&al::LoadBitmapIntoAtlas(atlas, "data/dvdlogo.png"));
+
+	atlas.saveLayout(layoutFile);
+
+	loop.run([&](){
+		al::TargetBitmap.clear();
+
+		al::Vec2f pos {0, 0};
+		for(auto* sprite: sprites) {
+			sprite->draw(pos);
+			pos.x += float(sprite->width());
+			if(pos.x > 780) {
+				pos = {0, pos.y + 20};
+			}
+		}
+
+		al::CurrentDisplay.flip();
+	});
+
+	return 0;
+}
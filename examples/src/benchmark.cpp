@@ -1,6 +1,7 @@
 #include <axxegro/axxegro.hpp>
 #include <random>
 #include <algorithm>
+#include <optional>
 
 /*
  * A benchmark template that doubles as an example program
@@ -25,8 +26,10 @@ int main()
 	
 	auto font = al::Font::CreateBuiltinFont();
 	static constexpr int BenchmarkTicks = 700;
+	static constexpr bool UseBatching = true;
 	
 	Avg frametimes;
+	al::PrimBatch batch;
 
 	loop.run([&](){
 
@@ -37,13 +40,20 @@ int main()
 
 		al::TargetBitmap.clear();
 
-		for(int i=0; i<100000; i++) {
-			int x1 = distW(gen);
-			int y1 = distH(gen);
-			int x2 = distW(gen);
-			int y2 = distH(gen);
+		{
+			std::optional<al::ScopedPrimBatch> scopedBatch;
+			if(UseBatching) {
+				scopedBatch.emplace(batch);
+			}
 
-			al::DrawLine(al::Vec2f(x1, y1), al::Vec2f(x2, y2), al::Blue);
+			for(int i=0; i<100000; i++) {
+				int x1 = distW(gen);
+				int y1 = distH(gen);
+				int x2 = distW(gen);
+				int y2 = distH(gen);
+
+				al::DrawLine(al::Vec2f(x1, y1), al::Vec2f(x2, y2), al::Blue);
+			}
 		}
 
 		if(loop.getTick() > 1) {
@@ -0,0 +1,86 @@
+#include <axxegro/axxegro.hpp>
+
+/** @file
+ * A grid of UI-like widgets (background, icon, highlight, label) drawn either
+ * immediately, widget by widget, or through al::CommandBuffer, which groups the
+ * backgrounds, icons and labels into layers and merges them into a few draw calls.
+ * Press space to switch.
+ */
+
+int main()
+{
+	std::set_terminate(al::Terminate);
+
+	al::Display disp(1024, 768);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+	auto font = al::Font::CreateBuiltinFont();
+
+	al::Bitmap icons[] = {
+		al::LoadBitmap("data/dvdlogo.png"),
+		al::LoadBitmap("data/grass.jpg"),
+		al::LoadBitmap("data/rock.jpg")
+	};
+
+	enum Layer: uint8_t {Background, Icons, Highlights, Labels};
+	al::Blender additive {ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ONE};
+
+	constexpr int Cols = 32, Rows = 22;
+	constexpr float CellSize = 32.0f;
+
+	bool useCommandBuffer = true;
+	loop.eventDispatcher.onKeyDown(ALLEGRO_KEY_SPACE, [&](){
+		useCommandBuffer = !useCommandBuffer;
+	});
+
+	al::CommandBuffer cmd;
+	loop.run([&](){
+		al::TargetBitmap.clear();
+
+		for(int y=0; y<Rows; y++) {
+			for(int x=0; x<Cols; x++) {
+				al::RectF cell = al::RectF::XYWH(8.0f + x*CellSize, 40.0f + y*CellSize, CellSize-2, CellSize-2);
+				al::RectF iconRect = al::RectF::XYWH(cell.a.x + 4, cell.a.y + 4, 16, 16);
+				const al::Bitmap& icon = icons[(x + y) % 3];
+				al::Color bg = al::RGB(40 + 5*x, 40, 40 + 8*y);
+				bool highlighted = (x*y) % 7 == 0;
+				char label[2] = {char('a' + (x + y*Cols) % 26), 0};
+
+				if(useCommandBuffer) {
+					cmd.drawFilledRectangle(cell, bg, {.layer = Background});
+					cmd.drawBitmapRegion(icon, al::RectF(icon.rect()), iconRect, al::White, {.layer = Icons});
+					if(highlighted) {
+						cmd.drawFilledRectangle(cell, al::RGB(30, 30, 0), {.layer = Highlights, .blender = additive});
+					}
+					cmd.drawCustom([&font, label0 = label[0], pos = cell.b - al::Vec2f(10, 10)](){
+						char s[2] = {label0, 0};
+						font.drawText(s, al::White, al::Vec2i(pos));
+					}, {.layer = Labels});
+				} else {
+					al::DrawFilledRectangle(cell, bg);
+					icon.drawScaled(al::RectF(icon.rect()), iconRect);
+					if(highlighted) {
+						al::ScopedBlender blender(additive);
+						al::DrawFilledRectangle(cell, al::RGB(30, 30, 0));
+					}
+					font.drawText(label, al::White, al::Vec2i(cell.b - al::Vec2f(10, 10)));
+				}
+			}
+		}
+
+		std::string info = al::Format("%d fps, immediate (SPACE to switch)", (int)loop.getFPS());
+		if(useCommandBuffer) {
+			size_t numCommands = cmd.size();
+			cmd.execute();
+			auto stats = cmd.getLastStats();
+			info = al::Format(
+				"%d fps, CommandBuffer: %zu commands, %zu draw calls, %zu state changes (SPACE to switch)",
+				(int)loop.getFPS(), numCommands, stats.numDrawCalls, stats.numStateChanges
+			);
+		}
+
+		font.drawText(info, al::White, {8, 15});
+		al::CurrentDisplay.flip();
+	});
+
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include <axxegro/axxegro.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/**
+ * @file
+ *
+ * A mostly static dashboard redrawn with al::DirtyRegionTracker: only the
+ * animated meter, the clock and the tile under the mouse are redrawn and
+ * flipped. Press F to toggle full redraws for comparison; the share of
+ * pixels redrawn is printed once per second.
+ */
+
+namespace {
+	constexpr int Cols = 8;
+	constexpr int Rows = 6;
+	constexpr al::Vec2f TileSize {120, 110};
+	constexpr al::Vec2f TileOrigin {24, 80};
+	constexpr al::RectF MeterRect {{24, 20}, {524, 60}};
+	constexpr al::RectF ClockRect {{800, 20}, {1000, 60}};
+
+	al::RectF TileRect(int col, int row) {
+		al::Vec2f pos = TileOrigin + al::Vec2f(float(col) * (TileSize.x + 6), float(row) * (TileSize.y + 6));
+		return al::RectF::PosSize(pos, TileSize);
+	}
+}
+
+int main()
+{
+	al::Display disp(1024, 768, ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
+	al::Font font("data/roboto.ttf", 20);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+
+	al::DirtyRegionTracker tracker(disp.size());
+	loop.eventDispatcher.setEventHandler<al::DisplayEvent>(ALLEGRO_EVENT_DISPLAY_EXPOSE, [&](const al::DisplayEvent& ev) {
+		tracker.handleEvent(ev);
+	});
+	loop.eventDispatcher.setEventHandler<al::DisplayEvent>(ALLEGRO_EVENT_DISPLAY_SWITCH_IN, [&](const al::DisplayEvent& ev) {
+		tracker.handleEvent(ev);
+	});
+
+	bool fullRedraw = false;
+	loop.eventDispatcher.onKeyDown(ALLEGRO_KEY_F, [&](){
+		fullRedraw = !fullRedraw;
+		tracker.invalidateAll();
+	});
+
+	int hovered = -1;
+	loop.eventDispatcher.setEventHandler<al::MouseEvent>(ALLEGRO_EVENT_MOUSE_AXES, [&](const al::MouseEvent& ev) {
+		int now = -1;
+		for(int i=0; i<Cols*Rows; i++) {
+			if(TileRect(i % Cols, i / Cols).contains(al::Vec2f(float(ev.x), float(ev.y)))) {
+				now = i;
+			}
+		}
+		if(now != hovered) {
+			for(int i: {hovered, now}) {
+				if(i >= 0) {
+					tracker.invalidate(TileRect(i % Cols, i / Cols));
+				}
+			}
+			hovered = now;
+		}
+	});
+
+	auto drawScene = [&](al::RectI clip) {
+		al::TargetBitmap.clearToColor(al::RGB(24, 28, 36));
+		for(int i=0; i<Cols*Rows; i++) {
+			al::RectF r = TileRect(i % Cols, i / Cols);
+			if(r.b.x < float(clip.a.x) || r.a.x > float(clip.b.x) || r.b.y < float(clip.a.y) || r.a.y > float(clip.b.y)) {
+				continue; //skipping draw calls outside the clip saves CPU time too
+			}
+			al::DrawFilledRoundRect(r, {8, 8}, i == hovered ? al::RGB(70, 90, 140) : al::RGB(44, 50, 64));
+			font.drawText(al::Format("sensor %d", i), al::RGB(200, 200, 210), (r.a + al::Vec2f(10, 10)).as<int>());
+			font.drawText(al::Format("%.1f", 20.0 + (i * 37) % 50 * 0.3), al::RGB(240, 240, 160), (r.a + al::Vec2f(10, 50)).as<int>());
+		}
+
+		double t = al::GetTime();
+		float level = float(0.5 + 0.5 * std::sin(t * 2.0));
+		al::DrawFilledRectangle(MeterRect, al::RGB(10, 10, 14));
+		al::DrawFilledRectangle(al::RectF(MeterRect.a, {MeterRect.a.x + level * MeterRect.width(), MeterRect.b.y}), al::RGB(80, 200, 120));
+		font.drawText(al::Format("%02d:%02d", int(t / 60) % 60, int(t) % 60), al::RGB(255, 255, 255), ClockRect.a.as<int>());
+	};
+
+	int64_t pixelsDrawn = 0, frames = 0, lastClock = -1;
+	double lastReport = al::GetTime();
+	loop.run([&](){
+		if(disp.size() != tracker.screen().size()) {
+			tracker.resize(disp.size());
+		}
+		tracker.invalidate(MeterRect);
+		if(int64_t(al::GetTime()) != lastClock) {
+			lastClock = int64_t(al::GetTime());
+			tracker.invalidate(ClockRect);
+		}
+		if(fullRedraw) {
+			tracker.invalidateAll();
+		}
+
+		if(tracker.hasDamage()) {
+			for(const auto& r: tracker.getRepaintRects()) {
+				pixelsDrawn += int64_t(r.width()) * r.height();
+			}
+			tracker.redraw(drawScene);
+			tracker.present();
+		}
+		frames++;
+
+		if(al::GetTime() - lastReport >= 1.0) {
+			al::RectI scr = tracker.screen();
+			double share = double(pixelsDrawn) / (double(frames) * scr.width() * scr.height());
+			std::printf("%s: %.1f%% of the screen redrawn per frame\n", fullRedraw ? "full" : "dirty rects", 100.0 * share);
+			pixelsDrawn = frames = 0;
+			lastReport = al::GetTime();
+		}
+	});
+}
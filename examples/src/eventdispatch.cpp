@@ -0,0 +1,185 @@
+#include <axxegro/axxegro.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Headless microbenchmark: ns/event for al::EventDispatcher compared to the
+ * previous hash map based design, which is reproduced below as LegacyDispatcher.
+ */
+
+namespace {
+
+	/* the dispatcher as it was before the flat dispatch table */
+	class LegacyDispatcher {
+	public:
+		using Discretizer = std::function<int64_t(const al::Event&)>;
+
+		LegacyDispatcher() {
+			discretizers.resize(3);
+			discretizers[al::ByKeycode] = [](const al::Event& ev) {return ev.keyboard.keycode;};
+			discretizers[al::ByUnichar] = [](const al::Event& ev) {return ev.keyboard.unichar;};
+			discretizers[al::ByMouseBtn] = [](const al::Event& ev) {return ev.mouse.button;};
+		}
+
+		template<al::EventDataType EventT>
+		void setEventHandlerForValue(al::EventType type, al::EventDiscretizerID discrId, int64_t value, al::EventHandler<EventT> handler) {
+			auto& relevant = relevantDiscretizers[type];
+			if(std::find(relevant.begin(), relevant.end(), discrId) == relevant.end()) {
+				relevant.push_back(discrId);
+			}
+			handlers[Coord{type, Value{discrId, value}}] = std::make_unique<al::EventHandler<EventT>>(std::move(handler));
+		}
+
+		template<al::EventDataType EventT>
+		void setEventHandler(al::EventType type, al::EventHandler<EventT> handler) {
+			handlers[Coord{type, std::nullopt}] = std::make_unique<al::EventHandler<EventT>>(std::move(handler));
+		}
+
+		al::EventHandledStatus dispatch(const al::Event& event) {
+			if(auto it = relevantDiscretizers.find(event.type); it != relevantDiscretizers.end()) {
+				for(auto id: it->second) {
+					if(tryDispatch(event, Coord{event.type, Value{id, discretizers[id](event)}}) == al::EventHandled) {
+						return al::EventHandled;
+					}
+				}
+			}
+			if(tryDispatch(event, Coord{event.type, std::nullopt}) == al::EventHandled) {
+				return al::EventHandled;
+			}
+			return tryDispatch(event, Coord{});
+		}
+
+	private:
+		struct Value {
+			al::EventDiscretizerID id;
+			int64_t value;
+			friend auto operator<=>(const Value&, const Value&) = default;
+		};
+
+		struct Coord {
+			std::optional<al::EventType> type;
+			std::optional<Value> value;
+			friend auto operator<=>(const Coord&, const Coord&) = default;
+		};
+
+		struct CoordHash {
+			std::size_t operator()(const Coord& c) const {
+				std::size_t ret = 1437;
+				al::HashCombine(ret, c.type);
+				if(c.value) {
+					al::HashCombine(ret, c.value->id);
+					al::HashCombine(ret, c.value->value);
+				}
+				return ret;
+			}
+		};
+
+		al::EventHandledStatus tryDispatch(const al::Event& event, const Coord& coord) {
+			if(auto it = handlers.find(coord); it != handlers.end()) {
+				return it->second->handle(event);
+			}
+			return al::EventNotHandled;
+		}
+
+		std::vector<Discretizer> discretizers;
+		std::unordered_map<al::EventType, std::vector<al::EventDiscretizerID>> relevantDiscretizers;
+		std::unordered_map<Coord, std::unique_ptr<al::IEventHandler>, CoordHash> handlers;
+	};
+
+	struct ChunkEvent {
+		int frames;
+	};
+
+	struct Counters {
+		int64_t mouse = 0;
+		int64_t keys = 0;
+		int64_t timer = 0;
+		int64_t chunks = 0;
+	};
+
+	/* mostly mouse axes, plus timer ticks, audio-like user events and key presses (half without a handler) */
+	std::vector<al::Event> MakeEventStream(size_t count) {
+		std::mt19937 rng(1234);
+		std::uniform_int_distribution<int> kind(0, 99);
+		std::uniform_int_distribution<int> key(ALLEGRO_KEY_A, ALLEGRO_KEY_A + 39);
+		std::vector<al::Event> ret(count);
+		for(auto& ev: ret) {
+			int k = kind(rng);
+			if(k < 70) {
+				ev.mouse.type = ALLEGRO_EVENT_MOUSE_AXES;
+				ev.mouse.dx = 1;
+			} else if(k < 80) {
+				ev.timer.type = ALLEGRO_EVENT_TIMER;
+			} else if(k < 90) {
+				ev = al::CreateUserEvent(ChunkEvent{.frames = 256});
+			} else {
+				ev.keyboard.type = ALLEGRO_EVENT_KEY_DOWN;
+				ev.keyboard.keycode = key(rng);
+			}
+		}
+		return ret;
+	}
+
+	template<typename DispatcherT>
+	void RegisterHandlers(DispatcherT& d, Counters& c) {
+		d.template setEventHandler<al::MouseEvent>(ALLEGRO_EVENT_MOUSE_AXES, [&c](const al::MouseEvent& ev) {
+			c.mouse += ev.dx;
+		});
+		d.template setEventHandler<al::TimerEvent>(ALLEGRO_EVENT_TIMER, [&c]() {
+			c.timer++;
+		});
+		d.template setEventHandler<ChunkEvent>(al::UserEventTypeIDGetter<ChunkEvent>{}(), [&c](const ChunkEvent& ev) {
+			c.chunks += ev.frames;
+		});
+		for(int key=ALLEGRO_KEY_A; key<ALLEGRO_KEY_A+20; key++) {
+			d.template setEventHandlerForValue<al::KeyboardEvent>(ALLEGRO_EVENT_KEY_DOWN, al::ByKeycode, key, [&c]() {
+				c.keys++;
+			});
+		}
+	}
+
+	template<typename DispatcherT>
+	double MeasureNsPerEvent(const std::vector<al::Event>& events, int rounds) {
+		DispatcherT dispatcher;
+		Counters counters;
+		RegisterHandlers(dispatcher, counters);
+
+		auto t0 = std::chrono::steady_clock::now();
+		for(int r=0; r<rounds; r++) {
+			for(const auto& ev: events) {
+				dispatcher.dispatch(ev);
+			}
+		}
+		auto t1 = std::chrono::steady_clock::now();
+
+		/* keep the counters observable so the loop can't be optimized out */
+		std::printf("  (mouse=%lld keys=%lld timer=%lld chunks=%lld)\n",
+			(long long)counters.mouse, (long long)counters.keys,
+			(long long)counters.timer, (long long)counters.chunks);
+
+		double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+		return ns / (double(events.size()) * rounds);
+	}
+}
+
+int main()
+{
+	constexpr size_t NumEvents = 4096;
+	constexpr int Rounds = 2000;
+
+	auto events = MakeEventStream(NumEvents);
+
+	double legacy = MeasureNsPerEvent<LegacyDispatcher>(events, Rounds);
+	std::printf("hash map dispatcher:   %6.2f ns/event\n", legacy);
+
+	double current = MeasureNsPerEvent<al::EventDispatcher>(events, Rounds);
+	std::printf("al::EventDispatcher:   %6.2f ns/event (%.2fx)\n", current, legacy / current);
+
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include <axxegro/axxegro.hpp>
+
+
+/**
+ * @file
+ *
+ * The bouncing DVD logo from dvdlogo.cpp, simulated at a fixed 10 Hz and
+ * rendered at the display's rate with interpolation.
+ *
+ * SPACE toggles interpolation, S toggles an artificially slow update
+ * that makes the loop catch up and drop ticks. P saves frame timings
+ * to frametimes.csv and frametimes.json.
+ */
+
+int main()
+{
+	al::Display disp(1024, 768, ALLEGRO_MIN_LINEAR|ALLEGRO_MIPMAP);
+	al::Bitmap dvdLogo = al::LoadBitmap("data/dvdlogo.png");
+	al::Font font("data/roboto.ttf", 16);
+
+	constexpr double UpdateRate = 10.0;
+
+	al::Vec2f speed(256, 256); // in px/s
+	al::Vec2f logoSize(128, 128); // in px
+	al::RectF scrRect = al::CurrentDisplay.rect();
+
+	al::RectF prevLogoRect = al::RectF::PosSize({40, 70}, logoSize);
+	al::RectF logoRect = prevLogoRect;
+
+	bool interpolate = true;
+	bool slowUpdate = false;
+
+	al::EventLoop evLoop(al::DemoEventLoopConfig);
+	evLoop.eventDispatcher.onKeyDown(ALLEGRO_KEY_SPACE, [&](){
+		interpolate = !interpolate;
+	});
+	evLoop.eventDispatcher.onKeyDown(ALLEGRO_KEY_S, [&](){
+		slowUpdate = !slowUpdate;
+	});
+	evLoop.eventDispatcher.onKeyDown(ALLEGRO_KEY_P, [&](){
+		evLoop.profiler.saveCSV("frametimes.csv");
+		evLoop.profiler.saveJSON("frametimes.json");
+	});
+
+	auto update = [&](){
+		if(slowUpdate) {
+			al::Sleep(0.15);
+		}
+		prevLogoRect = logoRect;
+		logoRect += speed * float(1.0 / UpdateRate);
+
+		uint8_t test = scrRect.test(logoRect);
+		if(test & al::RectF::TEST_X_NOT_IN_RANGE) {
+			speed.x *= -1.0f;
+		}
+		if(test & al::RectF::TEST_Y_NOT_IN_RANGE) {
+			speed.y *= -1.0f;
+		}
+		logoRect = scrRect.clamp(logoRect);
+	};
+
+	auto render = [&](double alpha){
+		al::TargetBitmap.clearToColor(al::RGB(150,180,240));
+
+		al::Vec2f pos = logoRect.a;
+		if(interpolate) {
+			pos = prevLogoRect.a + (logoRect.a - prevLogoRect.a) * float(alpha);
+		}
+		dvdLogo.drawScaled(dvdLogo.rect(), al::RectF::PosSize(pos, logoSize));
+
+		auto stats = evLoop.getFixedStepStats();
+		font.drawText(al::Format(
+			"%.0f FPS, %.0f Hz updates | interpolation: %s (SPACE) | slow update: %s (S)",
+			evLoop.getFPS(), UpdateRate, interpolate ? "on" : "off", slowUpdate ? "on" : "off"
+		), al::White, {10, 10});
+		font.drawText(al::Format(
+			"updates: %lld, catch-up updates: %lld, dropped ticks: %lld, alpha: %.2f",
+			(long long)stats.numUpdates, (long long)stats.numCatchUpUpdates,
+			(long long)stats.numDroppedTicks, stats.lastAlpha
+		), al::White, {10, 30});
+
+		auto frameStats = evLoop.profiler.getStats();
+		auto renderStats = evLoop.profiler.getSectionStats(*evLoop.profiler.findSection("render"));
+		font.drawText(al::Format(
+			"frame time p50/p99/max: %.2f/%.2f/%.2f ms, render p99: %.2f ms (P saves timings)",
+			1000.0 * frameStats.p50, 1000.0 * frameStats.p99, 1000.0 * frameStats.max, 1000.0 * renderStats.p99
+		), al::White, {10, 50});
+
+		al::CurrentDisplay.flip();
+	};
+
+	evLoop.runFixed(al::Hz(UpdateRate), update, render);
+}
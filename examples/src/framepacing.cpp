@@ -0,0 +1,33 @@
+#include <axxegro/axxegro.hpp>
+
+#include <cstdio>
+
+/*
+ * Headless comparison of frame pacing modes: prints FramerateLimiter
+ * statistics for timer based and precise pacing at a few common rates.
+ */
+
+static constexpr double SecondsPerRun = 2.0;
+
+int main()
+{
+	for(double hz: {60.0, 144.0, 240.0}) {
+		for(auto pacing: {al::FramePacing::TimerEvents, al::FramePacing::Precise}) {
+			al::FramerateLimiter limiter(al::Hz(hz), pacing);
+
+			double t0 = al::GetTime();
+			while(al::GetTime() - t0 < SecondsPerRun) {
+				limiter.wait();
+			}
+
+			auto stats = limiter.getStats();
+			printf(
+				"%3.0f Hz %-7s: mean %6.3f ms, p99 %6.3f ms, max %6.3f ms, overshoot %6.3f ms, missed %lld of %lld\n",
+				hz, pacing == al::FramePacing::Precise ? "precise" : "timer",
+				1000.0 * stats.meanInterval, 1000.0 * stats.p99Interval, 1000.0 * stats.maxInterval,
+				1000.0 * stats.meanOvershoot, (long long)stats.numMissedFrames, (long long)stats.numFrames
+			);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include <axxegro/axxegro.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+
+/**
+ * @file
+ *
+ * Thousands of dial gauges (arcs, ticks, needles and splines) recorded into
+ * a PrimBatch. Curves are tessellated from cached sin/cos tables with segment
+ * counts that follow the on-screen size: use the mouse wheel to zoom and watch
+ * the segment count change. The time spent recording and drawing a frame is
+ * printed once per second.
+ */
+
+namespace {
+	constexpr int Cols = 60;
+	constexpr int Rows = 40;
+	constexpr float Spacing = 48.0f;
+	constexpr float Radius = 20.0f;
+	constexpr float Sweep = 1.5f * std::numbers::pi_v<float>;
+	constexpr float StartAngle = 0.75f * std::numbers::pi_v<float>;
+
+	void DrawGauge(al::Vec2f center, float value) {
+		al::DrawFilledCircle(center, Radius, al::RGB(30, 34, 44));
+		al::DrawArc(center, Radius - 3, StartAngle, Sweep, al::RGB(90, 96, 110), 2);
+		al::DrawArc(center, Radius - 3, StartAngle, Sweep * value, al::RGB(80, 200, 140), 2);
+		for(int i=0; i<=4; i++) {
+			float a = StartAngle + Sweep * float(i) / 4;
+			al::Vec2f dir {std::cos(a), std::sin(a)};
+			al::DrawLine(center + dir * (Radius - 8), center + dir * (Radius - 5), al::RGB(200, 200, 210), 1);
+		}
+		float a = StartAngle + Sweep * value;
+		al::DrawLine(center, center + al::Vec2f(std::cos(a), std::sin(a)) * (Radius - 6), al::RGB(240, 90, 60), 1.5f);
+		al::DrawSpline({
+			center + al::Vec2f(-12, 14), center + al::Vec2f(-4, 4 - 14 * value),
+			center + al::Vec2f(4, 18 - 14 * value), center + al::Vec2f(12, 10)
+		}, al::RGB(160, 170, 255), 1);
+	}
+}
+
+int main()
+{
+	al::Display disp(1280, 800, ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+	al::PrimBatch batch;
+
+	float zoom = 0.5f;
+	loop.eventDispatcher.setEventHandler<al::MouseEvent>(ALLEGRO_EVENT_MOUSE_AXES, [&](const al::MouseEvent& ev) {
+		zoom = std::clamp(zoom * std::pow(1.1f, float(ev.dz)), 0.05f, 8.0f);
+	});
+
+	double recordSeconds = 0.0;
+	int frames = 0;
+	double lastReport = al::GetTime();
+	loop.run([&](){
+		al::TargetBitmap.clearToColor(al::RGB(12, 14, 20));
+		double t = al::GetTime();
+
+		al::Transform view;
+		view.scale(al::Vec2f(zoom, zoom));
+		al::ScopedTransform scopedView(view);
+
+		auto t0 = std::chrono::steady_clock::now();
+		{
+			al::ScopedPrimBatch scopedBatch(batch);
+			for(int y=0; y<Rows; y++) {
+				for(int x=0; x<Cols; x++) {
+					float value = float(0.5 + 0.5 * std::sin(t + x * 0.3 + y * 0.17));
+					DrawGauge({Spacing * (float(x) + 0.5f), Spacing * (float(y) + 0.5f)}, value);
+				}
+			}
+		}
+		recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		frames++;
+
+		al::CurrentDisplay.flip();
+
+		if(t - lastReport >= 1.0) {
+			std::printf("zoom %.2f: %d segments per gauge circle, %.3f ms per frame recording and drawing\n",
+				zoom, al::ArcSegmentCount(Radius, 2.0f * std::numbers::pi_v<float>, zoom), 1000.0 * recordSeconds / frames);
+			recordSeconds = 0.0;
+			frames = 0;
+			lastReport = t;
+		}
+	});
+}
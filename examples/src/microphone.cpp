@@ -69,21 +69,23 @@ struct RingModulator {
 	explicit RingModulator(al::Hz carrierFreq): buffer(32768), carrierFrequency(carrierFreq) {}
 
 	/*
-	 * Take the input, process it and save it in the ring buffer.
+	 * Take the input, process it and write it straight into the ring buffer.
 	 */
 	bool consume(const std::span<const al::Vec2f> input)
 	{
-		static std::vector<al::Vec2f> output;
-		output.resize(input.size());
+		auto output = buffer.writeSpans(input.size());
+		if(output.size() < input.size()) {
+			return false;
+		}
 
 		for(unsigned i=0; i<input.size(); i++) {
 			double tSecs = double(samplesProcessed++) / sampleRate;
 			double carrier = std::sin(2.0 * std::numbers::pi * (tSecs * carrierFrequency.getHz()));
 			output[i] = input[i] * carrier;
-			//output[i] = al::Vec2f(0.2, 0.2) * carrier;
 		}
 
-		return buffer.pushData(output);
+		buffer.commitWrite(input.size());
+		return true;
 	}
 
 	/*
@@ -106,7 +108,7 @@ struct RingModulator {
 
 	int bufsize() {return buffer.size();}
 private:
-	al::RingBuffer<al::Vec2f> buffer;
+	al::SPSCRingBuffer<al::Vec2f> buffer;
 
 	int64_t samplesProcessed = 0;
 	size_t cooldown = 0;
@@ -0,0 +1,60 @@
+#include <axxegro/axxegro.hpp>
+#include <thread>
+#include <vector>
+
+/*
+ * Headless benchmark of al::TransformPixels on 4K memory bitmaps
+ * with different thread counts.
+ */
+
+static constexpr int Width = 3840;
+static constexpr int Height = 2160;
+static constexpr int Iterations = 20;
+
+int main()
+{
+	al::ScopedNewBitmapFlags bitmapFlags(ALLEGRO_MEMORY_BITMAP);
+	al::Bitmap src(Width, Height, al::RGB(40, 120, 200));
+	al::Bitmap dst(Width, Height);
+
+	std::vector<unsigned> threadCounts = {1, 2, 4};
+	unsigned maxThreads = al::ThreadPool::Default().numWorkers() + 1;
+	if(maxThreads > 4) {
+		threadCounts.push_back(maxThreads);
+	}
+
+	auto srcLock = src.lockReadOnly<al::PixelARGB8888>();
+	auto dstLock = dst.lockWriteOnly<al::PixelARGB8888>();
+
+	/* a cheap color grading operation: swap red/blue and apply a contrast curve */
+	auto grade = [](const al::PixelARGB8888& in) {
+		auto curve = [](int v) {
+			int c = (v - 128) * 3 / 2 + 128;
+			return (uint8_t) std::clamp(c, 0, 255);
+		};
+		al::PixelARGB8888 out = in;
+		out.r = curve(in.b);
+		out.g = curve(in.g);
+		out.b = curve(in.r);
+		return out;
+	};
+
+	double serialTime = 0.0;
+	for(unsigned numThreads: threadCounts) {
+		al::ParallelOptions opt {.maxThreads = numThreads};
+		double t0 = al::GetTime();
+		for(int i=0; i<Iterations; i++) {
+			al::TransformPixels(dstLock, srcLock, grade, opt);
+		}
+		double avg = (al::GetTime() - t0) / Iterations;
+		if(numThreads == 1) {
+			serialTime = avg;
+		}
+		printf(
+			"%2u thread(s): %8.3f ms per %dx%d frame (%.2fx)\n",
+			numThreads, 1000.0 * avg, Width, Height, serialTime / avg
+		);
+	}
+
+	return 0;
+}
@@ -0,0 +1,60 @@
+#include <axxegro/axxegro.hpp>
+
+#include <chrono>
+#include <cstdio>
+
+/*
+ * Headless benchmark of al::ParallelCommandRecorder: records 400k sprites in
+ * 64 chunks, on one thread and on the default thread pool. Recording doesn't
+ * call Allegro, so a dummy texture pointer is enough and nothing is drawn.
+ */
+
+namespace {
+	constexpr size_t NumChunks = 64;
+	constexpr int SpritesPerChunk = 6250;
+	constexpr int Frames = 20;
+
+	double MeasureNsPerCommand(al::ParallelCommandRecorder& recorder, al::ThreadPool& pool, const al::Bitmap& texture) {
+		double totalNs = 0.0;
+		size_t totalCommands = 0;
+		for(int frame=0; frame<Frames; frame++) {
+			auto t0 = std::chrono::steady_clock::now();
+			recorder.record(NumChunks, [&](size_t chunk, al::CommandList& list) {
+				for(int i=0; i<SpritesPerChunk; i++) {
+					al::Vec2f pos(float(i % 1024), float(chunk * 12 + i / 1024));
+					list.drawSprite(
+						texture, al::RectF::XYWH(0, 0, 16, 16), {8, 8}, pos, {1, 1},
+						0.01f * float(i + frame), al::White, {.layer = uint8_t(i % 4)}
+					);
+				}
+			}, pool);
+			auto t1 = std::chrono::steady_clock::now();
+
+			/* the first frame grows the lists' storage */
+			if(frame > 0) {
+				totalNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+				for(size_t c=0; c<recorder.size(); c++) {
+					totalCommands += recorder.context(c).size();
+				}
+			}
+			recorder.clear();
+		}
+		return totalNs / double(totalCommands);
+	}
+}
+
+int main()
+{
+	al::Bitmap dummyTexture(reinterpret_cast<ALLEGRO_BITMAP*>(16), al::ResourceModel::NonOwning);
+	al::ParallelCommandRecorder recorder;
+
+	al::ThreadPool serial(0);
+	double single = MeasureNsPerCommand(recorder, serial, dummyTexture);
+	std::printf("1 thread:   %6.1f ns/command\n", single);
+
+	al::ThreadPool& pool = al::ThreadPool::Default();
+	double multi = MeasureNsPerCommand(recorder, pool, dummyTexture);
+	std::printf("%u threads: %6.1f ns/command (%.2fx)\n", pool.numWorkers() + 1, multi, single / multi);
+
+	return 0;
+}
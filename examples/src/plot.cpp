@@ -0,0 +1,86 @@
+#include <axxegro/axxegro.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+/**
+ * @file
+ *
+ * Plots a 100k-point signal as one thick, seamless polyline with
+ * al::PathTessellator, over a filled concave area chart. The tessellator is
+ * reused every frame, so once it has warmed up no memory is allocated.
+ * Press J to cycle through the join styles; tessellation time is printed
+ * once per second.
+ */
+
+namespace {
+	constexpr int NumSamples = 100000;
+}
+
+int main()
+{
+	al::Display disp(1280, 720, ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+
+	std::mt19937 gen(42);
+	std::normal_distribution<float> noise(0.0f, 1.0f);
+	std::vector<float> samples(NumSamples);
+	float level = 0;
+	for(auto& s: samples) {
+		level = level * 0.999f + noise(gen);
+		s = level;
+	}
+
+	al::StrokeStyle style {.thickness = 2.5f, .join = al::LineJoin::Miter, .cap = al::LineCap::Round};
+	loop.eventDispatcher.onKeyDown(ALLEGRO_KEY_J, [&](){
+		style.join = style.join == al::LineJoin::Miter ? al::LineJoin::Round
+		           : style.join == al::LineJoin::Round ? al::LineJoin::Bevel
+		           : al::LineJoin::Miter;
+	});
+
+	al::PathTessellator tessellator;
+	std::vector<al::Vec2f> line(NumSamples);
+	std::vector<al::Vec2f> area(NumSamples / 100 + 2);
+
+	double tessSeconds = 0.0;
+	int frames = 0;
+	double lastReport = al::GetTime();
+	loop.run([&](){
+		al::Vec2f size = disp.size().as<float>();
+		double t = al::GetTime();
+		auto offset = size_t(t * 2000.0) % NumSamples;
+
+		/* the area chart uses every 100th sample */
+		for(size_t i=0; i<line.size(); i++) {
+			float x = size.x * float(i) / float(NumSamples - 1);
+			line[i] = {x, size.y * 0.5f - samples[(i + offset) % NumSamples] * 2.0f};
+		}
+		for(size_t i=0; i+2<area.size(); i++) {
+			area[i] = line[i * 100];
+		}
+		area[area.size() - 2] = {size.x, size.y};
+		area[area.size() - 1] = {0, size.y};
+
+		auto t0 = std::chrono::steady_clock::now();
+		tessellator.clear();
+		tessellator.fill(area, al::RGB(40, 70, 120));
+		tessellator.stroke(line, al::RGB(120, 200, 255), style);
+		tessSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+		frames++;
+
+		al::TargetBitmap.clearToColor(al::RGB(10, 12, 18));
+		tessellator.draw();
+		al::CurrentDisplay.flip();
+
+		if(t - lastReport >= 1.0) {
+			std::printf("%zu triangles, %.3f ms per frame tessellating\n",
+				tessellator.numTriangleVertices() / 3, 1000.0 * tessSeconds / frames);
+			tessSeconds = 0.0;
+			frames = 0;
+			lastReport = t;
+		}
+	});
+}
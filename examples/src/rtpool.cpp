@@ -0,0 +1,73 @@
+#include <axxegro/axxegro.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+/**
+ * @file
+ *
+ * A cheap glow effect built from offscreen passes with al::RenderTargetPool:
+ * the scene and a downscaled copy of it are drawn into pooled bitmaps every
+ * frame, and the bitmaps are reused instead of being recreated. Resize the
+ * window to see targets for the old size being trimmed; pool statistics are
+ * printed once per second.
+ */
+
+namespace {
+	void DrawScene(double t, al::Vec2f size) {
+		for(int i=0; i<12; i++) {
+			double phase = t * 0.7 + i * 0.52;
+			al::Vec2f pos {
+				size.x * float(0.5 + 0.4 * std::cos(phase * 1.3)),
+				size.y * float(0.5 + 0.4 * std::sin(phase))
+			};
+			al::DrawFilledCircle(pos, 14, al::RGB(80 + i * 14, 200 - i * 10, 255));
+		}
+	}
+}
+
+int main()
+{
+	al::Display disp(1024, 768, ALLEGRO_WINDOWED | ALLEGRO_RESIZABLE);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+	al::RenderTargetPool pool;
+
+	double lastReport = al::GetTime();
+	loop.run([&](){
+		al::Vec2i size = disp.size();
+		al::Vec2i glowSize {std::max(size.x / 4, 1), std::max(size.y / 4, 1)};
+		double t = al::GetTime();
+
+		auto glow = pool.acquire(glowSize, ALLEGRO_PIXEL_FORMAT_ANY_WITH_ALPHA, ALLEGRO_VIDEO_BITMAP | ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR);
+		{
+			auto scene = pool.bind(size, ALLEGRO_PIXEL_FORMAT_ANY_WITH_ALPHA, ALLEGRO_VIDEO_BITMAP | ALLEGRO_MIN_LINEAR);
+			al::TargetBitmap.clearToColor(al::RGBA(0, 0, 0, 0));
+			DrawScene(t, size.as<float>());
+
+			/* downscaling with linear filtering blurs the scene enough for a glow */
+			al::ScopedTargetBitmap target(*glow);
+			al::TargetBitmap.clearToColor(al::RGBA(0, 0, 0, 0));
+			scene->drawScaled(scene->rect(), al::RectF({0, 0}, glowSize.as<float>()));
+		}
+
+		al::TargetBitmap.clearToColor(al::RGB(10, 12, 20));
+		DrawScene(t, size.as<float>());
+		{
+			al::ScopedBlender additive({ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ONE});
+			glow->drawScaled(glow->rect(), al::RectF({0, 0}, size.as<float>()));
+		}
+		al::CurrentDisplay.flip();
+		pool.endFrame();
+
+		if(t - lastReport >= 1.0) {
+			const auto& stats = pool.getStats();
+			std::printf(
+				"%zu targets (%.1f MB, peak %.1f MB), %llu created, %llu reused, %llu trimmed\n",
+				stats.numTargets, double(stats.currentBytes) / 1048576.0, double(stats.peakBytes) / 1048576.0,
+				(unsigned long long)stats.numCreated, (unsigned long long)stats.numReused, (unsigned long long)stats.numTrimmed
+			);
+			lastReport = t;
+		}
+	});
+}
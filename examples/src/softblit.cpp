@@ -0,0 +1,180 @@
+#include <axxegro/axxegro.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <optional>
+
+/*
+ * Benchmark of al::SoftwareBlit against Allegro's own drawing between memory
+ * bitmaps, for a few common blenders, with and without tinting and scaling.
+ * Also prints the largest per-channel difference between the two results and
+ * exits with failure if a checked case differs by more than MaxDifference.
+ * Scaled blits of a patterned source sample different source pixels than
+ * Allegro does, so they are only reported; the flat source cases check the
+ * blending of the scaled path for each filter. No display is needed.
+ */
+
+namespace {
+	constexpr int Rounds = 20;
+	constexpr al::Vec2i DstSize {1024, 768};
+	constexpr al::Vec2i SrcSize {512, 384};
+	constexpr int MaxDifference = 2;
+
+	struct Case {
+		const char* name;
+		al::Blender blender;
+		al::Color tint;
+		al::RectI dstRect;
+		al::ScaleFilter filter;
+		bool flatSource = false;
+		bool checked = true;
+	};
+
+	void FillPattern(al::Bitmap& bmp, uint32_t seed) {
+		auto lock = bmp.lockWriteOnly<al::PixelARGB8888>();
+		for(int y=0; y<lock.height(); y++) {
+			auto row = lock.row(y);
+			for(int x=0; x<lock.width(); x++) {
+				/* premultiplied: color channels never exceed alpha */
+				uint32_t a = (x * 3 + y * 5 + seed) & 0xFF;
+				uint32_t r = ((x ^ y) + seed) & 0xFF;
+				uint32_t g = (x * y / 7 + seed) & 0xFF;
+				uint32_t b = (y * 2) & 0xFF;
+				row[x].set(a << 24 | (r * a / 255) << 16 | (g * a / 255) << 8 | (b * a / 255));
+			}
+		}
+	}
+
+	void FillFlat(al::Bitmap& bmp) {
+		auto lock = bmp.lockWriteOnly<al::PixelARGB8888>();
+		for(int y=0; y<lock.height(); y++) {
+			auto row = lock.row(y);
+			for(int x=0; x<lock.width(); x++) {
+				row[x].set(0xC8965A28);
+			}
+		}
+	}
+
+	std::vector<uint32_t> Pixels(al::Bitmap& bmp) {
+		std::vector<uint32_t> ret;
+		auto lock = bmp.lockReadOnly<al::PixelARGB8888>();
+		for(int y=0; y<lock.height(); y++) {
+			auto row = lock.row(y);
+			for(auto px: row) {
+				uint32_t v;
+				std::memcpy(&v, &px, sizeof(v));
+				ret.push_back(v);
+			}
+		}
+		return ret;
+	}
+
+	int MaxChannelDifference(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+		int ret = 0;
+		for(size_t i=0; i<a.size(); i++) {
+			for(int c=0; c<4; c++) {
+				int d = int((a[i] >> (8*c)) & 0xFF) - int((b[i] >> (8*c)) & 0xFF);
+				ret = std::max(ret, std::abs(d));
+			}
+		}
+		return ret;
+	}
+
+	double MeasureMs(const std::function<void()>& fn) {
+		auto t0 = std::chrono::steady_clock::now();
+		for(int i=0; i<Rounds; i++) {
+			fn();
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(t1 - t0).count() / Rounds;
+	}
+}
+
+int main()
+{
+	al::ScopedNewBitmapFlags memoryBitmaps(ALLEGRO_MEMORY_BITMAP);
+	al::ScopedNewBitmapFormat argb(al::PixelARGB8888::PixelFormat);
+
+	al::Bitmap background(DstSize.x, DstSize.y);
+	al::Bitmap dst(DstSize.x, DstSize.y);
+	al::Bitmap src(SrcSize.x, SrcSize.y);
+	al::Bitmap flat(SrcSize.x, SrcSize.y);
+	std::optional<al::Bitmap> srcLinear, flatLinear;
+	{
+		al::ScopedNewBitmapFlags linear(ALLEGRO_MEMORY_BITMAP | ALLEGRO_MIN_LINEAR | ALLEGRO_MAG_LINEAR);
+		srcLinear.emplace(SrcSize.x, SrcSize.y);
+		flatLinear.emplace(SrcSize.x, SrcSize.y);
+	}
+	FillPattern(background, 17);
+	FillPattern(src, 0);
+	FillPattern(*srcLinear, 0);
+	FillFlat(flat);
+	FillFlat(*flatLinear);
+
+	al::RectI unscaled {{100, 50}, al::Vec2i{100, 50} + SrcSize};
+	al::RectI scaled {{-30, -20}, DstSize + al::Vec2i{30, 20}};
+	al::Color tint = al::RGBA_f(0.9f, 0.6f, 0.3f, 0.8f);
+	al::Color white = al::RGBA_f(1, 1, 1, 1);
+
+	Case cases[] = {
+		{"copy",               {ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO},               white, unscaled, al::ScaleFilter::Nearest},
+		{"premul alpha",       {},                                                      white, unscaled, al::ScaleFilter::Nearest},
+		{"premul alpha, tint", {},                                                      tint,  unscaled, al::ScaleFilter::Nearest},
+		{"additive",           {ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ONE},                 white, unscaled, al::ScaleFilter::Nearest},
+		{"subtractive",        {ALLEGRO_DEST_MINUS_SRC, ALLEGRO_ONE, ALLEGRO_ONE},      white, unscaled, al::ScaleFilter::Nearest},
+		{"multiply",           {ALLEGRO_ADD, ALLEGRO_DEST_COLOR, ALLEGRO_ZERO},         white, unscaled, al::ScaleFilter::Nearest},
+		{"flat, nearest",      {},                                                      tint,  scaled,   al::ScaleFilter::Nearest,  true},
+		{"flat, bilinear",     {},                                                      tint,  scaled,   al::ScaleFilter::Bilinear, true},
+		{"flat, multiply",     {ALLEGRO_ADD, ALLEGRO_DEST_COLOR, ALLEGRO_ZERO},         white, scaled,   al::ScaleFilter::Bilinear, true},
+		{"scaled, nearest",    {},                                                      white, scaled,   al::ScaleFilter::Nearest,  false, false},
+		{"scaled, bilinear",   {},                                                      white, scaled,   al::ScaleFilter::Bilinear, false, false}
+	};
+
+	int failures = 0;
+	std::printf("%-20s %10s %10s %8s %8s\n", "case", "allegro", "software", "speedup", "maxdiff");
+	for(const auto& c: cases) {
+		bool linear = c.filter == al::ScaleFilter::Bilinear;
+		al::Bitmap& source = c.flatSource ? (linear ? *flatLinear : flat) : (linear ? *srcLinear : src);
+		auto reset = [&]() {
+			al::ScopedTargetBitmap target(dst);
+			al::ScopedBlender copy({ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO});
+			background.draw({0, 0});
+		};
+		auto drawAllegro = [&]() {
+			al::ScopedTargetBitmap target(dst);
+			al::ScopedBlender blender(c.blender);
+			source.drawTintedScaled(c.tint, al::RectF(source.rect()), al::RectF(c.dstRect));
+		};
+		auto drawSoftware = [&]() {
+			al::SoftwareBlitOptions opt;
+			opt.blender = c.blender;
+			opt.tint = c.tint;
+			opt.filter = c.filter;
+			auto dstLock = dst.lock<al::PixelARGB8888>();
+			auto srcLock = source.lockReadOnly<al::PixelARGB8888>();
+			al::SoftwareBlit(dstLock, srcLock, source.rect(), c.dstRect, opt);
+		};
+
+		reset();
+		drawAllegro();
+		auto expected = Pixels(dst);
+		reset();
+		drawSoftware();
+		int diff = MaxChannelDifference(expected, Pixels(dst));
+		bool failed = c.checked && diff > MaxDifference;
+		failures += failed;
+
+		double tAllegro = MeasureMs(drawAllegro);
+		double tSoftware = MeasureMs(drawSoftware);
+		std::printf("%-20s %7.3f ms %7.3f ms %7.1fx %8d%s\n", c.name, tAllegro, tSoftware, tAllegro / tSoftware, diff,
+			failed ? "  FAIL" : c.checked ? "" : "  (not checked)");
+	}
+	if(failures) {
+		std::printf("%d case(s) differ from Allegro by more than %d levels\n", failures, MaxDifference);
+		return EXIT_FAILURE;
+	}
+	return 0;
+}
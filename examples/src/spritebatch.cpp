@@ -0,0 +1,83 @@
+#include <axxegro/axxegro.hpp>
+#include <random>
+#include <vector>
+
+/** @file
+ * Draws 100k rotating, tinted sprites. Press space to switch between
+ * al::SpriteBatch and one Bitmap::drawTintedScaledRotated() call per sprite,
+ * and S to switch to a static (pre-baked) batch of the initial positions.
+ */
+
+struct Sprite {
+	al::Vec2f pos;
+	float angle;
+	float spin;
+	al::Color tint;
+};
+
+int main()
+{
+	std::set_terminate(al::Terminate);
+
+	al::Display disp(1024, 768);
+	al::EventLoop loop(al::DemoEventLoopConfig);
+	auto font = al::Font::CreateBuiltinFont();
+
+	al::Bitmap logo = al::LoadBitmap("data/dvdlogo.png");
+	al::Vec2f logoCenter = al::Vec2f(logo.size()) * 0.5f;
+	al::Vec2f scale = al::Vec2f(16.0f, 16.0f) / float(logo.width());
+
+	static constexpr int NumSprites = 100'000;
+	std::mt19937 gen(1);
+	std::uniform_real_distribution<float> dist01(0.0f, 1.0f);
+	std::vector<Sprite> sprites(NumSprites);
+	for(auto& s: sprites) {
+		s.pos = {dist01(gen) * disp.width(), dist01(gen) * disp.height()};
+		s.angle = dist01(gen) * 6.28f;
+		s.spin = dist01(gen) * 4.0f - 2.0f;
+		s.tint = al::RGB_f(dist01(gen), dist01(gen), dist01(gen));
+	}
+
+	al::SpriteBatch batch;
+	for(const auto& s: sprites) {
+		batch.add(logo, al::RectF(logo.rect()), logoCenter, s.pos, scale, s.angle, s.tint);
+	}
+	al::StaticSpriteBatch staticBatch = batch.bake();
+	batch.clear();
+
+	enum class Mode {Batched, Immediate, Static} mode = Mode::Batched;
+	const char* modeNames[] = {"SpriteBatch", "immediate", "StaticSpriteBatch"};
+	loop.eventDispatcher.onKeyDown(ALLEGRO_KEY_SPACE, [&](){
+		mode = (mode == Mode::Batched) ? Mode::Immediate : Mode::Batched;
+	});
+	loop.eventDispatcher.onKeyDown(ALLEGRO_KEY_S, [&](){
+		mode = Mode::Static;
+	});
+
+	loop.run([&](){
+		al::TargetBitmap.clear();
+
+		float dt = loop.getLastTickTime();
+		for(auto& s: sprites) {
+			s.angle += s.spin * dt;
+		}
+
+		if(mode == Mode::Batched) {
+			for(const auto& s: sprites) {
+				batch.add(logo, al::RectF(logo.rect()), logoCenter, s.pos, scale, s.angle, s.tint);
+			}
+			batch.draw();
+		} else if(mode == Mode::Immediate) {
+			for(const auto& s: sprites) {
+				logo.drawTintedScaledRotated(s.tint, logoCenter, s.pos, scale, s.angle);
+			}
+		} else {
+			staticBatch.draw();
+		}
+
+		font.drawText(al::Format("%d fps, %s", (int)loop.getFPS(), modeNames[int(mode)]), al::White, {15, 15});
+		al::CurrentDisplay.flip();
+	});
+
+	return 0;
+}
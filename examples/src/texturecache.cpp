@@ -0,0 +1,83 @@
+#include <axxegro/axxegro.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+
+/*
+ * Benchmark of al::RawTextureCache: loads every PNG/JPEG in data/ with
+ * LoadBitmap (decoding each time) and through the cache (hits only, after one
+ * warm-up pass that fills it), uncompressed and LZ-compressed. Uses memory
+ * bitmaps, so no display is needed and GPU upload time is left out.
+ */
+
+namespace {
+	constexpr int Rounds = 10;
+
+	template<typename Fn>
+	double MeasureMsPerImage(const std::vector<std::string>& files, Fn&& loadFn) {
+		auto t0 = std::chrono::steady_clock::now();
+		for(int i=0; i<Rounds; i++) {
+			for(const auto& file: files) {
+				al::Bitmap bmp = loadFn(file);
+			}
+		}
+		auto t1 = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(t1 - t0).count() / double(Rounds * files.size());
+	}
+
+	uintmax_t CacheSize(const std::filesystem::path& dir) {
+		uintmax_t total = 0;
+		for(const auto& entry: std::filesystem::directory_iterator(dir)) {
+			total += entry.file_size();
+		}
+		return total;
+	}
+}
+
+int main()
+{
+	std::vector<std::string> files;
+	uintmax_t sourceSize = 0;
+	for(const auto& entry: std::filesystem::directory_iterator("data")) {
+		auto ext = entry.path().extension();
+		if(ext == ".png" || ext == ".jpg") {
+			files.push_back(entry.path().string());
+			sourceSize += entry.file_size();
+		}
+	}
+	std::printf("%zu images, %ju KiB of PNG/JPEG\n", files.size(), sourceSize / 1024);
+
+	al::ScopedNewBitmapFlags memoryBitmaps(ALLEGRO_MEMORY_BITMAP);
+
+	double cold = MeasureMsPerImage(files, [](const std::string& file) {
+		return al::LoadBitmap(file);
+	});
+	std::printf("decode:          %7.3f ms/image\n", cold);
+
+	struct {const char* name; al::RawTextureCompression compression;} modes[] = {
+		{"cache (raw):    ", al::RawTextureCompression::None},
+		{"cache (LZ):     ", al::RawTextureCompression::LZ}
+	};
+	for(const auto& mode: modes) {
+		std::filesystem::path dir = "texcache";
+		std::filesystem::remove_all(dir);
+		al::RawTextureCache cache(dir, al::PixelARGB8888::PixelFormat, mode.compression);
+		for(const auto& file: files) {
+			cache.load(file);
+		}
+		cache.resetStats();
+
+		double hit = MeasureMsPerImage(files, [&](const std::string& file) {
+			return cache.load(file);
+		});
+		std::printf(
+			"%s %7.3f ms/image (%.1fx), %ju KiB on disk, %llu hits\n",
+			mode.name, hit, cold / hit, CacheSize(dir) / 1024,
+			(unsigned long long)cache.getStats().numHits
+		);
+	}
+
+	std::filesystem::remove_all("texcache");
+	return 0;
+}
@@ -12,6 +12,8 @@
 #include "addons/video.hpp"
 #include "addons/color.hpp"
 #include "addons/video.hpp"
+#include "addons/asset.hpp"
+#include "addons/async.hpp"
 
 
 namespace al {
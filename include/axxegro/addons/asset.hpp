@@ -0,0 +1,9 @@
+#ifndef AXXEGRO_ASSET_HPP
+#define AXXEGRO_ASSET_HPP
+
+#include "asset/AssetArchive.hpp"
+#include "asset/AssetArchiveBuilder.hpp"
+#include "asset/AssetCache.hpp"
+#include "asset/RawTextureCache.hpp"
+
+#endif //AXXEGRO_ASSET_HPP
@@ -0,0 +1,71 @@
+#ifndef AXXEGRO_ARCHIVEFORMAT_HPP
+#define AXXEGRO_ARCHIVEFORMAT_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @file
+ * On-disk layout of asset archives (AssetArchive, AssetArchiveBuilder).
+ *
+ * All integers are little-endian. The file consists of:
+ *  - ArchiveHeader
+ *  - numEntries ArchiveEntryRecords
+ *  - numSlots uint32 hash slots (entry index + 1, or 0 if empty), numSlots
+ *    being a power of two; an entry is found by probing linearly from
+ *    slot (ArchiveNameHash(name) & (numSlots - 1))
+ *  - entry names, not null-terminated
+ *  - entry data, each entry aligned to ArchiveDataAlignment bytes
+ */
+
+namespace al::detail {
+
+	constexpr char ArchiveMagic[8] = {'A', 'X', 'X', 'P', 'A', 'C', 'K', 0};
+	constexpr uint32_t ArchiveVersion = 1;
+	constexpr uint64_t ArchiveDataAlignment = 16;
+
+	struct ArchiveHeader {
+		char magic[8];
+		uint32_t version;
+		uint32_t numEntries;
+		uint32_t numSlots;
+		uint32_t reserved;
+		uint64_t entriesOffset;
+		uint64_t slotsOffset;
+		uint64_t namesOffset;
+		uint64_t namesSize;
+	};
+	static_assert(sizeof(ArchiveHeader) == 56);
+
+	struct ArchiveEntryRecord {
+		uint64_t nameHash;
+		uint64_t dataOffset;
+		uint64_t dataSize;
+		uint32_t nameOffset;
+		uint32_t nameSize;
+	};
+	static_assert(sizeof(ArchiveEntryRecord) == 32);
+
+	/// FNV-1a
+	constexpr uint64_t ArchiveNameHash(std::string_view name) {
+		uint64_t h = 0xcbf29ce484222325ull;
+		for(char c: name) {
+			h ^= uint8_t(c);
+			h *= 0x100000001b3ull;
+		}
+		return h;
+	}
+
+	/// Slot count for a given number of entries: a power of two with a load factor of at most 1/2.
+	constexpr uint32_t ArchiveSlotCount(uint32_t numEntries) {
+		uint32_t n = 1;
+		while(n < numEntries * 2) {
+			n *= 2;
+		}
+		return n;
+	}
+
+}
+
+#endif //AXXEGRO_ARCHIVEFORMAT_HPP
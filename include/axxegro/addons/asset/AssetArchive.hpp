@@ -0,0 +1,211 @@
+#ifndef AXXEGRO_ASSETARCHIVE_HPP
+#define AXXEGRO_ASSETARCHIVE_HPP
+
+#include "ArchiveFormat.hpp"
+#include "../image.hpp"
+#include "../font.hpp"
+#include "../acodec.hpp"
+
+#include "../../core/File.hpp"
+#include "../../core/Config.hpp"
+#include "../../com/util/MappedFile.hpp"
+
+#include <bit>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <allegro5/allegro_ttf.h>
+
+namespace al {
+
+	/**
+	 * @brief Read-only access to an asset archive made with AssetArchiveBuilder
+	 * (or the axxpack tool).
+	 *
+	 * The archive is memory-mapped and its index is used in place, so opening
+	 * it costs the same regardless of the number of entries, and looking up an
+	 * entry by name takes constant time. Entries are exposed as memory files
+	 * over the mapping, so loaders read them without copying the data.
+	 *
+	 * Fonts loaded from an archive keep reading from it, so the archive must
+	 * outlive them. Other assets are independent of the archive once loaded.
+	 */
+	class AssetArchive {
+	public:
+		/// @throws FileError if the file can't be mapped, ArchiveError if it isn't a valid archive.
+		explicit AssetArchive(const std::string& filename)
+			: file(filename), filename(filename)
+		{
+			if constexpr(std::endian::native != std::endian::little) {
+				throw ArchiveError("Asset archives can only be read on little-endian machines");
+			}
+			if(file.size() < sizeof(header)) {
+				throw ArchiveError("\"%s\" is too small to be an asset archive", filename.c_str());
+			}
+			std::memcpy(&header, file.data(), sizeof(header));
+			if(std::memcmp(header.magic, detail::ArchiveMagic, sizeof(header.magic)) != 0) {
+				throw ArchiveError("\"%s\" is not an asset archive", filename.c_str());
+			}
+			if(header.version != detail::ArchiveVersion) {
+				throw ArchiveError("\"%s\" has unsupported archive version %u", filename.c_str(), header.version);
+			}
+			bool tablesFit =
+				isInFile(header.entriesOffset, uint64_t(header.numEntries) * sizeof(detail::ArchiveEntryRecord))
+				&& isInFile(header.slotsOffset, uint64_t(header.numSlots) * sizeof(uint32_t))
+				&& isInFile(header.namesOffset, header.namesSize);
+			if(!tablesFit || !std::has_single_bit(header.numSlots) || header.numSlots < header.numEntries) {
+				throw ArchiveError("\"%s\" has a corrupted index", filename.c_str());
+			}
+		}
+
+		/// @return The number of entries.
+		[[nodiscard]] size_t size() const {
+			return header.numEntries;
+		}
+
+		/// @return The index of the entry with the given name, or std::nullopt if there isn't one.
+		[[nodiscard]] std::optional<size_t> find(std::string_view name) const {
+			uint64_t hash = detail::ArchiveNameHash(name);
+			uint32_t mask = header.numSlots - 1;
+			for(uint32_t slot = uint32_t(hash) & mask, n = 0; n < header.numSlots; slot = (slot + 1) & mask, n++) {
+				uint32_t entryIndex = readSlot(slot);
+				if(entryIndex == 0) {
+					break;
+				}
+				if(entryIndex > header.numEntries) {
+					throw ArchiveError("\"%s\" has a corrupted index", filename.c_str());
+				}
+				detail::ArchiveEntryRecord rec = readRecord(entryIndex - 1);
+				if(rec.nameHash == hash && entryName(rec) == name) {
+					return entryIndex - 1;
+				}
+			}
+			return std::nullopt;
+		}
+
+		[[nodiscard]] bool contains(std::string_view name) const {
+			return find(name).has_value();
+		}
+
+		/// @return The name of the entry at the given index.
+		[[nodiscard]] std::string_view name(size_t index) const {
+			return entryName(readRecord(index));
+		}
+
+		/// @return The contents of the entry at the given index, pointing into the mapping.
+		[[nodiscard]] std::span<const std::byte> data(size_t index) const {
+			detail::ArchiveEntryRecord rec = readRecord(index);
+			if(!isInFile(rec.dataOffset, rec.dataSize)) {
+				throw ArchiveError("Entry #%zu of \"%s\" is out of bounds", index, filename.c_str());
+			}
+			return {file.data() + rec.dataOffset, size_t(rec.dataSize)};
+		}
+
+		/// @throws ArchiveError if there is no such entry.
+		[[nodiscard]] std::span<const std::byte> data(std::string_view name) const {
+			return data(indexOf(name));
+		}
+
+		/// @return A read-only memory file over the entry's contents.
+		[[nodiscard]] File open(std::string_view name) const {
+			return OpenSpan(data(name));
+		}
+
+		/// @brief Loads an image entry. The file type is taken from the entry name's extension.
+		[[nodiscard]] Bitmap loadBitmap(std::string_view name) const {
+			InternalRequire<ImageAddon>();
+			File f = open(name);
+			if(auto* p = al_load_bitmap_f(f.ptr(), Extension(name).c_str())) {
+				return Bitmap(p);
+			}
+			throw ResourceLoadError("Cannot load bitmap \"%.*s\" from \"%s\"", int(name.size()), name.data(), filename.c_str());
+		}
+
+		/// @brief Loads a TTF/OTF font entry. The font keeps reading from the archive.
+		[[nodiscard]] Font loadFont(std::string_view name, int size, int flags = 0) const {
+			InternalRequire<TTFAddon>();
+			std::string nameStr(name);
+			auto bytes = data(name);
+			/* the font takes ownership of the file, even if loading fails */
+			if(auto* fp = al_open_memfile(const_cast<std::byte*>(bytes.data()), int64_t(bytes.size()), "r")) {
+				if(auto* p = al_load_ttf_font_f(fp, nameStr.c_str(), size, flags)) {
+					return Font(p);
+				}
+			}
+			throw ResourceLoadError("Cannot load font \"%s\" from \"%s\"", nameStr.c_str(), filename.c_str());
+		}
+
+		/// @brief Loads an audio entry. The file type is taken from the entry name's extension.
+		[[nodiscard]] Sample loadSample(std::string_view name) const {
+			InternalRequire<AudioCodecAddon>();
+			File f = open(name);
+			if(auto* p = al_load_sample_f(f.ptr(), Extension(name).c_str())) {
+				return Sample(p);
+			}
+			throw ResourceLoadError("Cannot load sample \"%.*s\" from \"%s\"", int(name.size()), name.data(), filename.c_str());
+		}
+
+		/// @brief Loads a config entry.
+		[[nodiscard]] Config loadConfig(std::string_view name) const {
+			File f = open(name);
+			if(auto* p = al_load_config_file_f(f.ptr())) {
+				return Config(p);
+			}
+			throw ResourceLoadError("Cannot load config \"%.*s\" from \"%s\"", int(name.size()), name.data(), filename.c_str());
+		}
+
+	private:
+		[[nodiscard]] bool isInFile(uint64_t offset, uint64_t size) const {
+			return offset <= file.size() && size <= file.size() - offset;
+		}
+
+		[[nodiscard]] size_t indexOf(std::string_view name) const {
+			if(auto index = find(name)) {
+				return *index;
+			}
+			throw ArchiveError("No entry named \"%.*s\" in \"%s\"", int(name.size()), name.data(), filename.c_str());
+		}
+
+		[[nodiscard]] uint32_t readSlot(uint32_t slot) const {
+			uint32_t ret;
+			std::memcpy(&ret, file.data() + header.slotsOffset + slot * sizeof(uint32_t), sizeof(ret));
+			return ret;
+		}
+
+		[[nodiscard]] detail::ArchiveEntryRecord readRecord(size_t index) const {
+			if(index >= header.numEntries) {
+				throw OutOfRangeError("Archive entry index %zu out of range (%u entries)", index, header.numEntries);
+			}
+			detail::ArchiveEntryRecord ret;
+			std::memcpy(&ret, file.data() + header.entriesOffset + index * sizeof(ret), sizeof(ret));
+			return ret;
+		}
+
+		[[nodiscard]] std::string_view entryName(const detail::ArchiveEntryRecord& rec) const {
+			if(uint64_t(rec.nameOffset) + rec.nameSize > header.namesSize) {
+				throw ArchiveError("\"%s\" has a corrupted index", filename.c_str());
+			}
+			auto* names = reinterpret_cast<const char*>(file.data() + header.namesOffset);
+			return {names + rec.nameOffset, rec.nameSize};
+		}
+
+		static File OpenSpan(std::span<const std::byte> span) {
+			/* memfiles opened with "r" never write */
+			return File::OpenMemory(const_cast<std::byte*>(span.data()), int64_t(span.size()), "r");
+		}
+
+		static std::string Extension(std::string_view name) {
+			auto dot = name.rfind('.');
+			return dot == std::string_view::npos ? std::string() : std::string(name.substr(dot));
+		}
+
+		MappedFile file;
+		std::string filename;
+		detail::ArchiveHeader header {};
+	};
+
+}
+
+#endif //AXXEGRO_ASSETARCHIVE_HPP
@@ -0,0 +1,181 @@
+#ifndef AXXEGRO_ASSETARCHIVEBUILDER_HPP
+#define AXXEGRO_ASSETARCHIVEBUILDER_HPP
+
+#include "ArchiveFormat.hpp"
+#include "../../com/Exception.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace al {
+
+	/**
+	 * @brief Packs files into an asset archive to be read with AssetArchive.
+	 * Doesn't use Allegro, so it can run in build tools.
+	 */
+	class AssetArchiveBuilder {
+	public:
+		/**
+		 * @brief Adds a file from disk, read when the archive is written.
+		 * @param name The entry name. Defaults to the path with '/' separators.
+		 * @throws ArchiveError if an entry with this name was already added.
+		 */
+		void addFile(const std::filesystem::path& path, std::string name = {}) {
+			if(name.empty()) {
+				name = NormalizeName(path.generic_string());
+			}
+			addEntry(std::move(name), path, {});
+		}
+
+		/// @brief Adds an entry with the given contents.
+		void addData(std::string name, std::vector<std::byte> data) {
+			addEntry(NormalizeName(name), {}, std::move(data));
+		}
+
+		/**
+		 * @brief Adds all regular files under a directory, recursively. Entries
+		 * are named by their path relative to the directory, prefixed with `prefix`.
+		 * @return The number of files added.
+		 */
+		size_t addDirectory(const std::filesystem::path& dir, const std::string& prefix = {}) {
+			std::vector<std::filesystem::path> files;
+			for(const auto& dirEntry: std::filesystem::recursive_directory_iterator(dir)) {
+				if(dirEntry.is_regular_file()) {
+					files.push_back(dirEntry.path());
+				}
+			}
+			/* directory order is unspecified; keep archives reproducible */
+			std::sort(files.begin(), files.end());
+			for(const auto& file: files) {
+				addFile(file, prefix + std::filesystem::relative(file, dir).generic_string());
+			}
+			return files.size();
+		}
+
+		[[nodiscard]] size_t size() const {
+			return entries.size();
+		}
+
+		/// @throws FileError if an input file can't be read or the output can't be written.
+		void write(const std::filesystem::path& outFilename) const {
+			if constexpr(std::endian::native != std::endian::little) {
+				throw ArchiveError("Asset archives can only be written on little-endian machines");
+			}
+			if(entries.size() > UINT32_MAX / 2) {
+				throw ArchiveError("Too many entries (%zu)", entries.size());
+			}
+
+			detail::ArchiveHeader header {};
+			std::memcpy(header.magic, detail::ArchiveMagic, sizeof(header.magic));
+			header.version = detail::ArchiveVersion;
+			header.numEntries = uint32_t(entries.size());
+			header.numSlots = detail::ArchiveSlotCount(header.numEntries);
+
+			std::vector<detail::ArchiveEntryRecord> records(entries.size());
+			std::vector<uint32_t> slots(header.numSlots, 0);
+			std::string names;
+			for(size_t i=0; i<entries.size(); i++) {
+				auto& rec = records[i];
+				rec.nameHash = detail::ArchiveNameHash(entries[i].name);
+				rec.nameOffset = uint32_t(names.size());
+				rec.nameSize = uint32_t(entries[i].name.size());
+				names += entries[i].name;
+
+				uint32_t slot = uint32_t(rec.nameHash) & (header.numSlots - 1);
+				while(slots[slot]) {
+					slot = (slot + 1) & (header.numSlots - 1);
+				}
+				slots[slot] = uint32_t(i + 1);
+			}
+
+			header.entriesOffset = sizeof(header);
+			header.slotsOffset = header.entriesOffset + records.size() * sizeof(detail::ArchiveEntryRecord);
+			header.namesOffset = header.slotsOffset + slots.size() * sizeof(uint32_t);
+			header.namesSize = names.size();
+
+			std::ofstream out(outFilename, std::ios::binary);
+			if(!out) {
+				throw FileError("Cannot open \"%s\" for writing", outFilename.string().c_str());
+			}
+
+			/* data first, so that each entry is read only once; the tables are patched in afterwards */
+			uint64_t offset = header.namesOffset + header.namesSize;
+			out.seekp(std::streamoff(offset));
+			std::vector<std::byte> buffer;
+			for(size_t i=0; i<entries.size(); i++) {
+				uint64_t aligned = AlignUp(offset);
+				WritePadding(out, aligned - offset);
+				const std::vector<std::byte>& data = entries[i].path.empty() ? entries[i].data : ReadFile(entries[i].path, buffer);
+				out.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+				records[i].dataOffset = aligned;
+				records[i].dataSize = data.size();
+				offset = aligned + data.size();
+			}
+
+			out.seekp(0);
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size() * sizeof(records[0])));
+			out.write(reinterpret_cast<const char*>(slots.data()), std::streamsize(slots.size() * sizeof(slots[0])));
+			out.write(names.data(), std::streamsize(names.size()));
+			if(!out.flush()) {
+				throw FileError("Cannot write to \"%s\"", outFilename.string().c_str());
+			}
+		}
+
+	private:
+		struct Entry {
+			std::string name;
+			std::filesystem::path path;
+			std::vector<std::byte> data;
+		};
+
+		void addEntry(std::string name, std::filesystem::path path, std::vector<std::byte> data) {
+			if(!names.insert(name).second) {
+				throw ArchiveError("Duplicate archive entry \"%s\"", name.c_str());
+			}
+			entries.push_back({std::move(name), std::move(path), std::move(data)});
+		}
+
+		static std::string NormalizeName(std::string name) {
+			std::replace(name.begin(), name.end(), '\\', '/');
+			while(name.starts_with("./")) {
+				name.erase(0, 2);
+			}
+			return name;
+		}
+
+		static uint64_t AlignUp(uint64_t offset) {
+			return (offset + detail::ArchiveDataAlignment - 1) & ~(detail::ArchiveDataAlignment - 1);
+		}
+
+		static void WritePadding(std::ofstream& out, uint64_t n) {
+			static constexpr char zeros[detail::ArchiveDataAlignment] = {};
+			out.write(zeros, std::streamsize(n));
+		}
+
+		static const std::vector<std::byte>& ReadFile(const std::filesystem::path& path, std::vector<std::byte>& buffer) {
+			std::ifstream in(path, std::ios::binary);
+			std::error_code ec;
+			auto size = std::filesystem::file_size(path, ec);
+			if(!in || ec) {
+				throw FileError("Cannot read \"%s\"", path.string().c_str());
+			}
+			buffer.resize(size);
+			if(!in.read(reinterpret_cast<char*>(buffer.data()), std::streamsize(size))) {
+				throw FileError("Cannot read \"%s\"", path.string().c_str());
+			}
+			return buffer;
+		}
+
+		std::vector<Entry> entries;
+		std::unordered_set<std::string> names;
+	};
+
+}
+
+#endif //AXXEGRO_ASSETARCHIVEBUILDER_HPP
@@ -0,0 +1,249 @@
+#ifndef AXXEGRO_ASSETCACHE_HPP
+#define AXXEGRO_ASSETCACHE_HPP
+
+#include "../image.hpp"
+#include "../font.hpp"
+#include "../acodec.hpp"
+
+#include <filesystem>
+#include <limits>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @file
+ * A cache of bitmaps, fonts and samples loaded from files
+ */
+
+namespace al {
+
+	/**
+	 * @brief A shared reference to a cached asset. The asset stays alive while
+	 * any handle to it exists, even after the cache has evicted it.
+	 */
+	template<typename T>
+	using AssetHandle = std::shared_ptr<T>;
+
+	/// @brief Estimated memory taken by an asset, in bytes.
+	struct AssetMemoryUsage {
+		size_t gpuBytes = 0;
+		size_t cpuBytes = 0;
+
+		[[nodiscard]] size_t total() const {
+			return gpuBytes + cpuBytes;
+		}
+	};
+
+	struct AssetCacheStats {
+		uint64_t numHits = 0;
+		uint64_t numMisses = 0;
+		uint64_t numEvictions = 0;
+
+		size_t numAssets = 0;
+		size_t numReferenced = 0;
+		AssetMemoryUsage usage;
+	};
+
+	/// @return Size of the pixel data: video memory for video bitmaps, system memory for memory bitmaps.
+	inline AssetMemoryUsage EstimateMemoryUsage(const Bitmap& bitmap) {
+		size_t bytes = PixelFormat(bitmap.getFormat()).dataSize(bitmap.size());
+		if(bitmap.getFlags() & ALLEGRO_MEMORY_BITMAP) {
+			return {.cpuBytes = bytes};
+		}
+		return {.gpuBytes = bytes};
+	}
+
+	/// @return Size of the sample data.
+	inline AssetMemoryUsage EstimateMemoryUsage(const Sample& sample) {
+		return {.cpuBytes = size_t(sample.getLength()) * GetChannelCount(sample.getChannelConf()) * GetAudioDepthBytes(sample.getDepth())};
+	}
+
+	/**
+	 * @brief Caches bitmaps, fonts and samples by file name and load parameters.
+	 *
+	 * Repeated requests for the same asset return handles to one shared copy.
+	 * When the estimated memory usage exceeds the GPU or CPU budget, the least
+	 * recently requested assets that nobody else holds a handle to are evicted,
+	 * until the usage fits again or only referenced assets are left.
+	 *
+	 * Eviction runs whenever an asset is loaded. Releasing handles doesn't
+	 * trigger it, so call trim() after dropping a lot of them (e.g. when
+	 * a level is unloaded).
+	 *
+	 * Not thread-safe. Use it on the display thread, like the loaders it calls.
+	 */
+	class AssetCache {
+	public:
+		static constexpr size_t Unlimited = std::numeric_limits<size_t>::max();
+
+		explicit AssetCache(size_t gpuBudget = Unlimited, size_t cpuBudget = Unlimited)
+			: gpuBudget(gpuBudget), cpuBudget(cpuBudget)
+		{}
+
+		AssetCache(const AssetCache&) = delete;
+		AssetCache& operator=(const AssetCache&) = delete;
+
+		/**
+		 * @brief Gets a bitmap loaded with LoadBitmap(). The current new bitmap
+		 * flags and format are part of the key, so a memory and a video
+		 * bitmap of the same file are cached separately.
+		 */
+		AssetHandle<Bitmap> getBitmap(const std::string& filename) {
+			std::string key = Format("bitmap:%d:%d:%s", Bitmap::GetNewBitmapFlags(), Bitmap::GetNewBitmapFormat(), filename.c_str());
+			return getOrLoad<Bitmap>(key, [&]() {
+				auto bmp = std::make_shared<Bitmap>(LoadBitmap(filename));
+				AssetMemoryUsage usage = EstimateMemoryUsage(*bmp);
+				return std::make_pair(std::move(bmp), usage);
+			});
+		}
+
+		/**
+		 * @brief Gets a font loaded with Font(filename, size, flags). Its estimated
+		 * size is the size of the file; glyph caches are not counted.
+		 */
+		AssetHandle<Font> getFont(const std::string& filename, int size, int flags = 0) {
+			std::string key = Format("font:%d:%d:%s", size, flags, filename.c_str());
+			return getOrLoad<Font>(key, [&]() {
+				auto font = std::make_shared<Font>(filename, size, flags);
+				std::error_code ec;
+				auto fileSize = std::filesystem::file_size(filename, ec);
+				AssetMemoryUsage usage {.cpuBytes = ec ? 0 : size_t(fileSize)};
+				return std::make_pair(std::move(font), usage);
+			});
+		}
+
+		/// @brief Gets a sample loaded with LoadSample().
+		AssetHandle<Sample> getSample(const std::string& filename) {
+			std::string key = Format("sample:%s", filename.c_str());
+			return getOrLoad<Sample>(key, [&]() {
+				auto sample = std::make_shared<Sample>(LoadSample(filename));
+				AssetMemoryUsage usage = EstimateMemoryUsage(*sample);
+				return std::make_pair(std::move(sample), usage);
+			});
+		}
+
+		void setGPUBudget(size_t bytes) {
+			gpuBudget = bytes;
+			trim();
+		}
+
+		void setCPUBudget(size_t bytes) {
+			cpuBudget = bytes;
+			trim();
+		}
+
+		[[nodiscard]] size_t getGPUBudget() const {
+			return gpuBudget;
+		}
+
+		[[nodiscard]] size_t getCPUBudget() const {
+			return cpuBudget;
+		}
+
+		/// @brief Evicts unreferenced assets, least recently used first, until the usage fits the budgets.
+		void trim() {
+			for(auto it = lru.end(); it != lru.begin() && isOverBudget(); ) {
+				--it;
+				if(isReferenced(*it) || !isOverBudgetIn(it->usage)) {
+					continue;
+				}
+				it = evict(it);
+			}
+		}
+
+		/// @brief Evicts all unreferenced assets.
+		void evictUnused() {
+			for(auto it = lru.begin(); it != lru.end(); ) {
+				if(isReferenced(*it)) {
+					++it;
+				} else {
+					it = evict(it);
+				}
+			}
+		}
+
+		/// @brief Forgets all assets. Outstanding handles stay valid.
+		void clear() {
+			stats.numEvictions += lru.size();
+			lru.clear();
+			index.clear();
+			stats.usage = {};
+		}
+
+		[[nodiscard]] AssetCacheStats getStats() const {
+			AssetCacheStats ret = stats;
+			ret.numAssets = lru.size();
+			for(const auto& entry: lru) {
+				ret.numReferenced += isReferenced(entry);
+			}
+			return ret;
+		}
+
+		/// @brief Zeroes the hit, miss and eviction counters.
+		void resetCounters() {
+			stats.numHits = stats.numMisses = stats.numEvictions = 0;
+		}
+
+	private:
+		struct Entry {
+			std::string key;
+			std::shared_ptr<void> asset;
+			AssetMemoryUsage usage;
+		};
+		using EntryList = std::list<Entry>;
+
+		template<typename T, typename LoadFn>
+		AssetHandle<T> getOrLoad(const std::string& key, LoadFn&& load) {
+			if(auto it = index.find(key); it != index.end()) {
+				stats.numHits++;
+				lru.splice(lru.begin(), lru, it->second);
+				return std::static_pointer_cast<T>(it->second->asset);
+			}
+
+			stats.numMisses++;
+			auto [asset, usage] = load();
+			lru.push_front(Entry{.key = key, .asset = asset, .usage = usage});
+			index.emplace(key, lru.begin());
+			stats.usage.gpuBytes += usage.gpuBytes;
+			stats.usage.cpuBytes += usage.cpuBytes;
+
+			/* the new asset is referenced by the caller's handle, so it survives this */
+			trim();
+			return asset;
+		}
+
+		EntryList::iterator evict(EntryList::iterator it) {
+			stats.usage.gpuBytes -= it->usage.gpuBytes;
+			stats.usage.cpuBytes -= it->usage.cpuBytes;
+			stats.numEvictions++;
+			index.erase(it->key);
+			return lru.erase(it);
+		}
+
+		[[nodiscard]] static bool isReferenced(const Entry& entry) {
+			return entry.asset.use_count() > 1;
+		}
+
+		[[nodiscard]] bool isOverBudget() const {
+			return stats.usage.gpuBytes > gpuBudget || stats.usage.cpuBytes > cpuBudget;
+		}
+
+		/* whether evicting an asset of this usage helps with the budget that is exceeded */
+		[[nodiscard]] bool isOverBudgetIn(const AssetMemoryUsage& usage) const {
+			return (usage.gpuBytes && stats.usage.gpuBytes > gpuBudget)
+				|| (usage.cpuBytes && stats.usage.cpuBytes > cpuBudget);
+		}
+
+		/* most recently used first */
+		EntryList lru;
+		std::unordered_map<std::string, EntryList::iterator> index;
+		size_t gpuBudget;
+		size_t cpuBudget;
+		AssetCacheStats stats;
+	};
+
+}
+
+#endif //AXXEGRO_ASSETCACHE_HPP
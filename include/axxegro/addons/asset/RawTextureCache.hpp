@@ -0,0 +1,315 @@
+#ifndef AXXEGRO_RAWTEXTURECACHE_HPP
+#define AXXEGRO_RAWTEXTURECACHE_HPP
+
+#include "../image.hpp"
+
+#include "../../core/File.hpp"
+#include "../../core/gfx/Pixel.hpp"
+#include "../../com/util/Compression.hpp"
+#include "../../com/util/Hash.hpp"
+#include "../../com/util/MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @file
+ * An on-disk cache of decoded images
+ */
+
+namespace al {
+
+	enum class RawTextureCompression: uint32_t {
+		None = 0,
+		LZ = 1 ///< CompressLZ(): typically 2-4x smaller, decompresses at memory speed
+	};
+
+	struct RawTextureCacheStats {
+		uint64_t numHits = 0;
+		uint64_t numMisses = 0;
+		uint64_t numWriteErrors = 0;
+	};
+
+	namespace detail {
+		constexpr char RawTextureMagic[8] = {'A', 'X', 'X', 'R', 'A', 'W', 'T', 0};
+		constexpr uint32_t RawTextureVersion = 1;
+
+		struct RawTextureHeader {
+			char magic[8];
+			uint32_t version;
+			uint32_t format;
+			uint32_t width;
+			uint32_t height;
+			uint32_t compression;
+			uint32_t reserved;
+			uint64_t sourceHash;
+			uint64_t sourceSize;
+			uint64_t payloadSize;
+		};
+		static_assert(sizeof(RawTextureHeader) == 56);
+	}
+
+	/**
+	 * @brief Loads images through an on-disk cache of their decoded pixels.
+	 *
+	 * The first load() of an image decodes it as usual and stores the pixels in
+	 * the cache directory, in a fixed pixel format and optionally compressed.
+	 * Later loads of a file with the same contents skip decoding: the cached
+	 * pixels are mapped into memory and written straight into a write-only lock
+	 * of the new bitmap. Cache files are named after a hash of the source file's
+	 * contents, so edited images are decoded again.
+	 *
+	 * Bitmaps are created with the current new bitmap flags and the cache's
+	 * pixel format. Use a format that the GPU takes as is (the default,
+	 * ARGB_8888, matching PixelARGB8888) so locking doesn't convert pixels.
+	 *
+	 * Not thread-safe. Stale cache files are never deleted automatically; see clear().
+	 */
+	class RawTextureCache {
+	public:
+		static constexpr const char* FileExtension = ".axtex";
+
+		/**
+		 * @param directory Where cache files are stored. Created if it doesn't exist.
+		 * @param format A concrete (not ANY_*), uncompressed pixel format.
+		 * @throws FileError if the directory can't be created.
+		 */
+		explicit RawTextureCache(
+			std::filesystem::path directory,
+			ALLEGRO_PIXEL_FORMAT format = PixelARGB8888::PixelFormat,
+			RawTextureCompression compression = RawTextureCompression::LZ
+		)
+			: directory(std::move(directory)), format(format), compression(compression)
+		{
+			pixelSize = al_get_pixel_size(format);
+			if(pixelSize <= 0 || al_get_pixel_block_width(format) != 1 || format <= ALLEGRO_PIXEL_FORMAT_ANY_32_WITH_ALPHA) {
+				throw Exception("Pixel format %d cannot be used in a raw texture cache", int(format));
+			}
+			std::error_code ec;
+			std::filesystem::create_directories(this->directory, ec);
+			if(ec) {
+				throw FileError("Cannot create cache directory \"%s\": %s", this->directory.string().c_str(), ec.message().c_str());
+			}
+		}
+
+		/**
+		 * @brief Loads an image, from the cache if possible.
+		 * @throws FileError if the file can't be read, ResourceLoadError if it can't be decoded.
+		 */
+		Bitmap load(const std::string& filename) {
+			MappedFile source(filename);
+			uint64_t hash = HashBytes64(source.bytes());
+
+			std::filesystem::path path = cachePath(hash);
+			if(auto bmp = tryLoadCached(path, hash, source.size())) {
+				stats.numHits++;
+				return std::move(*bmp);
+			}
+			stats.numMisses++;
+
+			std::vector<std::byte> pixels;
+			Vec2i size = decode(source, filename, pixels);
+			try {
+				store(path, hash, source.size(), size, pixels);
+			} catch(const FileError&) {
+				/* the cache is an optimization; a read-only disk shouldn't break loading */
+				stats.numWriteErrors++;
+			}
+			return createBitmap(size, pixels);
+		}
+
+		/// @return The path of the cache file for a source file with the given content hash.
+		[[nodiscard]] std::filesystem::path cachePath(uint64_t sourceHash) const {
+			return directory / Format("%016llx_%d%s", (unsigned long long)sourceHash, int(format), FileExtension);
+		}
+
+		/// @brief Deletes all cache files in the directory.
+		void clear() {
+			std::error_code ec;
+			for(const auto& entry: std::filesystem::directory_iterator(directory, ec)) {
+				if(entry.path().extension() == FileExtension) {
+					std::filesystem::remove(entry.path(), ec);
+				}
+			}
+		}
+
+		[[nodiscard]] RawTextureCacheStats getStats() const {
+			return stats;
+		}
+
+		void resetStats() {
+			stats = {};
+		}
+
+	private:
+		/* pixels holds tightly packed rows */
+		Bitmap createBitmap(Vec2i size, std::span<const std::byte> pixels) {
+			ScopedNewBitmapFormat newFormat(format);
+			Bitmap bmp(size.x, size.y);
+			size_t rowBytes = size_t(size.x) * pixelSize;
+			{
+				auto lock = bmp.lockDynamic(format, ALLEGRO_LOCK_WRITEONLY);
+				for(int y=0; y<size.y; y++) {
+					std::memcpy(lock.rawRowData(y), pixels.data() + y * rowBytes, rowBytes);
+				}
+			}
+			return bmp;
+		}
+
+		/* decompresses straight into the lock unless its rows are padded */
+		std::optional<Bitmap> createBitmapLZ(Vec2i size, std::span<const std::byte> payload) {
+			ScopedNewBitmapFormat newFormat(format);
+			Bitmap bmp(size.x, size.y);
+			size_t rowBytes = size_t(size.x) * pixelSize;
+			{
+				auto lock = bmp.lockDynamic(format, ALLEGRO_LOCK_WRITEONLY);
+				int pitch = lock.getPitch();
+				if(size_t(std::abs(pitch)) == rowBytes) {
+					/* with a negative pitch (OpenGL) the rows are stored bottom-up */
+					bool bottomUp = pitch < 0;
+					auto* base = static_cast<std::byte*>(lock.rawRowData(bottomUp ? size.y - 1 : 0));
+					if(!DecompressLZ(payload, std::span(base, rowBytes * size.y))) {
+						return std::nullopt;
+					}
+					if(bottomUp) {
+						for(int y=0; y<size.y/2; y++) {
+							std::byte* top = base + size_t(y) * rowBytes;
+							std::swap_ranges(top, top + rowBytes, base + size_t(size.y - 1 - y) * rowBytes);
+						}
+					}
+				} else {
+					scratch.resize(rowBytes * size.y);
+					if(!DecompressLZ(payload, scratch)) {
+						return std::nullopt;
+					}
+					for(int y=0; y<size.y; y++) {
+						std::memcpy(lock.rawRowData(y), scratch.data() + y * rowBytes, rowBytes);
+					}
+				}
+			}
+			return bmp;
+		}
+
+		std::optional<Bitmap> tryLoadCached(const std::filesystem::path& path, uint64_t sourceHash, uint64_t sourceSize) {
+			std::error_code ec;
+			if(!std::filesystem::exists(path, ec)) {
+				return std::nullopt;
+			}
+			std::optional<MappedFile> cached;
+			try {
+				cached.emplace(path.string());
+			} catch(const FileError&) {
+				return std::nullopt;
+			}
+
+			detail::RawTextureHeader header;
+			if(cached->size() < sizeof(header)) {
+				return std::nullopt;
+			}
+			std::memcpy(&header, cached->data(), sizeof(header));
+			std::span<const std::byte> payload = cached->bytes().subspan(sizeof(header));
+			uint64_t rawSize = uint64_t(header.width) * header.height * pixelSize;
+
+			bool valid = std::memcmp(header.magic, detail::RawTextureMagic, sizeof(header.magic)) == 0
+				&& header.version == detail::RawTextureVersion
+				&& header.format == uint32_t(format)
+				&& header.sourceHash == sourceHash
+				&& header.sourceSize == sourceSize
+				&& header.payloadSize == payload.size()
+				&& header.width > 0 && header.width <= INT32_MAX
+				&& header.height > 0 && header.height <= INT32_MAX;
+			if(!valid) {
+				return std::nullopt;
+			}
+
+			Vec2i size(int(header.width), int(header.height));
+			switch(RawTextureCompression(header.compression)) {
+				case RawTextureCompression::None:
+					if(payload.size() != rawSize) {
+						return std::nullopt;
+					}
+					return createBitmap(size, payload);
+				case RawTextureCompression::LZ:
+					return createBitmapLZ(size, payload);
+				default:
+					return std::nullopt;
+			}
+		}
+
+		Vec2i decode(const MappedFile& source, const std::string& filename, std::vector<std::byte>& pixels) {
+			InternalRequire<ImageAddon>();
+			auto ext = std::filesystem::path(filename).extension().string();
+			Bitmap decoded = [&]() {
+				ScopedNewBitmapFlags newFlags(ALLEGRO_MEMORY_BITMAP);
+				ScopedNewBitmapFormat newFormat(format);
+				File f = File::OpenMemory(const_cast<std::byte*>(source.data()), int64_t(source.size()), "r");
+				if(auto* p = al_load_bitmap_f(f.ptr(), ext.c_str())) {
+					return Bitmap(p);
+				}
+				throw ResourceLoadError("Cannot load bitmap from file \"%s\"", filename.c_str());
+			}();
+
+			Vec2i size = decoded.size();
+			size_t rowBytes = size_t(size.x) * pixelSize;
+			pixels.resize(rowBytes * size.y);
+			auto lock = decoded.lockDynamic(format, ALLEGRO_LOCK_READONLY);
+			for(int y=0; y<size.y; y++) {
+				std::memcpy(pixels.data() + y * rowBytes, lock.rawRowData(y), rowBytes);
+			}
+			return size;
+		}
+
+		void store(const std::filesystem::path& path, uint64_t sourceHash, uint64_t sourceSize, Vec2i size, const std::vector<std::byte>& pixels) {
+			std::vector<std::byte> compressed;
+			std::span<const std::byte> payload = pixels;
+			if(compression == RawTextureCompression::LZ) {
+				compressed = CompressLZ(pixels);
+				payload = compressed;
+			}
+
+			detail::RawTextureHeader header {};
+			std::memcpy(header.magic, detail::RawTextureMagic, sizeof(header.magic));
+			header.version = detail::RawTextureVersion;
+			header.format = uint32_t(format);
+			header.width = uint32_t(size.x);
+			header.height = uint32_t(size.y);
+			header.compression = uint32_t(compression);
+			header.sourceHash = sourceHash;
+			header.sourceSize = sourceSize;
+			header.payloadSize = payload.size();
+
+			/* write to a temporary file first so that readers never see half a file */
+			std::filesystem::path tmpPath = path;
+			tmpPath += ".tmp";
+			{
+				std::ofstream out(tmpPath, std::ios::binary);
+				out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				out.write(reinterpret_cast<const char*>(payload.data()), std::streamsize(payload.size()));
+				if(!out.flush()) {
+					throw FileError("Cannot write \"%s\"", tmpPath.string().c_str());
+				}
+			}
+			std::error_code ec;
+			std::filesystem::rename(tmpPath, path, ec);
+			if(ec) {
+				std::filesystem::remove(tmpPath, ec);
+				throw FileError("Cannot write \"%s\"", path.string().c_str());
+			}
+		}
+
+		std::filesystem::path directory;
+		ALLEGRO_PIXEL_FORMAT format;
+		RawTextureCompression compression;
+		int pixelSize;
+		std::vector<std::byte> scratch;
+		RawTextureCacheStats stats;
+	};
+
+}
+
+#endif //AXXEGRO_RAWTEXTURECACHE_HPP
@@ -0,0 +1,6 @@
+#ifndef AXXEGRO_ASYNC_HPP
+#define AXXEGRO_ASYNC_HPP
+
+#include "async/AsyncLoader.hpp"
+
+#endif //AXXEGRO_ASYNC_HPP
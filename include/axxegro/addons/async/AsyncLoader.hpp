@@ -0,0 +1,326 @@
+#ifndef AXXEGRO_ASYNCLOADER_HPP
+#define AXXEGRO_ASYNCLOADER_HPP
+
+#include "../image.hpp"
+#include "../font.hpp"
+#include "../acodec.hpp"
+
+#include "../../core/event/UserEvent.hpp"
+#include "../../core/time/Time.hpp"
+#include "../../com/util/ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * Loading bitmaps, fonts and samples in the background
+ */
+
+namespace al {
+
+	using AsyncLoadID = uint64_t;
+
+	/**
+	 * @brief Emitted by AsyncLoader when a request has finished.
+	 * On failure, `asset` is null and `error` says why.
+	 */
+	template<typename T>
+	struct AssetLoadedEvent {
+		AsyncLoadID id;
+		std::string filename;
+		std::shared_ptr<T> asset;
+		std::string error;
+
+		[[nodiscard]] bool ok() const {
+			return asset != nullptr;
+		}
+	};
+
+	namespace detail {
+		class AsyncLoadJob {
+		public:
+			AsyncLoadJob(AsyncLoadID id, int priority, std::string filename)
+				: id(id), priority(priority), filename(std::move(filename))
+			{}
+			virtual ~AsyncLoadJob() = default;
+
+			/* worker thread */
+			virtual void load() = 0;
+
+			/* display thread; returns false if nothing was emitted */
+			virtual bool finish(UserEventSource& eventSource, int videoBitmapFlags) = 0;
+
+			const AsyncLoadID id;
+			const int priority;
+			const std::string filename;
+			std::atomic<bool> cancelled = false;
+		};
+
+		template<typename T>
+		class TypedAsyncLoadJob: public AsyncLoadJob {
+		public:
+			TypedAsyncLoadJob(AsyncLoadID id, int priority, std::string filename, std::function<std::unique_ptr<T>()> loadFn)
+				: AsyncLoadJob(id, priority, std::move(filename)), loadFn(std::move(loadFn))
+			{}
+
+			void load() override {
+				try {
+					asset = loadFn();
+				} catch(const std::exception& e) {
+					error = e.what();
+				}
+			}
+
+			bool finish(UserEventSource& eventSource, int videoBitmapFlags) override {
+				if constexpr(std::is_same_v<T, Bitmap>) {
+					if(asset) {
+						/* decoded into a memory bitmap on the worker; upload it now */
+						ScopedNewBitmapFlags flags(videoBitmapFlags);
+						al_convert_bitmap(asset->ptr());
+					}
+				}
+				return eventSource.emitEvent(AssetLoadedEvent<T>{
+					.id = id,
+					.filename = filename,
+					.asset = std::move(asset),
+					.error = std::move(error)
+				});
+			}
+
+		private:
+			std::function<std::unique_ptr<T>()> loadFn;
+			std::shared_ptr<T> asset;
+			std::string error;
+		};
+
+		struct AsyncJobOrder {
+			/* highest priority first, then first come first served */
+			bool operator()(const std::shared_ptr<AsyncLoadJob>& a, const std::shared_ptr<AsyncLoadJob>& b) const {
+				if(a->priority != b->priority) {
+					return a->priority < b->priority;
+				}
+				return a->id > b->id;
+			}
+		};
+	}
+
+	/**
+	 * @brief Loads bitmaps, fonts and samples on worker threads.
+	 *
+	 * Files are decoded on the loader's own thread pool. Bitmaps are decoded
+	 * into memory bitmaps and uploaded to video memory by update(), which must be
+	 * called regularly (e.g. once per frame) on the display thread and spends
+	 * at most about `budget` seconds per call. When a request is done, update()
+	 * emits an AssetLoadedEvent<Bitmap>, AssetLoadedEvent<Font> or
+	 * AssetLoadedEvent<Sample> from getEventSource(), to be handled with
+	 * EventDispatcher::setUserEventHandler().
+	 *
+	 * Uploads use the new bitmap flags that were current when the loader was
+	 * created. Fonts are loaded with these flags too, so TTF glyph pages are
+	 * created as video bitmaps when text is first drawn; fonts grabbed from
+	 * image files end up as memory bitmaps, which
+	 * CurrentDisplay.convertMemoryBitmaps() takes care of.
+	 *
+	 * Higher priorities are started first. Cancelled requests emit no event.
+	 * Requests that are still queued or running when the loader is destroyed
+	 * are dropped.
+	 */
+	class AsyncLoader {
+	public:
+		/// @param numWorkers Loader threads. Loading is mostly I/O and decoding, so a few are enough.
+		explicit AsyncLoader(unsigned numWorkers = 2)
+			: state(std::make_shared<State>()),
+			  videoBitmapFlags(Bitmap::GetNewBitmapFlags()),
+			  pool(std::max(numWorkers, 1u))
+		{}
+
+		~AsyncLoader() {
+			std::lock_guard lk(state->mtx);
+			state->closed = true;
+		}
+
+		AsyncLoader(const AsyncLoader&) = delete;
+		AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+		/// @brief Queues an image file for loading as a video bitmap.
+		AsyncLoadID loadBitmap(const std::string& filename, int priority = 0) {
+			InternalRequire<ImageAddon>();
+			return enqueue<Bitmap>(filename, priority, [filename]() {
+				ScopedNewBitmapFlags flags(ALLEGRO_MEMORY_BITMAP);
+				return std::make_unique<Bitmap>(LoadBitmap(filename));
+			});
+		}
+
+		/// @brief Queues a font file for loading, with the arguments of Font(filename, size, flags).
+		AsyncLoadID loadFont(const std::string& filename, int size, int fontFlags = 0, int priority = 0) {
+			InternalRequire<TTFAddon>();
+			return enqueue<Font>(filename, priority, [filename, size, fontFlags, bmpFlags = videoBitmapFlags]() {
+				ScopedNewBitmapFlags flags(bmpFlags);
+				return std::make_unique<Font>(filename, size, fontFlags);
+			});
+		}
+
+		/// @brief Queues an audio file for loading as a sample.
+		AsyncLoadID loadSample(const std::string& filename, int priority = 0) {
+			InternalRequire<AudioCodecAddon>();
+			return enqueue<Sample>(filename, priority, [filename]() {
+				return std::make_unique<Sample>(LoadSample(filename));
+			});
+		}
+
+		/**
+		 * @brief Cancels a request. It will not emit an event. A file that is
+		 * already being decoded is decoded to the end and then thrown away.
+		 * @return false if the request has already finished or doesn't exist.
+		 */
+		bool cancel(AsyncLoadID id) {
+			std::lock_guard lk(state->mtx);
+			auto it = state->active.find(id);
+			if(it == state->active.end()) {
+				return false;
+			}
+			it->second->cancelled = true;
+			state->active.erase(it);
+			return true;
+		}
+
+		/// @brief Cancels all requests.
+		void cancelAll() {
+			std::lock_guard lk(state->mtx);
+			for(auto& [id, job]: state->active) {
+				job->cancelled = true;
+			}
+			state->active.clear();
+		}
+
+		/**
+		 * @brief Finishes loaded requests (uploading bitmaps) and emits their
+		 * events, highest priority first, until `budget` seconds have passed.
+		 * At least one request is finished per call if one is ready.
+		 * Must be called on the display thread.
+		 * @return The number of events emitted.
+		 */
+		size_t update(double budget = 0.002) {
+			double t0 = GetTime();
+			{
+				std::lock_guard lk(state->mtx);
+				for(auto& job: state->loaded) {
+					ready.push(std::move(job));
+				}
+				state->loaded.clear();
+			}
+
+			size_t numEmitted = 0;
+			while(!ready.empty()) {
+				if(numEmitted > 0 && GetTime() - t0 >= budget) {
+					break;
+				}
+				std::shared_ptr<detail::AsyncLoadJob> job = ready.top();
+				ready.pop();
+				if(!retire(*job)) {
+					continue;
+				}
+				if(job->finish(eventSource, videoBitmapFlags)) {
+					numEmitted++;
+				}
+			}
+			return numEmitted;
+		}
+
+		/// @return The number of requests that haven't emitted their event yet and haven't been cancelled.
+		[[nodiscard]] size_t numActive() const {
+			std::lock_guard lk(state->mtx);
+			return state->active.size();
+		}
+
+		[[nodiscard]] UserEventSource& getEventSource() {
+			return eventSource;
+		}
+
+	private:
+		struct State {
+			mutable std::mutex mtx;
+			std::priority_queue<
+				std::shared_ptr<detail::AsyncLoadJob>,
+				std::vector<std::shared_ptr<detail::AsyncLoadJob>>,
+				detail::AsyncJobOrder
+			> pending;
+			std::vector<std::shared_ptr<detail::AsyncLoadJob>> loaded;
+			std::unordered_map<AsyncLoadID, std::shared_ptr<detail::AsyncLoadJob>> active;
+			AsyncLoadID nextID = 1;
+			bool closed = false;
+		};
+
+		template<typename T, typename Fn>
+		AsyncLoadID enqueue(const std::string& filename, int priority, Fn&& loadFn) {
+			AsyncLoadID id;
+			{
+				std::lock_guard lk(state->mtx);
+				id = state->nextID++;
+				auto job = std::make_shared<detail::TypedAsyncLoadJob<T>>(id, priority, filename, std::forward<Fn>(loadFn));
+				state->pending.push(job);
+				state->active.emplace(id, std::move(job));
+			}
+			/* one task per request; each picks whichever queued job is most important when it starts */
+			pool.submit([st = state]() {
+				RunNextJob(*st);
+			});
+			return id;
+		}
+
+		static void RunNextJob(State& st) {
+			std::shared_ptr<detail::AsyncLoadJob> job;
+			{
+				std::lock_guard lk(st.mtx);
+				while(!st.pending.empty() && !job) {
+					job = st.pending.top();
+					st.pending.pop();
+					if(job->cancelled || st.closed) {
+						job.reset();
+					}
+				}
+			}
+			if(!job) {
+				return;
+			}
+			job->load();
+			std::lock_guard lk(st.mtx);
+			if(!job->cancelled && !st.closed) {
+				st.loaded.push_back(std::move(job));
+			}
+		}
+
+		/* removes a loaded job from the active set; false if it was cancelled */
+		bool retire(const detail::AsyncLoadJob& job) {
+			std::lock_guard lk(state->mtx);
+			if(job.cancelled) {
+				return false;
+			}
+			state->active.erase(job.id);
+			return true;
+		}
+
+		std::shared_ptr<State> state;
+		int videoBitmapFlags;
+		UserEventSource eventSource;
+		std::priority_queue<
+			std::shared_ptr<detail::AsyncLoadJob>,
+			std::vector<std::shared_ptr<detail::AsyncLoadJob>>,
+			detail::AsyncJobOrder
+		> ready;
+
+		/* declared last: destroyed (joined) first, while the rest is still alive */
+		ThreadPool pool;
+	};
+
+}
+
+#endif //AXXEGRO_ASYNCLOADER_HPP
@@ -8,6 +8,7 @@
 #include "axxegro/addons/audio/RingBuffer.hpp"
 #include "axxegro/addons/audio/Sample.hpp"
 #include "axxegro/addons/audio/SampleInstance.hpp"
+#include "axxegro/addons/audio/SPSCRingBuffer.hpp"
 #include "axxegro/addons/audio/Voice.hpp"
 
 #endif /* INCLUDE_AXXEGRO_AUDIO_AUDIO */
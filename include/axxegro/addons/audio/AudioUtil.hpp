@@ -6,73 +6,436 @@
 #define AXXEGRO_AUDIOUTIL_HPP
 
 #include "AudioCommon.hpp"
+#include "../../com/util/Simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <ranges>
 
+/**
+ * @file
+ * Sample format conversion, channel (de)interleaving and gain/mixing on spans of
+ * samples or fragments. Hot paths (16-bit <-> float, stereo float zip/unzip,
+ * dithering) have SSE2/AVX2 kernels, the rest is written to auto-vectorize.
+ *
+ * Integer samples map to [-1, 1] like Allegro's mixer does: signed values are
+ * divided by their maximum, unsigned ones are offset by half their range.
+ */
+
 namespace al {
 
+	/// @brief Dithering used when converting to a lower bit depth.
+	enum class Dither {
+		None,
+
+		/// Triangular (TPDF) noise of +-1 LSB added before rounding.
+		Triangular
+	};
+
 	template<typename T>
 	concept RangeConvertibleToSpan = std::ranges::range<T> && requires(T r) {
 		{std::span(r)};
 	};
 
-	template<detail::ValidMultiChannelFragmentType TFrag, typename... TArgs>
-	requires (
-			(RangeConvertibleToSpan<TArgs> && ...) &&
-			sizeof...(TArgs) == TFrag::NumElements
-			)
-	bool UnzipChannels(const std::span<const TFrag> inputFragments, TArgs&&... outputChannels) {
-		using SampleType = typename TFrag::ElementType;
-		static constexpr int NumChannels = TFrag::NumElements;
+	template<std::signed_integral T>
+	inline float AsFloatSample(T val)
+	{
+		return static_cast<float>(val) * (1.0f / std::numeric_limits<T>::max());
+	}
 
-		std::array<std::span<SampleType>, NumChannels> outSpans = {outputChannels...};
-		for(const auto& outCh: outSpans) {
-			if(outCh.size() != inputFragments.size()) {
-				return false;
+	template<std::unsigned_integral T>
+	inline float AsFloatSample(T val)
+	{
+		return static_cast<float>(val) * (2.0f / std::numeric_limits<T>::max()) - 1.0f;
+	}
+
+	namespace detail::audio {
+
+		template<typename T>
+		struct IntSampleRange {
+			/* float -> integer is round(x * Scale + Offset), clamped to [Min, Max] */
+			static constexpr float Max = float(std::numeric_limits<T>::max());
+			static constexpr float Scale = std::is_signed_v<T> ? Max : Max * 0.5f;
+			static constexpr float Offset = std::is_signed_v<T> ? 0.0f : Max * 0.5f;
+			static constexpr float Min = float(std::numeric_limits<T>::min());
+		};
+
+		/* 4 independent xorshift32 generators; one per SIMD lane */
+		struct DitherRng {
+			std::array<uint32_t, 4> state;
+
+			DitherRng() {
+				static thread_local uint32_t seed = 0x9e3779b9u;
+				for(auto& s: state) {
+					seed = seed * 1664525u + 1013904223u;
+					s = seed | 1u;
+				}
+			}
+
+			/* uniform in [0, 1) */
+			float next(int lane) {
+				uint32_t& x = state[lane];
+				x ^= x << 13;
+				x ^= x >> 17;
+				x ^= x << 5;
+				return float(x >> 8) * (1.0f / 16777216.0f);
+			}
+
+			/* triangular in (-1, 1) */
+			float nextTriangular(int lane) {
+				return next(lane) - next(lane);
+			}
+
+#ifdef AXXEGRO_SIMD_SSE2
+			static __m128i Step(__m128i x) {
+				x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+				x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+				return _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+			}
+
+			static __m128 ToUnit(__m128i x) {
+				return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(x, 8)), _mm_set1_ps(1.0f / 16777216.0f));
+			}
+
+			__m128 nextTriangular4(__m128i& x) {
+				x = Step(x);
+				__m128 a = ToUnit(x);
+				x = Step(x);
+				return _mm_sub_ps(a, ToUnit(x));
+			}
+#endif
+		};
+
+		template<typename T>
+		void IntToFloat(const T* src, float* dst, size_t n) {
+			constexpr bool Signed = std::is_signed_v<T>;
+			constexpr float Scale = Signed
+				? 1.0f / std::numeric_limits<T>::max()
+				: 2.0f / std::numeric_limits<T>::max();
+			constexpr float Offset = Signed ? 0.0f : -1.0f;
+			size_t i = 0;
+			if constexpr(std::is_same_v<T, int16_t>) {
+#if defined(AXXEGRO_SIMD_AVX2)
+				const __m256 scale = _mm256_set1_ps(Scale);
+				for(; i+16 <= n; i += 16) {
+					__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+					__m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+					__m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+					_mm256_storeu_ps(dst + i + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale));
+					_mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale));
+				}
+#elif defined(AXXEGRO_SIMD_SSE2)
+				const __m128 scale = _mm_set1_ps(Scale);
+				for(; i+8 <= n; i += 8) {
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+					/* sign extension: put each value in the upper half, then shift it down */
+					__m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+					__m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+					_mm_storeu_ps(dst + i + 0, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+					_mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+				}
+#endif
+			}
+			for(; i < n; i++) {
+				dst[i] = float(src[i]) * Scale + Offset;
 			}
 		}
 
-		for(unsigned i=0; i<inputFragments.size(); i++) {
-			for(int ch=0; ch<NumChannels; ch++) {
-				outSpans[ch][i] = inputFragments[i][ch];
+		template<typename T>
+		void FloatToInt(const float* src, T* dst, size_t n, Dither dither) {
+			using R = IntSampleRange<T>;
+			DitherRng rng;
+			size_t i = 0;
+			if constexpr(std::is_same_v<T, int16_t>) {
+#ifdef AXXEGRO_SIMD_SSE2
+				/* _mm_cvtps_epi32 rounds to nearest, _mm_packs_epi32 saturates to [-32768, 32767] */
+				const __m128 scale = _mm_set1_ps(R::Scale);
+				if(dither == Dither::Triangular) {
+					__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rng.state.data()));
+					for(; i+8 <= n; i += 8) {
+						__m128 a = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 0), scale), rng.nextTriangular4(x));
+						__m128 b = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), rng.nextTriangular4(x));
+						__m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+					}
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(rng.state.data()), x);
+				} else {
+					for(; i+8 <= n; i += 8) {
+						__m128 a = _mm_mul_ps(_mm_loadu_ps(src + i + 0), scale);
+						__m128 b = _mm_mul_ps(_mm_loadu_ps(src + i + 4), scale);
+						__m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+					}
+				}
+#endif
+			}
+			if(dither == Dither::Triangular) {
+				for(; i < n; i++) {
+					float v = src[i] * R::Scale + R::Offset + rng.nextTriangular(int(i & 3));
+					dst[i] = T(std::lrint(std::clamp(v, R::Min, R::Max)));
+				}
+			} else {
+				for(; i < n; i++) {
+					float v = src[i] * R::Scale + R::Offset;
+					dst[i] = T(std::lrint(std::clamp(v, R::Min, R::Max)));
+				}
+			}
+		}
+
+		template<typename DstT, typename SrcT>
+		void ConvertSamplesImpl(const SrcT* src, DstT* dst, size_t n, Dither dither) {
+			if constexpr(std::is_same_v<SrcT, DstT>) {
+				std::memcpy(dst, src, n * sizeof(SrcT));
+			} else if constexpr(std::is_same_v<SrcT, float>) {
+				FloatToInt(src, dst, n, dither);
+			} else if constexpr(std::is_same_v<DstT, float>) {
+				IntToFloat(src, dst, n);
+			} else {
+				/* integer to integer goes through float in small blocks */
+				constexpr size_t BlockSize = 256;
+				float tmp[BlockSize];
+				for(size_t i=0; i<n; i += BlockSize) {
+					size_t m = std::min(BlockSize, n - i);
+					IntToFloat(src + i, tmp, m);
+					FloatToInt(tmp, dst + i, m, dither);
+				}
+			}
+		}
+
+		/* A sample type or a multi-channel fragment type, with the number of samples per fragment. */
+		template<typename TFrag>
+		struct FragmentLayout {
+			using SampleType = TFrag;
+			static constexpr int NumChannels = 1;
+		};
+
+		template<ValidMultiChannelFragmentType TFrag>
+		struct FragmentLayout<TFrag> {
+			static_assert(TFrag::IsContiguous, "Fragment types must be tightly packed");
+			using SampleType = typename TFrag::ElementType;
+			static constexpr int NumChannels = TFrag::NumElements;
+		};
+
+		template<typename TFrag>
+		using FragmentSampleType = typename FragmentLayout<std::remove_const_t<TFrag>>::SampleType;
+
+		/* views a span of fragments as a span of interleaved samples */
+		template<typename TFrag>
+		auto AsSamples(std::span<TFrag> frags) {
+			using SampleT = std::conditional_t<std::is_const_v<TFrag>, const FragmentSampleType<TFrag>, FragmentSampleType<TFrag>>;
+			constexpr int N = FragmentLayout<std::remove_const_t<TFrag>>::NumChannels;
+			return std::span<SampleT>(reinterpret_cast<SampleT*>(frags.data()), frags.size() * N);
+		}
+
+		template<int N, typename T>
+		void Deinterleave(const T* src, const std::array<T*, N>& dst, size_t n) {
+			size_t i = 0;
+			if constexpr(N == 2 && std::is_same_v<T, float>) {
+#ifdef AXXEGRO_SIMD_SSE2
+				for(; i+4 <= n; i += 4) {
+					__m128 a = _mm_loadu_ps(src + 2*i + 0);
+					__m128 b = _mm_loadu_ps(src + 2*i + 4);
+					_mm_storeu_ps(dst[0] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+					_mm_storeu_ps(dst[1] + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+				}
+#endif
+			}
+			for(; i < n; i++) {
+				for(int ch=0; ch<N; ch++) {
+					dst[ch][i] = src[N*i + ch];
+				}
+			}
+		}
+
+		template<int N, typename T>
+		void Interleave(const std::array<const T*, N>& src, T* dst, size_t n) {
+			size_t i = 0;
+			if constexpr(N == 2 && std::is_same_v<T, float>) {
+#ifdef AXXEGRO_SIMD_SSE2
+				for(; i+4 <= n; i += 4) {
+					__m128 l = _mm_loadu_ps(src[0] + i);
+					__m128 r = _mm_loadu_ps(src[1] + i);
+					_mm_storeu_ps(dst + 2*i + 0, _mm_unpacklo_ps(l, r));
+					_mm_storeu_ps(dst + 2*i + 4, _mm_unpackhi_ps(l, r));
+				}
+#endif
+			}
+			for(; i < n; i++) {
+				for(int ch=0; ch<N; ch++) {
+					dst[N*i + ch] = src[ch][i];
+				}
 			}
 		}
-		return true;
 	}
 
-	template<std::signed_integral T>
-	inline float AsFloatSample(T val)
+	/// @brief Converts a float sample in [-1, 1] to an integer sample (rounded and clamped).
+	template<std::integral T>
+	inline T FromFloatSample(float val)
 	{
-		return static_cast<float>(val) / std::numeric_limits<T>::max();
+		using R = detail::audio::IntSampleRange<T>;
+		return T(std::lrint(std::clamp(val * R::Scale + R::Offset, R::Min, R::Max)));
 	}
 
-	template<std::unsigned_integral T>
-	inline float AsFloatSample(T val)
+	/**
+	 * @brief Converts samples between any of the supported sample types.
+	 * @param dither Used when the destination is an integer type.
+	 * @return false if the spans differ in size.
+	 */
+	template<detail::ValidSampleType DstT, detail::ValidSampleType SrcT>
+	bool ConvertSamples(const std::span<const SrcT> src, std::span<DstT> dst, Dither dither = Dither::None)
+	{
+		if(src.size() != dst.size()) {
+			return false;
+		}
+		detail::audio::ConvertSamplesImpl(src.data(), dst.data(), src.size(), dither);
+		return true;
+	}
+
+	/**
+	 * @brief Converts fragments to fragments with the same number of channels and a
+	 * different sample type, e.g. Vec2<int16_t> to Vec2f.
+	 * @return false if the spans differ in size.
+	 */
+	template<detail::ValidFragmentType DstFragT, detail::ValidFragmentType SrcFragT>
+		requires (detail::audio::FragmentLayout<DstFragT>::NumChannels == detail::audio::FragmentLayout<SrcFragT>::NumChannels)
+	bool ConvertFragments(const std::span<const SrcFragT> src, std::span<DstFragT> dst, Dither dither = Dither::None)
 	{
-		return 2.0f * (static_cast<float>(val) / std::numeric_limits<T>::max() - 0.5f);
+		if(src.size() != dst.size()) {
+			return false;
+		}
+		auto s = detail::audio::AsSamples(src);
+		auto d = detail::audio::AsSamples(dst);
+		detail::audio::ConvertSamplesImpl(s.data(), d.data(), s.size(), dither);
+		return true;
 	}
 
 	template<typename T> requires (detail::ValidFragmentType<T> && std::integral<T>)
 	bool ConvertFragmentsToFloat(const std::span<const T> src, std::span<float> dst)
+	{
+		return ConvertSamples(src, dst);
+	}
+
+	template<detail::ValidMultiChannelFragmentType TFrag>
+	bool ConvertFragmentsToFloat(const std::span<const TFrag> src, std::span<detail::ConvertFragSampleType<TFrag, float>> dst) {
+		return ConvertFragments(src, dst);
+	}
+
+	/**
+	 * @brief Converts 24-bit samples, stored sign-extended in 32-bit integers
+	 * (ALLEGRO_AUDIO_DEPTH_INT24), to float.
+	 */
+	inline bool ConvertInt24ToFloat(const std::span<const int32_t> src, std::span<float> dst)
 	{
 		if(src.size() != dst.size()) {
 			return false;
 		}
-		for(unsigned i=0; i<src.size(); i++) {
-			dst[i] = AsFloatSample(src[i]);
+		constexpr float Scale = 1.0f / 8388607.0f;
+		for(size_t i=0; i<src.size(); i++) {
+			dst[i] = float(src[i]) * Scale;
 		}
 		return true;
 	}
 
-	template<detail::ValidMultiChannelFragmentType TFrag>
-	bool ConvertFragmentsToFloat(const std::span<const TFrag> src, std::span<detail::ConvertFragSampleType<TFrag, float>> dst) {
-		static constexpr int NumChannels = TFrag::NumElements;
+	/// @brief Converts float samples to 24-bit samples stored in 32-bit integers.
+	inline bool ConvertFloatToInt24(const std::span<const float> src, std::span<int32_t> dst, Dither dither = Dither::None)
+	{
 		if(src.size() != dst.size()) {
 			return false;
 		}
-		for(unsigned i=0; i<src.size(); i++) {
-			for(int j=0; j<NumChannels; j++) {
-				dst[i][j] = AsFloatSample(src[i][j]);
+		constexpr float Max = 8388607.0f;
+		detail::audio::DitherRng rng;
+		for(size_t i=0; i<src.size(); i++) {
+			float v = src[i] * Max;
+			if(dither == Dither::Triangular) {
+				v += rng.nextTriangular(int(i & 3));
+			}
+			dst[i] = int32_t(std::lrint(std::clamp(v, -Max - 1.0f, Max)));
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Splits interleaved fragments into one span per channel.
+	 * @return false if any of the channel spans differs in size from the input.
+	 */
+	template<detail::ValidMultiChannelFragmentType TFrag, typename... TArgs>
+	requires (
+			(RangeConvertibleToSpan<TArgs> && ...) &&
+			sizeof...(TArgs) == TFrag::NumElements
+			)
+	bool UnzipChannels(const std::span<const TFrag> inputFragments, TArgs&&... outputChannels) {
+		using SampleType = typename TFrag::ElementType;
+		static constexpr int NumChannels = TFrag::NumElements;
+
+		std::array<std::span<SampleType>, NumChannels> outSpans = {outputChannels...};
+		std::array<SampleType*, NumChannels> outPtrs;
+		for(int ch=0; ch<NumChannels; ch++) {
+			if(outSpans[ch].size() != inputFragments.size()) {
+				return false;
+			}
+			outPtrs[ch] = outSpans[ch].data();
+		}
+
+		auto samples = detail::audio::AsSamples(inputFragments);
+		detail::audio::Deinterleave<NumChannels>(samples.data(), outPtrs, inputFragments.size());
+		return true;
+	}
+
+	/**
+	 * @brief Interleaves one span per channel into fragments. The inverse of UnzipChannels().
+	 * @return false if any of the channel spans differs in size from the output.
+	 */
+	template<detail::ValidMultiChannelFragmentType TFrag, typename... TArgs>
+	requires (
+			(RangeConvertibleToSpan<TArgs> && ...) &&
+			sizeof...(TArgs) == TFrag::NumElements
+			)
+	bool ZipChannels(std::span<TFrag> outputFragments, TArgs&&... inputChannels) {
+		using SampleType = typename TFrag::ElementType;
+		static constexpr int NumChannels = TFrag::NumElements;
+
+		std::array<std::span<const SampleType>, NumChannels> inSpans = {std::span<const SampleType>(inputChannels)...};
+		std::array<const SampleType*, NumChannels> inPtrs;
+		for(int ch=0; ch<NumChannels; ch++) {
+			if(inSpans[ch].size() != outputFragments.size()) {
+				return false;
 			}
+			inPtrs[ch] = inSpans[ch].data();
+		}
+
+		auto samples = detail::audio::AsSamples(outputFragments);
+		detail::audio::Interleave<NumChannels>(inPtrs, samples.data(), outputFragments.size());
+		return true;
+	}
+
+	/// @brief Multiplies every sample by `gain`.
+	template<typename TFrag>
+		requires std::same_as<detail::audio::FragmentSampleType<TFrag>, float>
+	void ApplyGain(std::span<TFrag> fragments, float gain)
+	{
+		for(float& s: detail::audio::AsSamples(fragments)) {
+			s *= gain;
+		}
+	}
+
+	/**
+	 * @brief Adds `src` multiplied by `gain` to `dst`, sample by sample.
+	 * @return false if the spans differ in size.
+	 */
+	template<typename TFrag>
+		requires std::same_as<detail::audio::FragmentSampleType<TFrag>, float>
+	bool MixAdd(std::span<TFrag> dst, const std::span<const TFrag> src, float gain = 1.0f)
+	{
+		if(src.size() != dst.size()) {
+			return false;
+		}
+		auto d = detail::audio::AsSamples(dst);
+		auto s = detail::audio::AsSamples(src);
+		for(size_t i=0; i<d.size(); i++) {
+			d[i] += s[i] * gain;
 		}
 		return true;
 	}
@@ -14,6 +14,7 @@ namespace al {
 
 	/**
 	 * @brief A simple FIFO ring buffer. Provides utility for audio code.
+	 * Not thread-safe; use SPSCRingBuffer to pass data between two threads.
 	 * @tparam T The buffer's value type. Must be copyable.
 	 */
 	template<typename T>
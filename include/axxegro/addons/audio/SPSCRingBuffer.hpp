@@ -0,0 +1,180 @@
+#ifndef AXXEGRO_SPSCRINGBUFFER_HPP
+#define AXXEGRO_SPSCRINGBUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "../../com/util/General.hpp"
+
+namespace al {
+
+	/**
+	 * @brief A wait-free FIFO ring buffer for exactly one producer thread and
+	 * one consumer thread, e.g. a recorder callback feeding an audio stream.
+	 *
+	 * The capacity is rounded up to a power of two, so indices are masked rather
+	 * than wrapped with a modulo. Besides copying pushData()/popInto(), the buffer
+	 * can be accessed in place: writeSpans() and readSpans() return the (up to two)
+	 * contiguous regions available, which are then committed with commitWrite() and
+	 * commitRead().
+	 *
+	 * Producer-side functions (writeSpans, commitWrite, pushData) must only be called
+	 * from the producer thread, consumer-side ones (readSpans, commitRead, popInto)
+	 * only from the consumer thread. size() and freeSpace() may be called from either.
+	 *
+	 * @tparam T The buffer's value type. Must be copyable and default constructible.
+	 */
+	template<typename T>
+	class SPSCRingBuffer {
+	public:
+		using SizeT = size_t;
+
+		/// @brief Two contiguous parts of the buffer which together form one logical range.
+		template<typename U>
+		struct Regions {
+			std::span<U> first;
+			std::span<U> second;
+
+			[[nodiscard]] SizeT size() const {
+				return first.size() + second.size();
+			}
+
+			[[nodiscard]] U& operator[](SizeT i) const {
+				return i < first.size() ? first[i] : second[i - first.size()];
+			}
+		};
+
+		/**
+		 * @brief Creates a ring buffer that can hold at least `minCapacity` elements.
+		 */
+		explicit SPSCRingBuffer(SizeT minCapacity)
+			: data(std::bit_ceil(std::max<SizeT>(minCapacity, 1))),
+			  mask(data.size() - 1)
+		{}
+
+		SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+		SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+		/// @brief Returns the maximum number of elements that can be held by the buffer (a power of two).
+		[[nodiscard]] SizeT capacity() const {
+			return data.size();
+		}
+
+		/// @brief Returns the number of elements currently held by the buffer.
+		[[nodiscard]] SizeT size() const {
+			SizeT t = tail.load(std::memory_order_acquire);
+			SizeT h = head.load(std::memory_order_acquire);
+			return h - t;
+		}
+
+		/// @brief Returns the maximum number of elements that can be pushed into the buffer currently.
+		[[nodiscard]] SizeT freeSpace() const {
+			return capacity() - size();
+		}
+
+		[[nodiscard]] bool empty() const {
+			return size() == 0;
+		}
+
+		/**
+		 * @brief (Producer) Returns up to `maxCount` elements of free space to be written in place.
+		 * Nothing becomes visible to the consumer until commitWrite().
+		 */
+		[[nodiscard]] Regions<T> writeSpans(SizeT maxCount = std::numeric_limits<SizeT>::max()) {
+			SizeT h = head.load(std::memory_order_relaxed);
+			SizeT available = capacity() - (h - cachedTail);
+			if(available < maxCount) {
+				cachedTail = tail.load(std::memory_order_acquire);
+				available = capacity() - (h - cachedTail);
+			}
+			return makeRegions<T>(h, std::min(available, maxCount));
+		}
+
+		/**
+		 * @brief (Producer) Publishes the first `count` elements of the last writeSpans() result.
+		 */
+		void commitWrite(SizeT count) {
+			head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+		}
+
+		/**
+		 * @brief (Consumer) Returns up to `maxCount` of the oldest elements to be read in place.
+		 * They stay in the buffer until commitRead().
+		 */
+		[[nodiscard]] Regions<const T> readSpans(SizeT maxCount = std::numeric_limits<SizeT>::max()) {
+			SizeT t = tail.load(std::memory_order_relaxed);
+			SizeT available = cachedHead - t;
+			if(available < maxCount) {
+				cachedHead = head.load(std::memory_order_acquire);
+				available = cachedHead - t;
+			}
+			return makeRegions<const T>(t, std::min(available, maxCount));
+		}
+
+		/**
+		 * @brief (Consumer) Releases the first `count` elements of the last readSpans() result.
+		 */
+		void commitRead(SizeT count) {
+			tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+		}
+
+		/**
+		 * @brief (Producer) Inserts the specified range of elements into the buffer in a FIFO manner.
+		 * @param elements Elements to be inserted into the buffer.
+		 * @return Whether there was enough space to perform the operation.
+		 */
+		bool pushData(const std::span<const T> elements) {
+			auto dst = writeSpans(elements.size());
+			if(dst.size() < elements.size()) {
+				return false;
+			}
+			auto split = elements.begin() + dst.first.size();
+			std::copy(elements.begin(), split, dst.first.begin());
+			std::copy(split, elements.end(), dst.second.begin());
+			commitWrite(elements.size());
+			return true;
+		}
+
+		/**
+		 * @brief (Consumer) Copies the buffer's oldest elements into the specified range.
+		 * @param output Output data. Specifies both the destination and the requested amount of data.
+		 * @return Whether there was enough data in the buffer to perform the operation.
+		 */
+		bool popInto(std::span<T> output) {
+			auto src = readSpans(output.size());
+			if(src.size() < output.size()) {
+				return false;
+			}
+			auto it = std::copy(src.first.begin(), src.first.end(), output.begin());
+			std::copy(src.second.begin(), src.second.end(), it);
+			commitRead(output.size());
+			return true;
+		}
+
+	private:
+		template<typename U>
+		Regions<U> makeRegions(SizeT pos, SizeT count) {
+			std::span<T> buf(data);
+			SizeT begin = pos & mask;
+			SizeT firstSize = std::min(count, capacity() - begin);
+			return {buf.subspan(begin, firstSize), buf.subspan(0, count - firstSize)};
+		}
+
+		/* head and tail only ever grow; positions in the buffer are (index & mask) */
+		alignas(CacheLineSize) std::atomic<SizeT> head = 0; //one past the last element, written by the producer
+		SizeT cachedTail = 0; //the producer's last view of tail
+
+		alignas(CacheLineSize) std::atomic<SizeT> tail = 0; //the first element, written by the consumer
+		SizeT cachedHead = 0; //the consumer's last view of head
+
+		alignas(CacheLineSize) std::vector<T> data;
+		SizeT mask;
+	};
+
+}
+
+#endif //AXXEGRO_SPSCRINGBUFFER_HPP
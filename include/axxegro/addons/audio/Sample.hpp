@@ -78,6 +78,11 @@ namespace al
 			return al_get_sample_frequency(ptr());
 		}
 
+		/// @see <a href="https://liballeg.org/a5docs/trunk/audio.html#al_get_sample_length">Allegro: al_get_sample_length</a>
+		[[nodiscard]] unsigned getLength() const {
+			return al_get_sample_length(ptr());
+		}
+
 	private:
 
 	};
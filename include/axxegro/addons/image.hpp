@@ -3,15 +3,10 @@
 
 #include "../com/Initializable.hpp"
 #include "../core/gfx/Bitmap.hpp"
-#include <allegro5/allegro_image.h>
+#include "../core/gfx/TextureAtlas.hpp"
+#include "image/ImageAddon.hpp"
 
 namespace al {
-	struct ImageAddon {
-		static constexpr char name[] = "Image addon";
-		[[nodiscard]] static bool isInitialized() {return al_is_image_addon_initialized();}
-		[[nodiscard]] static bool init() {return al_init_image_addon();}
-		using DependsOn = InitDependencies<CoreAllegro>;
-	};
 
 	inline Bitmap LoadBitmap(const std::string& filename) {
 		InternalRequire<ImageAddon>();
@@ -21,6 +16,14 @@ namespace al {
 			throw ResourceLoadError("Cannot load bitmap from file \"%s\"", filename.c_str());
 		}
 	}
+
+	/**
+	 * @brief Loads an image file into a texture atlas, using the file name as the entry name.
+	 * @return A handle to the image inside the atlas.
+	 */
+	inline SubBitmap& LoadBitmapIntoAtlas(TextureAtlas& atlas, const std::string& filename) {
+		return atlas.insert(filename, filename);
+	}
 }
 
 #endif /* AA151877_661C_47B3_990A_FD6E29BC6062 */
@@ -5,5 +5,11 @@
 #include "prim/lldr.hpp"
 #include "prim/buffers.hpp"
 #include "prim/Vertex.hpp"
+#include "prim/Tessellate.hpp"
+#include "prim/Stroke.hpp"
+#include "prim/PrimBatch.hpp"
+#include "prim/SpriteBatch.hpp"
+#include "prim/CommandBuffer.hpp"
+#include "prim/ParallelCommandRecorder.hpp"
 
 #endif /* INCLUDE_AXXEGRO_PRIM_PRIM */
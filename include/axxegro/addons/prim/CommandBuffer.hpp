@@ -0,0 +1,563 @@
+#ifndef AXXEGRO_COMMANDBUFFER_HPP
+#define AXXEGRO_COMMANDBUFFER_HPP
+
+#include "common.hpp"
+#include "PrimitivesAddon.hpp"
+#include "SpriteBatch.hpp"
+#include "Vertex.hpp"
+
+#include "../../core/Shader.hpp"
+#include "../../core/gfx/Blender.hpp"
+#include "../../com/util/InlineFunction.hpp"
+
+#include <array>
+#include <cmath>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * Recording draw commands, sorting them by render state and drawing them in one pass
+ */
+
+namespace al {
+
+	/**
+	 * @brief Where a command goes in the sorted order, and the state it is drawn with.
+	 *
+	 * Commands are drawn ordered by layer, then shader, texture, blender and
+	 * depth (all ascending). Commands with equal keys keep their recording order.
+	 * Within a layer, order only follows depth where it doesn't conflict with
+	 * grouping by state, so use separate layers for things that must overlap correctly.
+	 */
+	struct DrawState {
+		uint8_t layer = 0;
+		uint16_t depth = 0;
+
+		/// nullptr means Allegro's default shader.
+		Shader* shader = nullptr;
+		Blender blender = {};
+
+		/// Blender for the alpha channel. If empty, `blender` is used for both.
+		std::optional<Blender> alphaBlender = std::nullopt;
+	};
+
+	struct CommandBufferStats {
+		size_t numCommands = 0;
+		size_t numDrawCalls = 0;
+
+		/// Changes of shader, texture or blender between consecutive draw calls.
+		size_t numStateChanges = 0;
+	};
+
+	class CommandList;
+
+	namespace detail {
+		struct SortItem {
+			uint64_t key;
+			uint32_t index;
+		};
+
+		/**
+		 * LSD radix sort by key, 8 bits per pass. Stable. Passes in which all keys
+		 * have the same byte are skipped, so only the bytes that vary cost anything.
+		 */
+		inline void RadixSort(std::vector<SortItem>& items, std::vector<SortItem>& tmp) {
+			std::array<std::array<uint32_t, 256>, 8> counts {};
+			for(const auto& item: items) {
+				for(int b=0; b<8; b++) {
+					counts[b][(item.key >> (8*b)) & 0xFF]++;
+				}
+			}
+
+			tmp.resize(items.size());
+			for(int b=0; b<8; b++) {
+				auto& cnt = counts[b];
+				if(cnt[(items.front().key >> (8*b)) & 0xFF] == items.size()) {
+					continue;
+				}
+				uint32_t offset = 0;
+				for(auto& c: cnt) {
+					uint32_t n = c;
+					c = offset;
+					offset += n;
+				}
+				for(const auto& item: items) {
+					tmp[cnt[(item.key >> (8*b)) & 0xFF]++] = item;
+				}
+				items.swap(tmp);
+			}
+		}
+
+		/* sort key layout, most significant first: layer:8 shader:8 texture:16 blender:8 depth:16 unused:8 */
+		struct DrawKey {
+			static uint64_t Make(uint32_t layer, uint32_t shader, uint32_t texture, uint32_t blender, uint32_t depth) {
+				return (uint64_t(layer) << 56) | (uint64_t(shader) << 48) | (uint64_t(texture) << 32)
+					| (uint64_t(blender) << 24) | (uint64_t(depth) << 8);
+			}
+			static uint32_t Shader(uint64_t key) {return uint32_t(key >> 48) & 0xFF;}
+			static uint32_t Texture(uint64_t key) {return uint32_t(key >> 32) & 0xFFFF;}
+			static uint32_t Blender(uint64_t key) {return uint32_t(key >> 24) & 0xFF;}
+
+			static uint64_t WithIDs(uint64_t key, uint32_t shader, uint32_t texture, uint32_t blender) {
+				constexpr uint64_t IDMask = (uint64_t(0xFF) << 48) | (uint64_t(0xFFFF) << 32) | (uint64_t(0xFF) << 24);
+				return (key & ~IDMask) | Make(0, shader, texture, blender, 0);
+			}
+		};
+
+		struct DrawCommand {
+			static constexpr uint32_t NoCustom = ~uint32_t(0);
+
+			uint32_t firstVertex;
+			uint32_t numVertices;
+			uint32_t firstIndex;
+			uint32_t numIndices;
+			uint32_t custom;
+		};
+
+		/* interns shaders, textures and blenders into the small IDs stored in sort keys */
+		class DrawStateTable {
+		public:
+			uint32_t shaderID(ALLEGRO_SHADER* shader) {
+				for(uint32_t i=0; i<shaders.size(); i++) {
+					if(shaders[i] == shader) {
+						return i;
+					}
+				}
+				if(shaders.size() >= 256) {
+					throw OutOfRangeError("A command buffer can use at most 256 shaders");
+				}
+				shaders.push_back(shader);
+				return uint32_t(shaders.size() - 1);
+			}
+
+			uint32_t blenderID(const al::SeparateBlender& blender) {
+				auto same = [](const al::Blender& a, const al::Blender& b) {
+					return a.op == b.op && a.src == b.src && a.dst == b.dst;
+				};
+				for(uint32_t i=0; i<blenders.size(); i++) {
+					if(same(blenders[i].color, blender.color) && same(blenders[i].alpha, blender.alpha)) {
+						return i;
+					}
+				}
+				if(blenders.size() >= 256) {
+					throw OutOfRangeError("A command buffer can use at most 256 blenders");
+				}
+				blenders.push_back(blender);
+				return uint32_t(blenders.size() - 1);
+			}
+
+			uint32_t textureID(ALLEGRO_BITMAP* texture) {
+				if(!texture) {
+					return 0;
+				}
+				if(texture == lastTexture) {
+					return lastTextureID;
+				}
+				auto [it, inserted] = textureIDs.try_emplace(texture, uint32_t(textures.size()));
+				if(inserted) {
+					if(textures.size() > 0xFFFF) {
+						textureIDs.erase(it);
+						throw OutOfRangeError("A command buffer can use at most 65536 textures");
+					}
+					textures.push_back(texture);
+				}
+				lastTexture = texture;
+				lastTextureID = it->second;
+				return lastTextureID;
+			}
+
+			void clear() {
+				shaders.assign(1, nullptr);
+				blenders.clear();
+				textures.assign(1, nullptr);
+				textureIDs.clear();
+				lastTexture = nullptr;
+				lastTextureID = 0;
+			}
+
+			/* index 0 of shaders and textures is "none" */
+			std::vector<ALLEGRO_SHADER*> shaders {nullptr};
+			std::vector<al::SeparateBlender> blenders;
+			std::vector<ALLEGRO_BITMAP*> textures {nullptr};
+
+		private:
+			std::unordered_map<ALLEGRO_BITMAP*, uint32_t> textureIDs;
+			ALLEGRO_BITMAP* lastTexture = nullptr;
+			uint32_t lastTextureID = 0;
+		};
+
+		class CommandExecutor {
+		public:
+			inline CommandBufferStats execute(std::span<CommandList* const> lists);
+
+		private:
+			struct CommandRef {
+				const CommandList* list;
+				uint32_t command;
+				float du, dv;
+			};
+
+			DrawStateTable table;
+			std::vector<uint32_t> shaderMap, textureMap, blenderMap;
+			std::vector<Vec2f> textureOffsets;
+			std::vector<CommandRef> refs;
+			std::vector<SortItem> sortItems;
+			std::vector<SortItem> sortTmp;
+			std::vector<BasicVertex> mergedVertices;
+			std::vector<int> mergedIndices;
+		};
+	}
+
+	/**
+	 * @brief A list of draw commands being recorded.
+	 *
+	 * Recording never calls Allegro, so a CommandList can be filled on any thread
+	 * (one thread per list at a time) and without Allegro being initialized at
+	 * all. Lists are drawn with CommandBuffer::execute() or ParallelCommandRecorder.
+	 * Storage is kept on clear(), so a list that is reused every frame stops
+	 * allocating once it has reached its working size.
+	 *
+	 * Texture coordinates are in pixels of the given texture; textures that are
+	 * sub-bitmaps are resolved to their parent when the list is executed.
+	 * Textures and shaders must stay alive until then.
+	 *
+	 * A list can reference up to 256 shaders, 65536 textures and 256 blenders
+	 * between executions.
+	 */
+	class CommandList {
+	public:
+		using CustomCommand = InlineFunction<void()>;
+
+		/// @brief Draws `srcRect` of a bitmap stretched to `dstRect`.
+		void drawBitmapRegion(const Bitmap& bitmap, const RectF& srcRect, const RectF& dstRect, Color tint = White, const DrawState& state = {}) {
+			pushSprite(bitmap, srcRect, tint, state, {
+				dstRect.width() / srcRect.width(), 0.0f,
+				0.0f, dstRect.height() / srcRect.height(),
+				dstRect.a.x, dstRect.a.y
+			});
+		}
+
+		/// @brief Draws `srcRect` of a bitmap, with its top left corner at the origin, mapped through `transform`.
+		void drawSprite(const Bitmap& bitmap, const RectF& srcRect, const Transform& transform, Color tint = White, const DrawState& state = {}) {
+			pushSprite(bitmap, srcRect, tint, state, {
+				transform.m[0][0], transform.m[0][1],
+				transform.m[1][0], transform.m[1][1],
+				transform.m[3][0], transform.m[3][1]
+			});
+		}
+
+		/**
+		 * @brief Draws `srcRect` of a bitmap with the parameters of Bitmap::drawTintedScaledRotatedRegion():
+		 * `centerSrc` (relative to srcRect) ends up at `centerDst`, scaled and then rotated by `angle` radians.
+		 */
+		void drawSprite(const Bitmap& bitmap, const RectF& srcRect, Vec2f centerSrc, Vec2f centerDst, Vec2f scale = {1.0f, 1.0f}, float angle = 0.0f, Color tint = White, const DrawState& state = {}) {
+			float c = std::cos(angle);
+			float s = std::sin(angle);
+			Affine m {c * scale.x, s * scale.x, -s * scale.y, c * scale.y, 0.0f, 0.0f};
+			m.tx = centerDst.x - (m.m00 * centerSrc.x + m.m10 * centerSrc.y);
+			m.ty = centerDst.y - (m.m01 * centerSrc.x + m.m11 * centerSrc.y);
+			pushSprite(bitmap, srcRect, tint, state, m);
+		}
+
+		/// @brief Draws a solid rectangle.
+		void drawFilledRectangle(const RectF& rect, Color color, const DrawState& state = {}) {
+			detail::DrawCommand& cmd = pushCommand(nullptr, state, 4, 6);
+			BasicVertex* v = vertices.data() + cmd.firstVertex;
+			v[0] = CreateBasicVertex({rect.a.x, rect.a.y, 0}, {}, color);
+			v[1] = CreateBasicVertex({rect.b.x, rect.a.y, 0}, {}, color);
+			v[2] = CreateBasicVertex({rect.b.x, rect.b.y, 0}, {}, color);
+			v[3] = CreateBasicVertex({rect.a.x, rect.b.y, 0}, {}, color);
+			WriteQuadIndices(indices.data() + cmd.firstIndex);
+		}
+
+		/// @brief Draws a triangle list. Texture coordinates are in pixels of `texture` (which may be null).
+		void drawTriangles(std::span<const BasicVertex> triangleList, const Bitmap* texture = nullptr, const DrawState& state = {}) {
+			detail::DrawCommand& cmd = pushCommand(texture ? texture->ptr() : nullptr, state, triangleList.size(), triangleList.size());
+			std::copy(triangleList.begin(), triangleList.end(), vertices.begin() + cmd.firstVertex);
+			for(uint32_t i=0; i<cmd.numIndices; i++) {
+				indices[cmd.firstIndex + i] = int(i);
+			}
+		}
+
+		/// @brief Draws an indexed triangle list. Indices refer to `vtxs`.
+		void drawIndexedTriangles(std::span<const BasicVertex> vtxs, std::span<const int> triangleIndices, const Bitmap* texture = nullptr, const DrawState& state = {}) {
+			detail::DrawCommand& cmd = pushCommand(texture ? texture->ptr() : nullptr, state, vtxs.size(), triangleIndices.size());
+			std::copy(vtxs.begin(), vtxs.end(), vertices.begin() + cmd.firstVertex);
+			std::copy(triangleIndices.begin(), triangleIndices.end(), indices.begin() + cmd.firstIndex);
+		}
+
+		/**
+		 * @brief Records an arbitrary function, e.g. a Font::drawText() call, to be
+		 * called in sorted order with the shader and blender of `state` set.
+		 * It runs on the thread that executes the list. Custom commands are
+		 * never merged with other commands.
+		 */
+		void drawCustom(CustomCommand fn, const DrawState& state = {}) {
+			detail::DrawCommand& cmd = pushCommand(nullptr, state, 0, 0);
+			cmd.custom = uint32_t(customCommands.size());
+			customCommands.push_back(std::move(fn));
+		}
+
+		/// @brief Discards all recorded commands.
+		void clear() {
+			commands.clear();
+			keys.clear();
+			vertices.clear();
+			indices.clear();
+			customCommands.clear();
+			table.clear();
+		}
+
+		[[nodiscard]] size_t size() const {
+			return commands.size();
+		}
+
+		[[nodiscard]] bool empty() const {
+			return commands.empty();
+		}
+
+	private:
+		friend class detail::CommandExecutor;
+
+		struct Affine {
+			float m00, m01, m10, m11, tx, ty;
+		};
+
+		static void WriteQuadIndices(int* idx) {
+			idx[0] = 0; idx[1] = 1; idx[2] = 2;
+			idx[3] = 0; idx[4] = 2; idx[5] = 3;
+		}
+
+		void pushSprite(const Bitmap& bitmap, const RectF& srcRect, Color tint, const DrawState& state, const Affine& m) {
+			detail::SpriteRecord s {
+				.texture = bitmap.ptr(),
+				.u0 = srcRect.a.x, .v0 = srcRect.a.y,
+				.u1 = srcRect.b.x, .v1 = srcRect.b.y,
+				.w = srcRect.width(), .h = srcRect.height(),
+				.m00 = m.m00, .m01 = m.m01,
+				.m10 = m.m10, .m11 = m.m11,
+				.tx = m.tx, .ty = m.ty,
+				.tint = tint
+			};
+			detail::DrawCommand& cmd = pushCommand(s.texture, state, 4, 6);
+			detail::ExpandSprite(s, vertices.data() + cmd.firstVertex);
+			WriteQuadIndices(indices.data() + cmd.firstIndex);
+		}
+
+		detail::DrawCommand& pushCommand(ALLEGRO_BITMAP* texture, const DrawState& state, size_t numVertices, size_t numIndices) {
+			keys.push_back(detail::DrawKey::Make(
+				state.layer,
+				table.shaderID(state.shader ? state.shader->ptr() : nullptr),
+				table.textureID(texture),
+				table.blenderID({state.blender, state.alphaBlender.value_or(state.blender)}),
+				state.depth
+			));
+			detail::DrawCommand& cmd = commands.emplace_back(detail::DrawCommand{
+				.firstVertex = uint32_t(vertices.size()),
+				.numVertices = uint32_t(numVertices),
+				.firstIndex = uint32_t(indices.size()),
+				.numIndices = uint32_t(numIndices),
+				.custom = detail::DrawCommand::NoCustom
+			});
+			vertices.resize(vertices.size() + numVertices);
+			indices.resize(indices.size() + numIndices);
+			return cmd;
+		}
+
+		std::vector<detail::DrawCommand> commands;
+		std::vector<uint64_t> keys;
+		std::vector<BasicVertex> vertices;
+		std::vector<int> indices;
+		std::vector<CustomCommand> customCommands;
+		detail::DrawStateTable table;
+	};
+
+	/**
+	 * @brief Records draw commands for deferred, sorted execution.
+	 *
+	 * execute() sorts the commands by their DrawState, concatenates the vertices
+	 * of consecutive commands that share shader, texture and blender, and draws
+	 * each such run with a single al_draw_indexed_prim() call.
+	 * The transform and target current at execute() apply to all commands.
+	 */
+	class CommandBuffer: public CommandList {
+	public:
+		/// @brief Draws a whole bitmap with its top left corner at `pos`. Unlike the CommandList functions, this queries the bitmap's size from Allegro.
+		void drawBitmap(const Bitmap& bitmap, Vec2f pos, Color tint = White, const DrawState& state = {}) {
+			RectF rect(bitmap.rect());
+			drawBitmapRegion(bitmap, rect, rect + pos, tint, state);
+		}
+
+		/**
+		 * @brief Draws all recorded commands and clears the buffer.
+		 *
+		 * Restores the blender, including a separate alpha blender, afterwards.
+		 * If any command used a shader, the default shader is active afterwards.
+		 */
+		void execute() {
+			CommandList* self = this;
+			stats = executor.execute({&self, 1});
+		}
+
+		/// @return Statistics of the last execute().
+		[[nodiscard]] CommandBufferStats getLastStats() const {
+			return stats;
+		}
+
+	private:
+		detail::CommandExecutor executor;
+		CommandBufferStats stats;
+	};
+
+	/**
+	 * Merges the lists into one sorted stream (commands with equal keys in list
+	 * order, then recording order), draws it and clears the lists.
+	 */
+	inline CommandBufferStats detail::CommandExecutor::execute(std::span<CommandList* const> lists) {
+		CommandBufferStats stats;
+		table.clear();
+		refs.clear();
+		sortItems.clear();
+
+		for(CommandList* list: lists) {
+			const DrawStateTable& local = list->table;
+			shaderMap.resize(local.shaders.size());
+			for(size_t i=0; i<local.shaders.size(); i++) {
+				shaderMap[i] = table.shaderID(local.shaders[i]);
+			}
+			blenderMap.resize(local.blenders.size());
+			for(size_t i=0; i<local.blenders.size(); i++) {
+				blenderMap[i] = table.blenderID(local.blenders[i]);
+			}
+			textureMap.resize(local.textures.size());
+			textureOffsets.resize(local.textures.size());
+			for(size_t i=0; i<local.textures.size(); i++) {
+				ALLEGRO_BITMAP* bmp = local.textures[i];
+				textureOffsets[i] = {0.0f, 0.0f};
+				if(ALLEGRO_BITMAP* parent = bmp ? al_get_parent_bitmap(bmp) : nullptr) {
+					textureOffsets[i] = {float(al_get_bitmap_x(bmp)), float(al_get_bitmap_y(bmp))};
+					bmp = parent;
+				}
+				textureMap[i] = table.textureID(bmp);
+			}
+
+			for(uint32_t c=0; c<list->commands.size(); c++) {
+				uint64_t key = list->keys[c];
+				uint32_t localTexture = DrawKey::Texture(key);
+				key = DrawKey::WithIDs(key, shaderMap[DrawKey::Shader(key)], textureMap[localTexture], blenderMap[DrawKey::Blender(key)]);
+				sortItems.push_back({key, uint32_t(refs.size())});
+				refs.push_back({list, c, textureOffsets[localTexture].x, textureOffsets[localTexture].y});
+			}
+		}
+
+		stats.numCommands = refs.size();
+		if(refs.empty()) {
+			return stats;
+		}
+		RadixSort(sortItems, sortTmp);
+		InternalRequire<PrimitivesAddon>();
+
+		SeparateBlender originalBlender = GetSeparateBlender();
+		bool shaderUsed = false;
+		uint32_t curShader = 0, curBlender = 0;
+		bool stateKnown = false;
+
+		/* the state of the run being collected */
+		uint32_t runShader = 0, runBlender = 0, runTexture = 0;
+		bool runOpen = false;
+
+		auto applyState = [&](uint32_t shader, uint32_t blender) {
+			if(!stateKnown || shader != curShader) {
+				if(!al_use_shader(table.shaders[shader])) {
+					throw ShaderError("Cannot use shader in command buffer");
+				}
+				shaderUsed |= (shader != 0);
+			}
+			if(!stateKnown || blender != curBlender) {
+				SetSeparateBlender(table.blenders[blender]);
+			}
+			curShader = shader;
+			curBlender = blender;
+			stateKnown = true;
+		};
+
+		auto flush = [&]() {
+			if(!runOpen) {
+				return;
+			}
+			applyState(runShader, runBlender);
+			al_draw_indexed_prim(
+				mergedVertices.data(),
+				nullptr,
+				table.textures[runTexture],
+				mergedIndices.data(),
+				int(mergedIndices.size()),
+				ALLEGRO_PRIM_TRIANGLE_LIST
+			);
+			stats.numDrawCalls++;
+			mergedVertices.clear();
+			mergedIndices.clear();
+			runOpen = false;
+		};
+
+		for(const auto& item: sortItems) {
+			const CommandRef& ref = refs[item.index];
+			const CommandList& list = *ref.list;
+			const DrawCommand& cmd = list.commands[ref.command];
+			uint32_t shader = DrawKey::Shader(item.key);
+			uint32_t blender = DrawKey::Blender(item.key);
+			uint32_t texture = DrawKey::Texture(item.key);
+
+			if(cmd.custom != DrawCommand::NoCustom) {
+				flush();
+				applyState(shader, blender);
+				ref.list->customCommands[cmd.custom]();
+				stateKnown = false; /* the command may have changed anything */
+				continue;
+			}
+
+			if(runOpen && (shader != runShader || blender != runBlender || texture != runTexture)) {
+				flush();
+				stats.numStateChanges++;
+			}
+			if(!runOpen) {
+				runShader = shader;
+				runBlender = blender;
+				runTexture = texture;
+				runOpen = true;
+			}
+
+			int base = int(mergedVertices.size());
+			mergedVertices.insert(
+				mergedVertices.end(),
+				list.vertices.begin() + cmd.firstVertex,
+				list.vertices.begin() + cmd.firstVertex + cmd.numVertices
+			);
+			if(ref.du != 0.0f || ref.dv != 0.0f) {
+				for(auto it = mergedVertices.begin() + base; it != mergedVertices.end(); ++it) {
+					it->u += ref.du;
+					it->v += ref.dv;
+				}
+			}
+			for(uint32_t i=0; i<cmd.numIndices; i++) {
+				mergedIndices.push_back(base + list.indices[cmd.firstIndex + i]);
+			}
+		}
+		flush();
+
+		if(shaderUsed) {
+			al_use_shader(nullptr);
+		}
+		SetSeparateBlender(originalBlender);
+		for(CommandList* list: lists) {
+			list->clear();
+		}
+		return stats;
+	}
+
+}
+
+#endif //AXXEGRO_COMMANDBUFFER_HPP
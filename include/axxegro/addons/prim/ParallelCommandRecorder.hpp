@@ -0,0 +1,97 @@
+#ifndef AXXEGRO_PARALLELCOMMANDRECORDER_HPP
+#define AXXEGRO_PARALLELCOMMANDRECORDER_HPP
+
+#include "CommandBuffer.hpp"
+
+#include "../../com/util/ThreadPool.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace al {
+
+	/**
+	 * @brief A set of CommandLists ("recording contexts") that are filled in
+	 * parallel and drawn together by the thread that owns the display.
+	 *
+	 * Each context must be recorded by one thread at a time. The output only
+	 * depends on what goes into which context, not on thread scheduling: submit()
+	 * merges the contexts in index order and sorts stably, so commands with equal
+	 * DrawStates are drawn context by context, each in recording order. Give every
+	 * chunk of work its own context (as record() does) rather than one per thread
+	 * if the result has to be the same from frame to frame.
+	 *
+	 * Contexts keep their storage between frames.
+	 */
+	class ParallelCommandRecorder {
+	public:
+		explicit ParallelCommandRecorder(size_t numContexts = 0) {
+			resize(numContexts);
+		}
+
+		/// @brief Sets the number of contexts. Existing contexts keep their commands.
+		void resize(size_t numContexts) {
+			while(contexts.size() < numContexts) {
+				contexts.push_back(std::make_unique<CommandList>());
+			}
+			contexts.resize(numContexts);
+		}
+
+		[[nodiscard]] size_t size() const {
+			return contexts.size();
+		}
+
+		[[nodiscard]] CommandList& context(size_t index) {
+			return *contexts.at(index);
+		}
+
+		/**
+		 * @brief Calls fn(i, context(i)) for every i in [0, numJobs) on the pool's
+		 * threads, growing the set of contexts to at least numJobs.
+		 */
+		template<typename Fn>
+		void record(size_t numJobs, Fn&& fn, ThreadPool& pool = ThreadPool::Default()) {
+			if(contexts.size() < numJobs) {
+				resize(numJobs);
+			}
+			pool.parallelFor(numJobs, [&](size_t i) {
+				fn(i, *contexts[i]);
+			});
+		}
+
+		/**
+		 * @brief Draws the commands of all contexts as one sorted command buffer
+		 * (see CommandBuffer::execute()) and clears the contexts.
+		 * Must be called on the thread that owns the target bitmap.
+		 */
+		void submit() {
+			contextPtrs.clear();
+			for(auto& ctx: contexts) {
+				contextPtrs.push_back(ctx.get());
+			}
+			stats = executor.execute(contextPtrs);
+		}
+
+		/// @brief Discards the commands of all contexts.
+		void clear() {
+			for(auto& ctx: contexts) {
+				ctx->clear();
+			}
+		}
+
+		/// @return Statistics of the last submit().
+		[[nodiscard]] CommandBufferStats getLastStats() const {
+			return stats;
+		}
+
+	private:
+		/* pointers, so that resizing doesn't move contexts that may be handed out */
+		std::vector<std::unique_ptr<CommandList>> contexts;
+		std::vector<CommandList*> contextPtrs;
+		detail::CommandExecutor executor;
+		CommandBufferStats stats;
+	};
+
+}
+
+#endif //AXXEGRO_PARALLELCOMMANDRECORDER_HPP
@@ -0,0 +1,486 @@
+#ifndef INCLUDE_AXXEGRO_PRIM_PRIMBATCH
+#define INCLUDE_AXXEGRO_PRIM_PRIMBATCH
+
+#include "common.hpp"
+#include "PrimitivesAddon.hpp"
+#include "Vertex.hpp"
+#include "lldr.hpp"
+#include "Tessellate.hpp"
+#include "Stroke.hpp"
+
+#include <array>
+#include <vector>
+#include <span>
+#include <cmath>
+#include <numbers>
+#include <optional>
+
+/**
+ * @file
+ * CPU-side batching for the high level drawing routines
+ */
+
+namespace al {
+
+	class PrimBatch;
+
+	namespace detail {
+		inline thread_local PrimBatch* ActivePrimBatch = nullptr;
+
+		inline void FlushActivePrimBatch();
+	}
+
+	/**
+	 * @brief Accumulates shapes from the hldr.hpp family in a single vertex array
+	 * and draws them with as few al_draw_indexed_prim() calls as possible.
+	 *
+	 * A new draw call is only issued when the texture, blender or primitive type
+	 * (hairlines vs. filled geometry) changes, when flush() is called explicitly
+	 * or when the batch grows past its flush threshold.
+	 *
+	 * Geometry is drawn with the transform, target bitmap and shader that are
+	 * current at flush time, so flush() before changing any of these. The same
+	 * applies to geometry drawn directly with al::DrawPrim() and the like.
+	 * Curves get their segment counts from the transform that is current when
+	 * they are added, like in Allegro.
+	 *
+	 * Use ScopedPrimBatch to make al::DrawLine() and friends record into a batch.
+	 */
+	class PrimBatch {
+	public:
+		static constexpr size_t DefaultFlushThreshold = 1 << 18;
+
+		explicit PrimBatch(size_t flushThreshold = DefaultFlushThreshold)
+			: flushThreshold(flushThreshold)
+		{}
+
+		PrimBatch(const PrimBatch&) = delete;
+		PrimBatch& operator=(const PrimBatch&) = delete;
+
+		~PrimBatch() {
+			if(detail::ActivePrimBatch == this) {
+				detail::ActivePrimBatch = nullptr;
+			}
+		}
+
+		/**
+		 * @brief Sets the texture for subsequently added geometry.
+		 * Flushes the batch if the texture differs from the current one.
+		 */
+		void setTexture(OptionalRef<Bitmap> texture = std::nullopt) {
+			ALLEGRO_BITMAP* newTexture = texture ? texture->get().ptr() : nullptr;
+			if(newTexture != state.texture) {
+				flush();
+				state.texture = newTexture;
+			}
+		}
+
+		/**
+		 * @brief Sets the blender for subsequently added geometry.
+		 * std::nullopt means the blender that is current at flush time.
+		 */
+		void setBlender(std::optional<Blender> blender = std::nullopt) {
+			if(!SameBlender(blender, state.blender)) {
+				flush();
+				state.blender = blender;
+			}
+		}
+
+		/// @brief Draws all pending geometry and empties the batch.
+		void flush() {
+			if(indices.empty()) {
+				clear();
+				return;
+			}
+			InternalRequire<PrimitivesAddon>();
+			std::optional<ScopedBlender> scopedBlender;
+			if(state.blender) {
+				scopedBlender.emplace(*state.blender);
+			}
+			al_draw_indexed_prim(
+				vertices.data(),
+				nullptr,
+				state.texture,
+				indices.data(),
+				(int)indices.size(),
+				state.primType
+			);
+			numDrawCalls++;
+			clear();
+		}
+
+		/// @brief Discards all pending geometry.
+		void clear() {
+			vertices.clear();
+			indices.clear();
+		}
+
+		[[nodiscard]] size_t numPendingVertices() const {
+			return vertices.size();
+		}
+
+		[[nodiscard]] size_t numPendingIndices() const {
+			return indices.size();
+		}
+
+		/// @return The number of draw calls issued by this batch so far.
+		[[nodiscard]] int64_t getNumDrawCalls() const {
+			return numDrawCalls;
+		}
+
+		/**
+		 * @brief Adds arbitrary indexed geometry. Indices are relative to the first element of `vtxs`.
+		 */
+		void addIndexed(std::span<const BasicVertex> vtxs, std::span<const int> idxs, ALLEGRO_PRIM_TYPE type = ALLEGRO_PRIM_TRIANGLE_LIST) {
+			int base = begin(type, vtxs.size(), idxs.size());
+			vertices.insert(vertices.end(), vtxs.begin(), vtxs.end());
+			for(int idx: idxs) {
+				indices.push_back(base + idx);
+			}
+		}
+
+		/// @brief Adds a triangle list.
+		void addTriangles(std::span<const BasicVertex> vtxs) {
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, vtxs.size(), vtxs.size());
+			vertices.insert(vertices.end(), vtxs.begin(), vtxs.end());
+			for(int i=0; i<(int)vtxs.size(); i++) {
+				indices.push_back(base + i);
+			}
+		}
+
+		void addLine(const Vec2f& a, const Vec2f& b, const Color& color, float thickness) {
+			if(thickness <= 0) {
+				int base = begin(ALLEGRO_PRIM_LINE_LIST, 2, 2);
+				pushVertex(a, color);
+				pushVertex(b, color);
+				pushIndices(base, {0, 1});
+				return;
+			}
+			Vec2f dir = (b - a).normalizedOr({1.0f, 0.0f});
+			Vec2f n = Vec2f(-dir.y, dir.x) * (0.5f * thickness);
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, 4, 6);
+			pushVertex(a + n, color);
+			pushVertex(a - n, color);
+			pushVertex(b - n, color);
+			pushVertex(b + n, color);
+			pushIndices(base, {0, 1, 2, 0, 2, 3});
+		}
+
+		void addTriangle(const Vec2f& a, const Vec2f& b, const Vec2f& c, const Color& color, float thickness) {
+			const Vec2f pts[] = {a, b, c};
+			addClosedOutline(pts, color, thickness);
+		}
+
+		void addFilledTriangle(const Vec2f& a, const Vec2f& b, const Vec2f& c, const Color& color) {
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, 3, 3);
+			pushVertex(a, color);
+			pushVertex(b, color);
+			pushVertex(c, color);
+			pushIndices(base, {0, 1, 2});
+		}
+
+		void addRectangle(const RectF& r, const Color& color, float thickness) {
+			const Vec2f pts[] = {r.topLeft(), r.topRight(), r.bottomRight(), r.bottomLeft()};
+			addClosedOutline(pts, color, thickness);
+		}
+
+		void addFilledRectangle(const RectF& r, const Color& color) {
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, 4, 6);
+			pushVertex(r.topLeft(), color);
+			pushVertex(r.topRight(), color);
+			pushVertex(r.bottomRight(), color);
+			pushVertex(r.bottomLeft(), color);
+			pushIndices(base, {0, 1, 2, 0, 2, 3});
+		}
+
+		void addEllipticalArc(const Vec2f& center, const Vec2f& radius, float startTheta, float deltaTheta, const Color& color, float thickness) {
+			int numSegments = ArcSegmentCount((radius.x + radius.y) * 0.5f, deltaTheta);
+			addArcImpl(center, radius, startTheta, deltaTheta, numSegments, false, color, thickness);
+		}
+
+		void addArc(const Vec2f& center, float radius, float startTheta, float deltaTheta, const Color& color, float thickness) {
+			addEllipticalArc(center, {radius, radius}, startTheta, deltaTheta, color, thickness);
+		}
+
+		void addEllipse(const Vec2f& center, const Vec2f& radius, const Color& color, float thickness) {
+			constexpr float fullCircle = 2.0f * std::numbers::pi_v<float>;
+			int numSegments = ArcSegmentCount((radius.x + radius.y) * 0.5f, fullCircle);
+			addArcImpl(center, radius, 0.0f, fullCircle, numSegments, true, color, thickness);
+		}
+
+		void addCircle(const Vec2f& center, float radius, const Color& color, float thickness) {
+			addEllipse(center, {radius, radius}, color, thickness);
+		}
+
+		void addFilledEllipticalPieslice(const Vec2f& center, const Vec2f& radius, float startTheta, float deltaTheta, const Color& color) {
+			int numSegments = ArcSegmentCount((radius.x + radius.y) * 0.5f, deltaTheta);
+			int numPoints = numSegments + 1;
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, numPoints + 1, 3 * numSegments);
+			pushVertex(center, color);
+			ForEachArcPoint(startTheta, deltaTheta, numPoints, [&](Vec2f unit) {
+				pushVertex(center + unit.hadamard(radius), color);
+			});
+			for(int i=0; i<numSegments; i++) {
+				pushIndices(base, {0, i+1, i+2});
+			}
+		}
+
+		void addFilledEllipse(const Vec2f& center, const Vec2f& radius, const Color& color) {
+			constexpr float fullCircle = 2.0f * std::numbers::pi_v<float>;
+			int numSegments = ArcSegmentCount((radius.x + radius.y) * 0.5f, fullCircle);
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, numSegments + 1, 3 * numSegments);
+			pushVertex(center, color);
+			for(Vec2f unit: UnitCircle(numSegments)) {
+				pushVertex(center + unit.hadamard(radius), color);
+			}
+			for(int i=0; i<numSegments; i++) {
+				pushIndices(base, {0, i+1, (i+1) % numSegments + 1});
+			}
+		}
+
+		void addFilledCircle(const Vec2f& center, float radius, const Color& color) {
+			addFilledEllipse(center, {radius, radius}, color);
+		}
+
+		/// @brief Adds the outline of a pie slice as one closed path, so translucent edges don't overlap.
+		void addPieslice(const Vec2f& center, float radius, float startTheta, float deltaTheta, const Color& color, float thickness) {
+			scratchPoints.clear();
+			scratchPoints.push_back(center);
+			ForEachArcPoint(startTheta, deltaTheta, ArcSegmentCount(radius, deltaTheta) + 1, [&](Vec2f unit) {
+				scratchPoints.push_back(center + unit * radius);
+			});
+			addPolyline(scratchPoints, color, {.thickness = thickness}, true);
+		}
+
+		void addFilledPieslice(const Vec2f& center, float radius, float startTheta, float deltaTheta, const Color& color) {
+			addFilledEllipticalPieslice(center, {radius, radius}, startTheta, deltaTheta, color);
+		}
+
+		/**
+		 * @brief Adds a polyline, or a polygon outline if closed, as connected
+		 * line segments if style.thickness <= 0.
+		 */
+		void addPolyline(std::span<const Vec2f> points, const Color& color, const StrokeStyle& style, bool closed) {
+			if(style.thickness > 0) {
+				pathTessellator.clear();
+				pathTessellator.stroke(points, color, style, closed);
+				addIndexed(pathTessellator.getVertices(), pathTessellator.getIndices());
+				return;
+			}
+			int n = (int)points.size();
+			if(n < 2) {
+				return;
+			}
+			int numSegments = closed ? n : n - 1;
+			int base = begin(ALLEGRO_PRIM_LINE_LIST, n, 2 * numSegments);
+			for(const auto& p: points) {
+				pushVertex(p, color);
+			}
+			for(int i=0; i<numSegments; i++) {
+				pushIndices(base, {i, (i + 1) % n});
+			}
+		}
+
+		/// @brief Adds a filled simple polygon, which may be concave.
+		void addFilledPolygon(std::span<const Vec2f> points, const Color& color) {
+			pathTessellator.clear();
+			pathTessellator.fill(points, color);
+			addIndexed(pathTessellator.getVertices(), pathTessellator.getIndices());
+		}
+
+		/// @brief Adds a cubic Bezier spline, as a line strip if thickness <= 0.
+		void addSpline(const std::array<Vec2f, 4>& points, const Color& color, float thickness) {
+			int numSegments = SplineSegmentCount(points, thickness);
+			int numPoints = numSegments + 1;
+			if(thickness <= 0) {
+				int base = begin(ALLEGRO_PRIM_LINE_LIST, numPoints, 2 * numSegments);
+				ForEachSplinePoint(points, numPoints, [&](Vec2f pos, Vec2f) {
+					pushVertex(pos, color);
+				});
+				for(int i=0; i<numSegments; i++) {
+					pushIndices(base, {i, i+1});
+				}
+				return;
+			}
+
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, 2 * numPoints, 6 * numSegments);
+			size_t first = vertices.size();
+			vertices.resize(first + 2 * size_t(numPoints));
+			CalculateSpline(std::span(vertices).subspan(first), points, color, thickness);
+			for(int i=0; i<numSegments; i++) {
+				int j = i + 1;
+				pushIndices(base, {2*i, 2*i+1, 2*j+1, 2*i, 2*j+1, 2*j});
+			}
+		}
+
+	private:
+		struct State {
+			ALLEGRO_BITMAP* texture = nullptr;
+			std::optional<Blender> blender = std::nullopt;
+			ALLEGRO_PRIM_TYPE primType = ALLEGRO_PRIM_TRIANGLE_LIST;
+		};
+
+		static bool SameBlender(const std::optional<Blender>& a, const std::optional<Blender>& b) {
+			if(a.has_value() != b.has_value()) {
+				return false;
+			}
+			return !a || (a->op == b->op && a->src == b->src && a->dst == b->dst);
+		}
+
+		/* Prepares the batch for a primitive of the given type and size,
+		 * flushing if necessary. Returns the index of the first new vertex. */
+		int begin(ALLEGRO_PRIM_TYPE type, size_t numVertices, size_t numIndices) {
+			if(type != state.primType) {
+				flush();
+				state.primType = type;
+			} else if(vertices.size() + numVertices > flushThreshold) {
+				flush();
+			}
+			vertices.reserve(vertices.size() + numVertices);
+			indices.reserve(indices.size() + numIndices);
+			return (int)vertices.size();
+		}
+
+		void pushVertex(const Vec2f& pos, const Color& color) {
+			vertices.push_back(BasicVertex{
+				.x = pos.x, .y = pos.y, .z = 0.0f,
+				.u = 0.0f, .v = 0.0f,
+				.color = color
+			});
+		}
+
+		void pushIndices(int base, std::initializer_list<int> idxs) {
+			for(int idx: idxs) {
+				indices.push_back(base + idx);
+			}
+		}
+
+		/* Calls fn with the unit vectors of the outline points: an arc, or a
+		 * full circle from the UnitCircle() cache if closed. */
+		template<std::invocable<Vec2f> Fn>
+		static void forEachOutlinePoint(float startTheta, float deltaTheta, int numSegments, bool closed, Fn&& fn) {
+			if(closed) {
+				for(Vec2f unit: UnitCircle(numSegments)) {
+					fn(unit);
+				}
+				return;
+			}
+			ForEachArcPoint(startTheta, deltaTheta, numSegments + 1, fn);
+		}
+
+		/* startTheta and deltaTheta are ignored for closed outlines, which always start at angle 0 */
+		void addArcImpl(const Vec2f& center, const Vec2f& radius, float startTheta, float deltaTheta, int numSegments, bool closed, const Color& color, float thickness) {
+			int numPoints = closed ? numSegments : numSegments + 1;
+
+			if(thickness <= 0) {
+				int base = begin(ALLEGRO_PRIM_LINE_LIST, numPoints, 2 * numSegments);
+				forEachOutlinePoint(startTheta, deltaTheta, numSegments, closed, [&](Vec2f unit) {
+					pushVertex(center + unit.hadamard(radius), color);
+				});
+				for(int i=0; i<numSegments; i++) {
+					pushIndices(base, {i, (i + 1) % numPoints});
+				}
+				return;
+			}
+
+			Vec2f halfThickness {0.5f * thickness, 0.5f * thickness};
+			Vec2f outerRadius = radius + halfThickness;
+			Vec2f innerRadius = radius - halfThickness;
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, 2 * numPoints, 6 * numSegments);
+			forEachOutlinePoint(startTheta, deltaTheta, numSegments, closed, [&](Vec2f unit) {
+				pushVertex(center + unit.hadamard(outerRadius), color);
+				pushVertex(center + unit.hadamard(innerRadius), color);
+			});
+			for(int i=0; i<numSegments; i++) {
+				int j = (i + 1) % numPoints;
+				pushIndices(base, {2*i, 2*i+1, 2*j+1, 2*i, 2*j+1, 2*j});
+			}
+		}
+
+		/* Outline of a closed polygon with mitered corners. */
+		void addClosedOutline(std::span<const Vec2f> pts, const Color& color, float thickness) {
+			int n = (int)pts.size();
+			if(thickness <= 0) {
+				int base = begin(ALLEGRO_PRIM_LINE_LIST, n, 2 * n);
+				for(const auto& p: pts) {
+					pushVertex(p, color);
+				}
+				for(int i=0; i<n; i++) {
+					pushIndices(base, {i, (i + 1) % n});
+				}
+				return;
+			}
+
+			int base = begin(ALLEGRO_PRIM_TRIANGLE_LIST, 2 * n, 6 * n);
+			for(int i=0; i<n; i++) {
+				const Vec2f& prev = pts[(i + n - 1) % n];
+				const Vec2f& cur = pts[i];
+				const Vec2f& next = pts[(i + 1) % n];
+				Vec2f d1 = (cur - prev).normalizedOr({1.0f, 0.0f});
+				Vec2f d2 = (next - cur).normalizedOr(d1);
+				Vec2f n1 {-d1.y, d1.x};
+				Vec2f n2 {-d2.y, d2.x};
+				Vec2f miter = (n1 + n2).normalizedOr(n1);
+				float cosHalf = std::max(miter.dot(n1), 0.1f);
+				Vec2f offset = miter * (0.5f * thickness / cosHalf);
+				pushVertex(cur + offset, color);
+				pushVertex(cur - offset, color);
+			}
+			for(int i=0; i<n; i++) {
+				int j = (i + 1) % n;
+				pushIndices(base, {2*i, 2*i+1, 2*j+1, 2*i, 2*j+1, 2*j});
+			}
+		}
+
+		std::vector<BasicVertex> vertices;
+		std::vector<int> indices;
+		PathTessellator pathTessellator;
+		std::vector<Vec2f> scratchPoints;
+		State state;
+		size_t flushThreshold;
+		int64_t numDrawCalls = 0;
+	};
+
+	/**
+	 * @brief Makes the free functions from hldr.hpp (al::DrawLine() etc.)
+	 * record into the given batch instead of drawing immediately.
+	 * The batch is flushed and the previously active batch restored on destruction.
+	 */
+	class ScopedPrimBatch {
+	public:
+		explicit ScopedPrimBatch(PrimBatch& batch)
+			: batch(batch), previous(detail::ActivePrimBatch)
+		{
+			if(previous) {
+				previous->flush();
+			}
+			detail::ActivePrimBatch = &batch;
+		}
+
+		~ScopedPrimBatch() {
+			batch.flush();
+			detail::ActivePrimBatch = previous;
+		}
+
+		ScopedPrimBatch(const ScopedPrimBatch&) = delete;
+		ScopedPrimBatch& operator=(const ScopedPrimBatch&) = delete;
+		ScopedPrimBatch(ScopedPrimBatch&&) = delete;
+		ScopedPrimBatch& operator=(ScopedPrimBatch&&) = delete;
+	private:
+		PrimBatch& batch;
+		PrimBatch* previous;
+	};
+
+	/// @return The batch that al::DrawLine() and friends currently record into, or nullptr.
+	inline PrimBatch* GetActivePrimBatch() {
+		return detail::ActivePrimBatch;
+	}
+
+	inline void detail::FlushActivePrimBatch() {
+		if(ActivePrimBatch) {
+			ActivePrimBatch->flush();
+		}
+	}
+}
+
+#endif /* INCLUDE_AXXEGRO_PRIM_PRIMBATCH */
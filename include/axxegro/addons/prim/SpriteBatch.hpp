@@ -0,0 +1,275 @@
+#ifndef INCLUDE_AXXEGRO_PRIM_SPRITEBATCH
+#define INCLUDE_AXXEGRO_PRIM_SPRITEBATCH
+
+#include "common.hpp"
+#include "PrimitivesAddon.hpp"
+#include "Vertex.hpp"
+#include "buffers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @file
+ * Drawing many textured quads with a handful of draw calls
+ */
+
+namespace al {
+
+	class StaticSpriteBatch;
+
+	namespace detail {
+		struct SpriteRecord {
+			ALLEGRO_BITMAP* texture;
+			float u0, v0, u1, v1;
+			float w, h;
+			float m00, m01, m10, m11, tx, ty;
+			ALLEGRO_COLOR tint;
+		};
+
+		struct SpriteRun {
+			ALLEGRO_BITMAP* texture;
+			int firstSprite;
+			int numSprites;
+		};
+
+		/* appends 0,1,2, 0,2,3, 4,5,6, 4,6,7, ... until there are indices for numSprites quads */
+		inline void GrowQuadIndices(std::vector<int>& indices, size_t numSprites) {
+			size_t oldSprites = indices.size() / 6;
+			if(oldSprites < numSprites) {
+				indices.reserve(numSprites * 6);
+				for(size_t i=oldSprites; i<numSprites; i++) {
+					int b = int(i) * 4;
+					indices.insert(indices.end(), {b+0, b+1, b+2, b+0, b+2, b+3});
+				}
+			}
+		}
+
+		inline void ExpandSprite(const SpriteRecord& s, BasicVertex* out) {
+			auto vtx = [&](float lx, float ly, float u, float v) {
+				return BasicVertex{
+					.x = s.m00 * lx + s.m10 * ly + s.tx,
+					.y = s.m01 * lx + s.m11 * ly + s.ty,
+					.z = 0.0f,
+					.u = u, .v = v,
+					.color = s.tint
+				};
+			};
+			out[0] = vtx(0.0f, 0.0f, s.u0, s.v0);
+			out[1] = vtx(s.w,  0.0f, s.u1, s.v0);
+			out[2] = vtx(s.w,  s.h,  s.u1, s.v1);
+			out[3] = vtx(0.0f, s.h,  s.u0, s.v1);
+		}
+	}
+
+	/**
+	 * @brief Collects textured quads ("sprites") and draws them as one
+	 * al_draw_indexed_prim() call per texture.
+	 *
+	 * Sub-bitmaps are resolved to their parent bitmap, so sprites taken from
+	 * the same sheet or TextureAtlas page share a draw call.
+	 *
+	 * Sprites are drawn with the transform, blender and target that are current
+	 * when draw() is called. Texture coordinates are in pixels, as with ALLEGRO_VERTEX.
+	 */
+	class SpriteBatch {
+	public:
+		enum class SortMode {
+			/// Draw in submission order; a new draw call starts whenever the texture changes.
+			None,
+			/// Group sprites by texture (stable within a texture). Use when sprites don't overlap or order doesn't matter.
+			Texture
+		};
+
+		explicit SpriteBatch(SortMode sortMode = SortMode::Texture)
+			: sortMode(sortMode)
+		{}
+
+		/**
+		 * @brief Adds a sprite. The srcRect-sized quad with its top left corner at
+		 * the origin is mapped through `transform` (only its 2D affine part is used).
+		 */
+		void add(const Bitmap& texture, const RectF& srcRect, const Transform& transform, Color tint = White) {
+			detail::SpriteRecord& s = pushRecord(texture, srcRect, tint);
+			s.m00 = transform.m[0][0];
+			s.m01 = transform.m[0][1];
+			s.m10 = transform.m[1][0];
+			s.m11 = transform.m[1][1];
+			s.tx = transform.m[3][0];
+			s.ty = transform.m[3][1];
+		}
+
+		/**
+		 * @brief Adds a sprite with the same parameters as Bitmap::drawTintedScaledRotatedRegion():
+		 * `centerSrc` (relative to srcRect) ends up at `centerDst`, scaled and then rotated by `angle` radians.
+		 */
+		void add(const Bitmap& texture, const RectF& srcRect, Vec2f centerSrc, Vec2f centerDst, Vec2f scale = {1.0f, 1.0f}, float angle = 0.0f, Color tint = White) {
+			detail::SpriteRecord& s = pushRecord(texture, srcRect, tint);
+			float c = std::cos(angle);
+			float sn = std::sin(angle);
+			s.m00 = c * scale.x;
+			s.m01 = sn * scale.x;
+			s.m10 = -sn * scale.y;
+			s.m11 = c * scale.y;
+			s.tx = centerDst.x - (s.m00 * centerSrc.x + s.m10 * centerSrc.y);
+			s.ty = centerDst.y - (s.m01 * centerSrc.x + s.m11 * centerSrc.y);
+		}
+
+		/// @brief Adds the whole bitmap, unscaled, with its top left corner at `pos`.
+		void add(const Bitmap& texture, Vec2f pos, Color tint = White) {
+			detail::SpriteRecord& s = pushRecord(texture, RectF(texture.rect()), tint);
+			s.m00 = 1.0f;
+			s.m01 = 0.0f;
+			s.m10 = 0.0f;
+			s.m11 = 1.0f;
+			s.tx = pos.x;
+			s.ty = pos.y;
+		}
+
+		/// @brief Draws all sprites and clears the batch.
+		void draw() {
+			buildRuns();
+			expand();
+			InternalRequire<PrimitivesAddon>();
+			detail::GrowQuadIndices(indices, sprites.size());
+			for(const auto& run: runs) {
+				al_draw_indexed_prim(
+					vertices.data() + 4 * run.firstSprite,
+					nullptr,
+					run.texture,
+					indices.data(),
+					6 * run.numSprites,
+					ALLEGRO_PRIM_TRIANGLE_LIST
+				);
+			}
+			lastNumDrawCalls = (int)runs.size();
+			clear();
+		}
+
+		/**
+		 * @brief Uploads the sprites to a vertex/index buffer pair for drawing
+		 * many times without re-submitting them. The sprites stay in the batch.
+		 */
+		[[nodiscard]] StaticSpriteBatch bake(int flags = ALLEGRO_PRIM_BUFFER_STATIC);
+
+		/// @brief Removes all sprites without drawing them.
+		void clear() {
+			sprites.clear();
+		}
+
+		[[nodiscard]] size_t size() const {
+			return sprites.size();
+		}
+
+		/// @return The number of draw calls issued by the last draw().
+		[[nodiscard]] int getLastNumDrawCalls() const {
+			return lastNumDrawCalls;
+		}
+
+		void setSortMode(SortMode mode) {
+			sortMode = mode;
+		}
+
+	private:
+		detail::SpriteRecord& pushRecord(const Bitmap& texture, const RectF& srcRect, Color tint) {
+			ALLEGRO_BITMAP* bmp = texture.ptr();
+			float ox = 0.0f, oy = 0.0f;
+			if(ALLEGRO_BITMAP* parent = al_get_parent_bitmap(bmp)) {
+				ox = float(al_get_bitmap_x(bmp));
+				oy = float(al_get_bitmap_y(bmp));
+				bmp = parent;
+			}
+			detail::SpriteRecord& s = sprites.emplace_back();
+			s.texture = bmp;
+			s.u0 = srcRect.a.x + ox;
+			s.v0 = srcRect.a.y + oy;
+			s.u1 = srcRect.b.x + ox;
+			s.v1 = srcRect.b.y + oy;
+			s.w = srcRect.width();
+			s.h = srcRect.height();
+			s.tint = tint;
+			return s;
+		}
+
+		void buildRuns() {
+			if(sortMode == SortMode::Texture) {
+				std::stable_sort(sprites.begin(), sprites.end(), [](const auto& l, const auto& r) {
+					return l.texture < r.texture;
+				});
+			}
+			runs.clear();
+			for(int i=0; i<(int)sprites.size(); i++) {
+				if(runs.empty() || runs.back().texture != sprites[i].texture) {
+					runs.push_back({sprites[i].texture, i, 0});
+				}
+				runs.back().numSprites++;
+			}
+		}
+
+		void expand() {
+			vertices.resize(sprites.size() * 4);
+			for(size_t i=0; i<sprites.size(); i++) {
+				detail::ExpandSprite(sprites[i], vertices.data() + 4*i);
+			}
+		}
+
+		SortMode sortMode;
+		std::vector<detail::SpriteRecord> sprites;
+		std::vector<detail::SpriteRun> runs;
+		std::vector<BasicVertex> vertices;
+		std::vector<int> indices;
+		int lastNumDrawCalls = 0;
+	};
+
+	/**
+	 * @brief Sprites stored in GPU buffers, created with SpriteBatch::bake().
+	 * The textures must outlive this object.
+	 */
+	class StaticSpriteBatch {
+	public:
+		void draw() const {
+			for(const auto& run: runs) {
+				al_draw_indexed_buffer(
+					vertexBuffer.ptr(),
+					run.texture,
+					indexBuffer.ptr(),
+					6 * run.firstSprite,
+					6 * (run.firstSprite + run.numSprites),
+					ALLEGRO_PRIM_TRIANGLE_LIST
+				);
+			}
+		}
+
+		[[nodiscard]] int getNumDrawCalls() const {
+			return (int)runs.size();
+		}
+
+	private:
+		friend class SpriteBatch;
+
+		StaticSpriteBatch(std::span<BasicVertex> vertices, std::span<int> indices, std::vector<detail::SpriteRun> runs, int flags)
+			: vertexBuffer(vertices, flags),
+			  indexBuffer(indices, flags),
+			  runs(std::move(runs))
+		{}
+
+		VertexBuffer<BasicVertex> vertexBuffer;
+		IndexBuffer<int> indexBuffer;
+		std::vector<detail::SpriteRun> runs;
+	};
+
+	inline StaticSpriteBatch SpriteBatch::bake(int flags) {
+		if(sprites.empty()) {
+			throw VertexBufferError("Cannot bake an empty sprite batch");
+		}
+		buildRuns();
+		expand();
+		detail::GrowQuadIndices(indices, sprites.size());
+		auto usedIndices = std::span(indices).first(6 * sprites.size());
+		return StaticSpriteBatch(std::span(vertices), usedIndices, runs, flags);
+	}
+
+}
+
+#endif /* INCLUDE_AXXEGRO_PRIM_SPRITEBATCH */
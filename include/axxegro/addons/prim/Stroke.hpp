@@ -0,0 +1,388 @@
+#ifndef AXXEGRO_PRIM_STROKE_HPP
+#define AXXEGRO_PRIM_STROKE_HPP
+
+#include "common.hpp"
+#include "PrimitivesAddon.hpp"
+#include "Vertex.hpp"
+#include "lldr.hpp"
+#include "Tessellate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <span>
+#include <vector>
+
+/**
+ * @file
+ * Stroking of polylines and polygons, and triangulation of filled polygons
+ */
+
+namespace al {
+
+	enum class LineJoin {
+		Bevel,
+		Round,
+		Miter
+	};
+
+	enum class LineCap {
+		Butt,
+		Square,
+		Round,
+		Triangle
+	};
+
+	struct StrokeStyle {
+		float thickness = 1.0f;
+		LineJoin join = LineJoin::Miter;
+		LineCap cap = LineCap::Butt;
+
+		/// Miter joins reaching further than this many half-thicknesses from the point are beveled.
+		float miterLimit = 4.0f;
+	};
+
+	namespace detail {
+		inline float Cross(Vec2f a, Vec2f b) {
+			return a.x * b.y - a.y * b.x;
+		}
+
+		inline Vec2f Perp(Vec2f v) {
+			return {-v.y, v.x};
+		}
+	}
+
+	/**
+	 * @brief Turns polylines and polygons into indexed triangle lists: thick
+	 * outlines with joins and caps, and fills of concave polygons.
+	 *
+	 * Geometry is appended to one vertex and index array that can be drawn with
+	 * draw(), added to a PrimBatch, uploaded to an IndexBuffer/VertexBuffer pair
+	 * or expanded into a plain triangle list with writeTriangles(). The arrays
+	 * and all scratch memory keep their capacity across clear(), so reusing one
+	 * tessellator doesn't allocate once it has warmed up.
+	 *
+	 * Each polyline is a single mesh, so there are no seams or overdraw between
+	 * segments, except where a segment is shorter than its inner join.
+	 */
+	class PathTessellator {
+	public:
+		/**
+		 * @brief Appends the outline of a polyline, or of a polygon if closed.
+		 * Consecutive duplicate points are skipped.
+		 *
+		 * Only thick lines are supported: nothing is added if the thickness is
+		 * not positive. Draw hairlines as a line strip instead.
+		 */
+		void stroke(std::span<const Vec2f> path, const Color& color, const StrokeStyle& style = {}, bool closed = false) {
+			if(style.thickness <= 0) {
+				return;
+			}
+			closed = preparePoints(path, closed);
+			int n = int(points.size());
+			if(n < 2) {
+				return;
+			}
+			this->color = color;
+			this->style = style;
+			halfThickness = 0.5f * style.thickness;
+			vertices.reserve(vertices.size() + 4 * size_t(n) + 8);
+			indices.reserve(indices.size() + 12 * size_t(n) + 12);
+
+			if(closed) {
+				Joint first = addJoint(points[n-1], points[0], points[1]);
+				Edge prevStart = first.start;
+				for(int i=1; i<n; i++) {
+					Joint joint = addJoint(points[i-1], points[i], points[(i+1) % n]);
+					addQuad(prevStart, joint.end);
+					prevStart = joint.start;
+				}
+				addQuad(prevStart, first.end);
+				return;
+			}
+
+			Edge prevStart = addCap(points[0], points[1], true);
+			for(int i=1; i<n-1; i++) {
+				Joint joint = addJoint(points[i-1], points[i], points[i+1]);
+				addQuad(prevStart, joint.end);
+				prevStart = joint.start;
+			}
+			addQuad(prevStart, addCap(points[n-1], points[n-2], false));
+		}
+
+		/**
+		 * @brief Appends the triangulation of a simple polygon, which may be
+		 * concave. Either winding order works.
+		 *
+		 * Uses ear clipping, which takes O(n^2) time. Self-intersecting polygons
+		 * still produce triangles, though not necessarily the expected ones.
+		 */
+		void fill(std::span<const Vec2f> polygon, const Color& color) {
+			preparePoints(polygon, true);
+			int n = int(points.size());
+			if(n < 3) {
+				return;
+			}
+			int base = int(vertices.size());
+			vertices.reserve(vertices.size() + size_t(n));
+			indices.reserve(indices.size() + 3 * size_t(n - 2));
+			float area = 0;
+			for(int i=0; i<n; i++) {
+				detail::StorePoint(vertices.emplace_back(), points[i], color);
+				area += detail::Cross(points[i], points[(i+1) % n]);
+			}
+			float orientation = area < 0 ? -1.0f : 1.0f;
+
+			prev.resize(size_t(n));
+			next.resize(size_t(n));
+			for(int i=0; i<n; i++) {
+				prev[i] = (i + n - 1) % n;
+				next[i] = (i + 1) % n;
+			}
+
+			int remaining = n;
+			int cur = 0;
+			int sinceLastEar = 0;
+			while(remaining > 3) {
+				int a = prev[cur], c = next[cur];
+				/* if a whole lap found no ear, the input isn't simple; clip anyway to make progress */
+				if(isEar(a, cur, c, orientation) || sinceLastEar >= remaining) {
+					pushTriangle(base + a, base + cur, base + c);
+					next[a] = c;
+					prev[c] = a;
+					remaining--;
+					sinceLastEar = 0;
+				} else {
+					sinceLastEar++;
+				}
+				cur = c;
+			}
+			pushTriangle(base + prev[cur], base + cur, base + next[cur]);
+		}
+
+		/// @brief Removes all geometry. Allocated memory is kept for reuse.
+		void clear() {
+			vertices.clear();
+			indices.clear();
+		}
+
+		[[nodiscard]] std::span<const BasicVertex> getVertices() const {
+			return vertices;
+		}
+
+		[[nodiscard]] std::span<const int> getIndices() const {
+			return indices;
+		}
+
+		/// @return The number of vertices writeTriangles() writes (three per triangle).
+		[[nodiscard]] size_t numTriangleVertices() const {
+			return indices.size();
+		}
+
+		/**
+		 * @brief Writes the geometry as a non-indexed triangle list, e.g. into
+		 * a locked VertexBuffer<BasicVertex>.
+		 * @return The number of vertices written, at most out.size().
+		 */
+		size_t writeTriangles(std::span<BasicVertex> out) const {
+			size_t num = std::min(out.size(), indices.size());
+			for(size_t i=0; i<num; i++) {
+				out[i] = vertices[size_t(indices[i])];
+			}
+			return num;
+		}
+
+		/// @brief Draws the geometry with al_draw_indexed_prim().
+		void draw(OptionalRef<Bitmap> texture = std::nullopt) const {
+			if(!indices.empty()) {
+				DrawIndexedPrim(vertices, indices, texture);
+			}
+		}
+
+	private:
+		/* vertex indices at the left and right side of the line, looking along it */
+		struct Edge {
+			int left;
+			int right;
+		};
+
+		/* where the segment ending at a point ends and where the next one starts */
+		struct Joint {
+			Edge end;
+			Edge start;
+		};
+
+		bool preparePoints(std::span<const Vec2f> path, bool closed) {
+			points.clear();
+			for(const auto& p: path) {
+				if(points.empty() || !points.back().almostEqual(p)) {
+					points.push_back(p);
+				}
+			}
+			if(closed && points.size() > 1 && points.back().almostEqual(points.front())) {
+				points.pop_back();
+			}
+			return closed && points.size() > 2;
+		}
+
+		int pushVertex(Vec2f pos) {
+			detail::StorePoint(vertices.emplace_back(), pos, color);
+			return int(vertices.size()) - 1;
+		}
+
+		void pushTriangle(int a, int b, int c) {
+			indices.push_back(a);
+			indices.push_back(b);
+			indices.push_back(c);
+		}
+
+		void addQuad(Edge from, Edge to) {
+			pushTriangle(from.left, from.right, to.right);
+			pushTriangle(from.left, to.right, to.left);
+		}
+
+		/* fan around center over the arc from `from` to `to`, both already pushed */
+		void addArcFan(int center, Vec2f pos, Vec2f startDir, float deltaTheta, int from, int to) {
+			int numSegments = ArcSegmentCount(halfThickness, deltaTheta);
+			int last = from;
+			int i = 0;
+			ForEachArcPoint(std::atan2(startDir.y, startDir.x), deltaTheta, numSegments + 1, [&](Vec2f unit) {
+				if(i++ == 0 || i > numSegments) {
+					return;
+				}
+				int v = pushVertex(pos + unit * halfThickness);
+				pushTriangle(center, last, v);
+				last = v;
+			});
+			pushTriangle(center, last, to);
+		}
+
+		Edge addCap(Vec2f pos, Vec2f neighbor, bool isStart) {
+			Vec2f dir = (isStart ? neighbor - pos : pos - neighbor).normalizedOr({1.0f, 0.0f});
+			Vec2f normal = detail::Perp(dir) * halfThickness;
+			Vec2f outward = (isStart ? -dir : dir) * halfThickness;
+			Vec2f base = style.cap == LineCap::Square ? pos + outward : pos;
+			Edge ret {pushVertex(base + normal), pushVertex(base - normal)};
+
+			if(style.cap == LineCap::Round) {
+				/* rotating the left normal by +pi goes backwards at the start and forwards at the end */
+				float delta = isStart ? std::numbers::pi_v<float> : -std::numbers::pi_v<float>;
+				addArcFan(pushVertex(pos), pos, normal, delta, ret.left, ret.right);
+			} else if(style.cap == LineCap::Triangle) {
+				pushTriangle(ret.left, pushVertex(pos + outward), ret.right);
+			}
+			return ret;
+		}
+
+		Joint addJoint(Vec2f before, Vec2f pos, Vec2f after) {
+			Vec2f d0 = pos - before;
+			Vec2f d1 = after - pos;
+			float len0 = float(d0.length());
+			float len1 = float(d1.length());
+			d0 /= len0;
+			d1 /= len1;
+			Vec2f n0 = detail::Perp(d0);
+			Vec2f n1 = detail::Perp(d1);
+			float cross = detail::Cross(d0, d1);
+			float dot = d0.dot(d1);
+			float hw = halfThickness;
+
+			if(std::abs(cross) < 1e-6f && dot > 0) {
+				Edge edge {pushVertex(pos + n0 * hw), pushVertex(pos - n0 * hw)};
+				return {edge, edge};
+			}
+
+			/* the side the line turns towards; the join is added on the other side */
+			float inSign = cross > 0 ? 1.0f : -1.0f;
+			float outSign = -inSign;
+			Vec2f miterDir = (n0 + n1).normalizedOr({0.0f, 0.0f});
+			float cosHalf = miterDir.dot(n0);
+			bool canMiter = cosHalf > 1e-4f;
+
+			/* Meet the segments at the intersection of their inner sides if that is
+			 * within the first half of both, so that the joints at either end of
+			 * a segment can't cross. Otherwise, overlap them at the inner side. */
+			bool innerMiter = false;
+			if(canMiter) {
+				float sinHalf = std::sqrt(std::max(0.0f, 1.0f - cosHalf * cosHalf));
+				innerMiter = hw * sinHalf / cosHalf <= 0.5f * std::min(len0, len1);
+			}
+			int center, inner0, inner1;
+			if(innerMiter) {
+				center = inner0 = inner1 = pushVertex(pos + miterDir * (inSign * hw / cosHalf));
+			} else {
+				center = pushVertex(pos);
+				inner0 = pushVertex(pos + n0 * (inSign * hw));
+				inner1 = pushVertex(pos + n1 * (inSign * hw));
+			}
+			int outer0 = pushVertex(pos + n0 * (outSign * hw));
+			int outer1 = pushVertex(pos + n1 * (outSign * hw));
+
+			switch(style.join) {
+				case LineJoin::Miter:
+					if(canMiter && 1.0f / cosHalf <= style.miterLimit) {
+						int tip = pushVertex(pos + miterDir * (outSign * hw / cosHalf));
+						pushTriangle(center, outer0, tip);
+						pushTriangle(center, tip, outer1);
+						break;
+					}
+					pushTriangle(center, outer0, outer1);
+					break;
+				case LineJoin::Bevel:
+					pushTriangle(center, outer0, outer1);
+					break;
+				case LineJoin::Round: {
+					/* the outer normal turns by the same angle as the line; a U-turn goes around the far side */
+					float turn = inSign * std::abs(std::atan2(cross, dot));
+					if(std::abs(cross) < 1e-6f) {
+						turn = inSign * std::numbers::pi_v<float>;
+					}
+					addArcFan(center, pos, n0 * outSign, turn, outer0, outer1);
+					break;
+				}
+			}
+
+			if(inSign > 0) {
+				return {{inner0, outer0}, {inner1, outer1}};
+			}
+			return {{outer0, inner0}, {outer1, inner1}};
+		}
+
+		bool isEar(int a, int b, int c, float orientation) const {
+			Vec2f pa = points[a], pb = points[b], pc = points[c];
+			float convexity = detail::Cross(pb - pa, pc - pb) * orientation;
+			if(convexity < 0) {
+				return false;
+			}
+			if(convexity == 0) {
+				return true; //collinear: clipping it adds a degenerate triangle, which is harmless
+			}
+			for(int p = next[c]; p != a; p = next[p]) {
+				Vec2f pp = points[p];
+				if(pp.almostEqual(pa) || pp.almostEqual(pb) || pp.almostEqual(pc)) {
+					continue;
+				}
+				if(detail::Cross(pb - pa, pp - pa) * orientation >= 0
+					&& detail::Cross(pc - pb, pp - pb) * orientation >= 0
+					&& detail::Cross(pa - pc, pp - pc) * orientation >= 0) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		std::vector<BasicVertex> vertices;
+		std::vector<int> indices;
+
+		std::vector<Vec2f> points;
+		std::vector<int> prev;
+		std::vector<int> next;
+
+		Color color;
+		StrokeStyle style;
+		float halfThickness = 0.5f;
+	};
+
+}
+
+#endif //AXXEGRO_PRIM_STROKE_HPP
@@ -0,0 +1,301 @@
+#ifndef AXXEGRO_PRIM_TESSELLATE_HPP
+#define AXXEGRO_PRIM_TESSELLATE_HPP
+
+#include "common.hpp"
+#include "Vertex.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <numbers>
+#include <span>
+#include <vector>
+
+/**
+ * @file
+ * Allocation-free tessellation of arcs, ellipses and splines into
+ * caller-provided point or vertex arrays
+ */
+
+namespace al {
+
+	namespace detail {
+		/* Same heuristic as Allegro's primitives addon: the number of segments
+		 * grows with the square root of the on-screen radius. */
+		constexpr float PrimQuality = 10.0f;
+		constexpr int MaxArcSegments = 256;
+		/* ALLEGRO_VERTEX_CACHE_SIZE, which caps the number of points in al_draw_spline() */
+		constexpr int AllegroVertexCacheSize = 256;
+
+		/* sqrt(|det|) of the 2D part, i.e. how much the transform scales lengths on average */
+		inline float LinearScale(const ALLEGRO_TRANSFORM& t) {
+			return std::sqrt(std::abs(t.m[0][0] * t.m[1][1] - t.m[0][1] * t.m[1][0]));
+		}
+
+		inline void StorePoint(Vec2f& out, Vec2f pos, const Color&) {
+			out = pos;
+		}
+
+		inline void StorePoint(BasicVertex& out, Vec2f pos, const Color& color) {
+			out = BasicVertex{
+				.x = pos.x, .y = pos.y, .z = 0.0f,
+				.u = 0.0f, .v = 0.0f,
+				.color = color
+			};
+		}
+
+		/* outward normal of an ellipse at the point with the given unit angle vector */
+		inline Vec2f EllipseNormal(Vec2f unit, Vec2f radius) {
+			if(radius.x == radius.y) {
+				return unit;
+			}
+			return Vec2f(radius.y * unit.x, radius.x * unit.y).normalizedOr(unit);
+		}
+
+		template<typename T>
+		void StoreEllipsePoint(std::span<T> out, size_t i, Vec2f center, Vec2f radius, Vec2f unit, float thickness, const Color& color) {
+			Vec2f pos = center + unit.hadamard(radius);
+			if(thickness <= 0) {
+				StorePoint(out[i], pos, color);
+				return;
+			}
+			Vec2f offset = EllipseNormal(unit, radius) * (0.5f * thickness);
+			StorePoint(out[2*i], pos + offset, color);
+			StorePoint(out[2*i + 1], pos - offset, color);
+		}
+	}
+
+	/**
+	 * @return How much the transform scales lengths (the square root of the
+	 * determinant of its 2D part).
+	 */
+	inline float TessellationScale(const Transform& transform) {
+		return detail::LinearScale(transform);
+	}
+
+	/// @return How much the current transform scales lengths.
+	inline float TessellationScale() {
+		const ALLEGRO_TRANSFORM* t = RenderStateCache::ThisThread().getCurrentTransform();
+		return t ? detail::LinearScale(*t) : 1.0f;
+	}
+
+	/**
+	 * @brief The number of segments to approximate an arc with, using the same
+	 * heuristic as Allegro: it grows with the square root of the on-screen radius.
+	 * @param scale How much the transform the arc is drawn with scales lengths.
+	 * By default, the current transform is used.
+	 */
+	inline int ArcSegmentCount(float radius, float deltaTheta, float scale = TessellationScale()) {
+		float fullCircleSegments = detail::PrimQuality * std::sqrt(std::abs(radius * scale));
+		int ret = int(fullCircleSegments * std::abs(deltaTheta) / (2.0f * std::numbers::pi_v<float>));
+		return std::clamp(ret, 2, detail::MaxArcSegments);
+	}
+
+	/**
+	 * @brief The number of segments to approximate a cubic Bezier spline with,
+	 * using the same heuristic as al_draw_spline(): it grows with the square root
+	 * of the on-screen length of the control polygon, and is capped so that the
+	 * points fit in Allegro's vertex cache.
+	 * @param thickness The thickness the spline is drawn with; thick splines are capped lower.
+	 * @param scale How much the transform the spline is drawn with scales lengths.
+	 * By default, the current transform is used.
+	 */
+	inline int SplineSegmentCount(const std::array<Vec2f, 4>& points, float thickness, float scale = TessellationScale()) {
+		float length = 0;
+		for(int i=0; i<3; i++) {
+			length += float((points[i+1] - points[i]).length());
+		}
+		/* Allegro's count is of points, not segments */
+		int numPoints = std::max(int(std::sqrt(length) * 1.2f * detail::PrimQuality * scale / 10.0f), 2);
+		int maxPoints = thickness > 0 ? (detail::AllegroVertexCacheSize - 1) / 2 : detail::AllegroVertexCacheSize - 1;
+		return std::min(numPoints, maxPoints) - 1;
+	}
+
+	/**
+	 * @return numPoints evenly spaced unit vectors around the circle, starting
+	 * at angle 0. Tables are computed once per thread and point count, so drawing
+	 * many circles with the same segment count only scales and offsets a copy.
+	 * @throws OutOfRangeError if numPoints is negative or more than
+	 * detail::MaxArcSegments; use ForEachCirclePoint() for those.
+	 */
+	inline std::span<const Vec2f> UnitCircle(int numPoints) {
+		if(numPoints < 0 || numPoints > detail::MaxArcSegments) {
+			throw OutOfRangeError("UnitCircle() only caches up to %d points, %d requested", detail::MaxArcSegments, numPoints);
+		}
+		thread_local std::array<std::vector<Vec2f>, detail::MaxArcSegments + 1> cache;
+		auto& table = cache[size_t(numPoints)];
+		if(table.empty() && numPoints > 0) {
+			table.resize(size_t(numPoints));
+			for(int i=0; i<numPoints; i++) {
+				double theta = 2.0 * std::numbers::pi * double(i) / double(numPoints);
+				table[size_t(i)] = {float(std::cos(theta)), float(std::sin(theta))};
+			}
+		}
+		return table;
+	}
+
+	/**
+	 * @brief Calls fn with numPoints evenly spaced unit vectors around the
+	 * circle, starting at angle 0. They come from the UnitCircle() cache if
+	 * numPoints is small enough, and are computed directly otherwise.
+	 */
+	template<std::invocable<Vec2f> Fn>
+	void ForEachCirclePoint(int numPoints, Fn&& fn) {
+		if(numPoints <= detail::MaxArcSegments) {
+			for(Vec2f unit: UnitCircle(std::max(numPoints, 0))) {
+				fn(unit);
+			}
+			return;
+		}
+		for(int i=0; i<numPoints; i++) {
+			double theta = 2.0 * std::numbers::pi * double(i) / double(numPoints);
+			fn(Vec2f(float(std::cos(theta)), float(std::sin(theta))));
+		}
+	}
+
+	/**
+	 * @brief Calls fn with numPoints evenly spaced unit vectors from startTheta
+	 * to startTheta+deltaTheta (inclusive). Uses an incremental rotation like
+	 * Allegro, so only four sines and cosines are computed per arc.
+	 */
+	template<std::invocable<Vec2f> Fn>
+	void ForEachArcPoint(float startTheta, float deltaTheta, int numPoints, Fn&& fn) {
+		float step = numPoints > 1 ? deltaTheta / float(numPoints - 1) : 0.0f;
+		float c = std::cos(step);
+		float s = std::sin(step);
+		Vec2f p {std::cos(startTheta), std::sin(startTheta)};
+		for(int i=0; i<numPoints; i++) {
+			fn(p);
+			p = {p.x * c - p.y * s, p.x * s + p.y * c};
+		}
+	}
+
+	/**
+	 * @brief Calls fn(position, tangent) for numPoints evenly spaced (in the
+	 * parameter) points of the cubic Bezier spline with the given control points,
+	 * both ends included. The tangent is the unnormalized derivative.
+	 * Uses forward differencing: no trigonometry and no powers per point.
+	 */
+	template<std::invocable<Vec2f, Vec2f> Fn>
+	void ForEachSplinePoint(const std::array<Vec2f, 4>& points, int numPoints, Fn&& fn) {
+		const auto& [p0, p1, p2, p3] = points;
+		if(numPoints < 2) {
+			if(numPoints == 1) {
+				fn(p0, (p1 - p0) * 3.0f);
+			}
+			return;
+		}
+
+		/* B(t) = a t^3 + b t^2 + c t + d, B'(t) = 3a t^2 + 2b t + c */
+		Vec2f a = p3 - p0 + (p1 - p2) * 3.0f;
+		Vec2f b = (p0 - p1 * 2.0f + p2) * 3.0f;
+		Vec2f c = (p1 - p0) * 3.0f;
+		float h = 1.0f / float(numPoints - 1);
+		float h2 = h * h;
+		float h3 = h2 * h;
+
+		Vec2f pos = p0;
+		Vec2f d1 = a * h3 + b * h2 + c * h;
+		Vec2f d2 = a * (6.0f * h3) + b * (2.0f * h2);
+		Vec2f d3 = a * (6.0f * h3);
+
+		Vec2f tangent = c;
+		Vec2f t1 = a * (3.0f * h2) + b * (2.0f * h);
+		Vec2f t2 = a * (6.0f * h2);
+
+		for(int i=0; i<numPoints-1; i++) {
+			fn(pos, tangent);
+			pos += d1;
+			d1 += d2;
+			d2 += d3;
+			tangent += t1;
+			t1 += t2;
+		}
+		fn(p3, tangent);
+	}
+
+	namespace detail {
+		template<typename T>
+		void CalculateArcImpl(std::span<T> out, Vec2f center, Vec2f radius, float startTheta, float deltaTheta, float thickness, const Color& color) {
+			int numPoints = int(thickness > 0 ? out.size() / 2 : out.size());
+			size_t i = 0;
+			ForEachArcPoint(startTheta, deltaTheta, numPoints, [&](Vec2f unit) {
+				StoreEllipsePoint(out, i++, center, radius, unit, thickness, color);
+			});
+		}
+
+		template<typename T>
+		void CalculateEllipseImpl(std::span<T> out, Vec2f center, Vec2f radius, float thickness, const Color& color) {
+			int numPoints = int(thickness > 0 ? out.size() / 2 : out.size());
+			size_t i = 0;
+			ForEachCirclePoint(numPoints, [&](Vec2f unit) {
+				StoreEllipsePoint(out, i++, center, radius, unit, thickness, color);
+			});
+		}
+
+		template<typename T>
+		void CalculateSplineImpl(std::span<T> out, const std::array<Vec2f, 4>& points, float thickness, const Color& color) {
+			int numPoints = int(thickness > 0 ? out.size() / 2 : out.size());
+			Vec2f fallback = (points[3] - points[0]).normalizedOr({1.0f, 0.0f});
+			size_t i = 0;
+			ForEachSplinePoint(points, numPoints, [&](Vec2f pos, Vec2f tangent) {
+				if(thickness <= 0) {
+					StorePoint(out[i++], pos, color);
+					return;
+				}
+				Vec2f dir = tangent.normalizedOr(fallback);
+				Vec2f offset = Vec2f(-dir.y, dir.x) * (0.5f * thickness);
+				StorePoint(out[2*i], pos + offset, color);
+				StorePoint(out[2*i + 1], pos - offset, color);
+				i++;
+			});
+		}
+	}
+
+	/**
+	 * @brief Writes out.size() evenly spaced points of an elliptical arc, both
+	 * ends included. With thickness > 0, writes out.size()/2 pairs of points
+	 * (outer, inner) that are thickness apart along the normal, like al_calculate_arc().
+	 */
+	inline void CalculateArc(std::span<Vec2f> out, Vec2f center, Vec2f radius, float startTheta, float deltaTheta, float thickness = 0) {
+		detail::CalculateArcImpl(out, center, radius, startTheta, deltaTheta, thickness, Color{});
+	}
+
+	/// @brief Same as CalculateArc(std::span<Vec2f>, ...), but writes vertices of the given color.
+	inline void CalculateArc(std::span<BasicVertex> out, Vec2f center, Vec2f radius, float startTheta, float deltaTheta, const Color& color, float thickness = 0) {
+		detail::CalculateArcImpl(out, center, radius, startTheta, deltaTheta, thickness, color);
+	}
+
+	/**
+	 * @brief Writes out.size() evenly spaced points around an ellipse, starting
+	 * at angle 0, without repeating the first one at the end. With thickness > 0,
+	 * writes (outer, inner) pairs like CalculateArc(). The directions come from
+	 * ForEachCirclePoint().
+	 */
+	inline void CalculateEllipse(std::span<Vec2f> out, Vec2f center, Vec2f radius, float thickness = 0) {
+		detail::CalculateEllipseImpl(out, center, radius, thickness, Color{});
+	}
+
+	/// @brief Same as CalculateEllipse(std::span<Vec2f>, ...), but writes vertices of the given color.
+	inline void CalculateEllipse(std::span<BasicVertex> out, Vec2f center, Vec2f radius, const Color& color, float thickness = 0) {
+		detail::CalculateEllipseImpl(out, center, radius, thickness, color);
+	}
+
+	/**
+	 * @brief Writes out.size() points of a cubic Bezier spline, both ends
+	 * included. With thickness > 0, writes out.size()/2 pairs of points on
+	 * either side of the curve, thickness apart.
+	 */
+	inline void CalculateSpline(std::span<Vec2f> out, const std::array<Vec2f, 4>& points, float thickness = 0) {
+		detail::CalculateSplineImpl(out, points, thickness, Color{});
+	}
+
+	/// @brief Same as CalculateSpline(std::span<Vec2f>, ...), but writes vertices of the given color.
+	inline void CalculateSpline(std::span<BasicVertex> out, const std::array<Vec2f, 4>& points, const Color& color, float thickness = 0) {
+		detail::CalculateSplineImpl(out, points, thickness, color);
+	}
+
+}
+
+#endif //AXXEGRO_PRIM_TESSELLATE_HPP
@@ -3,9 +3,12 @@
 
 #include "common.hpp"
 #include "PrimitivesAddon.hpp"
+#include "PrimBatch.hpp"
 
 #include <vector>
 #include <array>
+#include <limits>
+#include <span>
 
 /**
  * @file
@@ -23,6 +26,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addLine(a, b, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_line(a.x, a.y, b.x, b.y, color, thickness);
 	}
@@ -34,6 +41,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addTriangle(a, b, c, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_triangle(a.x, a.y, b.x, b.y, c.x, c.y, color, thickness);
 	}
@@ -44,6 +55,10 @@ namespace al {
 		const Vec2f& c,
 		const Color& color = PrimDefaultColor
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addFilledTriangle(a, b, c, color);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_filled_triangle(a.x, a.y, b.x, b.y, c.x, c.y, color);
 	}
@@ -53,6 +68,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addRectangle(r, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_rectangle(r.a.x, r.a.y, r.b.x, r.b.y, color, thickness);
 	}
@@ -61,6 +80,10 @@ namespace al {
 		const RectF& rect,
 		const Color& color = PrimDefaultColor
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addFilledRectangle(rect, color);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_filled_rectangle(rect.a.x, rect.a.y, rect.b.x, rect.b.y, color);
 	}
@@ -71,6 +94,7 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		detail::FlushActivePrimBatch();
 		InternalRequire<PrimitivesAddon>();
 		al_draw_rounded_rectangle(
 				rect.a.x, rect.a.y, rect.b.x, rect.b.y,
@@ -84,6 +108,7 @@ namespace al {
 		const Vec2f& radius = {0, 0},
 		const Color& color = PrimDefaultColor
 	) {
+		detail::FlushActivePrimBatch();
 		InternalRequire<PrimitivesAddon>();
 		al_draw_filled_rounded_rectangle(
 				rect.a.x, rect.a.y, rect.b.x, rect.b.y,
@@ -100,6 +125,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addPieslice(center, radius, startTheta, deltaTheta, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_pieslice(
 				center.x, center.y,
@@ -116,6 +145,10 @@ namespace al {
 		float deltaTheta,
 		const Color& color = PrimDefaultColor
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addFilledPieslice(center, radius, startTheta, deltaTheta, color);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_filled_pieslice(
 				center.x, center.y,
@@ -131,6 +164,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addEllipse(center, radius, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_ellipse(
 				center.x, center.y,
@@ -144,6 +181,10 @@ namespace al {
 		const Vec2f& radius,
 		const Color& color = PrimDefaultColor
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addFilledEllipse(center, radius, color);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_filled_ellipse(
 				center.x, center.y,
@@ -158,6 +199,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addCircle(center, radius, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_circle(
 				center.x, center.y,
@@ -171,6 +216,10 @@ namespace al {
 		float radius,
 		const Color& color = PrimDefaultColor
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addFilledCircle(center, radius, color);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_filled_circle(
 				center.x, center.y,
@@ -187,6 +236,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addArc(center, radius, startTheta, deltaTheta, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_arc(
 				center.x, center.y,
@@ -204,6 +257,10 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addEllipticalArc(center, radius, startTheta, deltaTheta, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
 		al_draw_elliptical_arc(
 				center.x, center.y,
@@ -218,15 +275,24 @@ namespace al {
 		const Color& color = PrimDefaultColor,
 		float thickness = PrimDefaultThickness
 	) {
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addSpline(points, color, thickness);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
-		std::vector<float> pts(8);
+		float pts[8];
 		for(unsigned i=0; i<points.size(); i++) {
 			pts[i*2 + 0] = points[i].x;
 			pts[i*2 + 1] = points[i].y;
 		}
-		al_draw_spline(pts.data(), color, thickness);
+		al_draw_spline(pts, color, thickness);
 	}
 
+	/**
+	 * @brief Calculates the points of an elliptical arc into a new vector.
+	 * Use CalculateArc(std::span<Vec2f>, ...) from Tessellate.hpp to fill
+	 * an existing buffer instead.
+	 */
 	inline std::vector<Vec2f> CalculateArc(
 		const Vec2f& center,
 		const Vec2f& radius,
@@ -235,23 +301,115 @@ namespace al {
 		float thickness,
 		int numPoints
 	) {
+		std::vector<Vec2f> ret(size_t(numPoints) * (1 + (thickness > 0)));
+		CalculateArc(std::span(ret), center, radius, startTheta, deltaTheta, thickness);
+		return ret;
+	}
+
+	namespace detail {
+		static_assert(sizeof(Vec2f) == 2 * sizeof(float), "Vec2f arrays are passed to Allegro as float arrays");
+
+		inline int ToAllegroLineJoin(LineJoin join) {
+			switch(join) {
+				case LineJoin::Bevel: return ALLEGRO_LINE_JOIN_BEVEL;
+				case LineJoin::Round: return ALLEGRO_LINE_JOIN_ROUND;
+				case LineJoin::Miter: return ALLEGRO_LINE_JOIN_MITER;
+			}
+			return ALLEGRO_LINE_JOIN_MITER;
+		}
+
+		inline int ToAllegroLineCap(LineCap cap) {
+			switch(cap) {
+				case LineCap::Butt: return ALLEGRO_LINE_CAP_NONE;
+				case LineCap::Square: return ALLEGRO_LINE_CAP_SQUARE;
+				case LineCap::Round: return ALLEGRO_LINE_CAP_ROUND;
+				case LineCap::Triangle: return ALLEGRO_LINE_CAP_TRIANGLE;
+			}
+			return ALLEGRO_LINE_CAP_NONE;
+		}
+	}
+
+	/**
+	 * @brief Draws connected line segments through the given points, as one
+	 * mesh without seams. Hairlines are drawn if style.thickness <= 0.
+	 */
+	inline void DrawPolyline(
+		std::span<const Vec2f> points,
+		const Color& color = PrimDefaultColor,
+		const StrokeStyle& style = {}
+	) {
+		if(points.empty()) {
+			return;
+		}
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addPolyline(points, color, style, false);
+			return;
+		}
+		InternalRequire<PrimitivesAddon>();
+		al_draw_polyline(
+				&points.data()->x, sizeof(Vec2f), int(points.size()),
+				detail::ToAllegroLineJoin(style.join), detail::ToAllegroLineCap(style.cap),
+				color, style.thickness, style.miterLimit
+		);
+	}
+
+	/// @brief Draws the outline of a polygon. The cap style is not used.
+	inline void DrawPolygon(
+		std::span<const Vec2f> points,
+		const Color& color = PrimDefaultColor,
+		const StrokeStyle& style = {}
+	) {
+		if(points.empty()) {
+			return;
+		}
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addPolyline(points, color, style, true);
+			return;
+		}
 		InternalRequire<PrimitivesAddon>();
-		std::vector<float> outData(2*numPoints*(1 + (thickness > 0)));
-		al_calculate_arc(
-				outData.data(), 2*sizeof(outData[0]),
-				center.x, center.y,
-				radius.x, radius.y,
-				startTheta, deltaTheta,
-				thickness,
-				numPoints
+		al_draw_polygon(
+				&points.data()->x, int(points.size()),
+				detail::ToAllegroLineJoin(style.join),
+				color, style.thickness, style.miterLimit
 		);
-		std::vector<Vec2f> ret(outData.size() / 2);
-		for(unsigned i=0; i<ret.size(); i++) {
-			ret[i] = {outData[i*2 + 0], outData[i*2 + 1]};
+	}
+
+	/// @brief Draws a filled simple polygon, which may be concave.
+	inline void DrawFilledPolygon(
+		std::span<const Vec2f> points,
+		const Color& color = PrimDefaultColor
+	) {
+		if(points.empty()) {
+			return;
 		}
-		return ret;
+		if(auto* batch = GetActivePrimBatch()) {
+			batch->addFilledPolygon(points, color);
+			return;
+		}
+		InternalRequire<PrimitivesAddon>();
+		al_draw_filled_polygon(&points.data()->x, int(points.size()), color);
 	}
 
-	//TODO ribbons
+	/// @brief Draws a ribbon: a polyline with mitered joins and no caps.
+	inline void DrawRibbon(
+		std::span<const Vec2f> points,
+		const Color& color = PrimDefaultColor,
+		float thickness = PrimDefaultThickness
+	) {
+		if(points.empty()) {
+			return;
+		}
+		if(auto* batch = GetActivePrimBatch()) {
+			/* al_draw_ribbon() miters every joint, however sharp */
+			batch->addPolyline(points, color, {
+				.thickness = thickness,
+				.join = LineJoin::Miter,
+				.miterLimit = std::numeric_limits<float>::max()
+			}, false);
+			return;
+		}
+		InternalRequire<PrimitivesAddon>();
+		al_draw_ribbon(&points.data()->x, sizeof(Vec2f), color, thickness, int(points.size()));
+	}
 }
 #endif /* INCLUDE_AXXEGRO_PRIM_HLDR */
@@ -64,6 +64,8 @@ namespace al
 	AXXEGRO_DEF_EXCEPTION(Exception, HardwareBufferError);
 		AXXEGRO_DEF_EXCEPTION(HardwareBufferError, VertexBufferError);
 		AXXEGRO_DEF_EXCEPTION(HardwareBufferError, IndexBufferError);
+	AXXEGRO_DEF_EXCEPTION(Exception, FileError);
+		AXXEGRO_DEF_EXCEPTION(FileError, ArchiveError);
 	AXXEGRO_DEF_EXCEPTION(Exception, ConfigError);
 		AXXEGRO_DEF_EXCEPTION(ConfigError, ConfigEntryTypeError);
 	
@@ -0,0 +1,172 @@
+#ifndef AXXEGRO_MATH_RECTPACKER_HPP
+#define AXXEGRO_MATH_RECTPACKER_HPP
+
+#include "Rect.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace al {
+
+	/**
+	 * @brief Packs rectangles into a fixed-size bin using the MaxRects algorithm
+	 * with the best short side fit heuristic.
+	 *
+	 * The free space is kept as a list of maximal (possibly overlapping) free
+	 * rectangles. Placing a rectangle splits every free rectangle it overlaps
+	 * and then drops the ones contained in others.
+	 */
+	class RectPacker {
+	public:
+		explicit RectPacker(Vec2i binSize = {0, 0}) {
+			reset(binSize);
+		}
+
+		/// @brief Empties the bin and optionally changes its size.
+		void reset(Vec2i newBinSize) {
+			binSize = newBinSize;
+			usedArea = 0;
+			freeRects.clear();
+			if(binSize.x > 0 && binSize.y > 0) {
+				freeRects.push_back(RectI::XYWH(0, 0, binSize.x, binSize.y));
+			}
+		}
+
+		void reset() {
+			reset(binSize);
+		}
+
+		/**
+		 * @brief Finds a place for a rectangle of the given size and marks it as used.
+		 * @return The placed rectangle, or std::nullopt if it doesn't fit.
+		 */
+		std::optional<RectI> insert(Vec2i size) {
+			if(size.x <= 0 || size.y <= 0) {
+				return std::nullopt;
+			}
+			auto pos = findPosition(size);
+			if(!pos) {
+				return std::nullopt;
+			}
+			RectI ret = RectI::PosSize(*pos, size);
+			markUsed(ret);
+			return ret;
+		}
+
+		/// @return Whether a rectangle of the given size would currently fit.
+		[[nodiscard]] bool canFit(Vec2i size) const {
+			return findPosition(size).has_value();
+		}
+
+		/**
+		 * @brief Marks an arbitrary rectangle as used, e.g. when restoring
+		 * a previously computed layout.
+		 */
+		void markUsed(const RectI& used) {
+			std::vector<RectI> newRects;
+			for(size_t i=0; i<freeRects.size(); ) {
+				if(splitFreeRect(freeRects[i], used, newRects)) {
+					freeRects[i] = freeRects.back();
+					freeRects.pop_back();
+				} else {
+					i++;
+				}
+			}
+			freeRects.insert(freeRects.end(), newRects.begin(), newRects.end());
+			pruneFreeRects();
+			usedArea += int64_t(used.width()) * used.height();
+		}
+
+		/// @return The fraction of the bin's area that is used, in [0, 1].
+		[[nodiscard]] float occupancy() const {
+			int64_t total = int64_t(binSize.x) * binSize.y;
+			return total ? float(usedArea) / float(total) : 0.0f;
+		}
+
+		[[nodiscard]] Vec2i size() const {
+			return binSize;
+		}
+
+	private:
+		[[nodiscard]] std::optional<Vec2i> findPosition(Vec2i size) const {
+			std::optional<Vec2i> best;
+			int bestShortSide = std::numeric_limits<int>::max();
+			int bestLongSide = std::numeric_limits<int>::max();
+			for(const auto& fr: freeRects) {
+				if(fr.width() < size.x || fr.height() < size.y) {
+					continue;
+				}
+				int leftoverX = fr.width() - size.x;
+				int leftoverY = fr.height() - size.y;
+				int shortSide = std::min(leftoverX, leftoverY);
+				int longSide = std::max(leftoverX, leftoverY);
+				if(shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide)) {
+					best = fr.a;
+					bestShortSide = shortSide;
+					bestLongSide = longSide;
+				}
+			}
+			return best;
+		}
+
+		static bool overlaps(const RectI& r1, const RectI& r2) {
+			return r1.a.x < r2.b.x && r2.a.x < r1.b.x && r1.a.y < r2.b.y && r2.a.y < r1.b.y;
+		}
+
+		static bool containedIn(const RectI& inner, const RectI& outer) {
+			return inner.a.x >= outer.a.x && inner.a.y >= outer.a.y
+				&& inner.b.x <= outer.b.x && inner.b.y <= outer.b.y;
+		}
+
+		/* Returns false if `fr` doesn't overlap `used`. Otherwise appends the parts of `fr` outside `used`. */
+		static bool splitFreeRect(const RectI& fr, const RectI& used, std::vector<RectI>& out) {
+			if(!overlaps(fr, used)) {
+				return false;
+			}
+			if(used.a.x > fr.a.x) {
+				out.emplace_back(fr.a.x, fr.a.y, used.a.x, fr.b.y);
+			}
+			if(used.b.x < fr.b.x) {
+				out.emplace_back(used.b.x, fr.a.y, fr.b.x, fr.b.y);
+			}
+			if(used.a.y > fr.a.y) {
+				out.emplace_back(fr.a.x, fr.a.y, fr.b.x, used.a.y);
+			}
+			if(used.b.y < fr.b.y) {
+				out.emplace_back(fr.a.x, used.b.y, fr.b.x, fr.b.y);
+			}
+			return true;
+		}
+
+		void pruneFreeRects() {
+			for(size_t i=0; i<freeRects.size(); ) {
+				bool removeI = false;
+				for(size_t j=i+1; j<freeRects.size(); ) {
+					if(containedIn(freeRects[i], freeRects[j])) {
+						removeI = true;
+						break;
+					}
+					if(containedIn(freeRects[j], freeRects[i])) {
+						freeRects.erase(freeRects.begin() + j);
+					} else {
+						j++;
+					}
+				}
+				if(removeI) {
+					freeRects.erase(freeRects.begin() + i);
+				} else {
+					i++;
+				}
+			}
+		}
+
+		Vec2i binSize;
+		std::vector<RectI> freeRects;
+		int64_t usedArea = 0;
+	};
+
+}
+
+#endif //AXXEGRO_MATH_RECTPACKER_HPP
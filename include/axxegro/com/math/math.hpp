@@ -3,5 +3,6 @@
 
 #include "Vec.hpp"
 #include "Rect.hpp"
+#include "RectPacker.hpp"
 
 #endif /* INCLUDE_AXXEGRO_MATH_MATH */
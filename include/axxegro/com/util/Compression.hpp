@@ -0,0 +1,195 @@
+#ifndef AXXEGRO_UTIL_COMPRESSION_HPP
+#define AXXEGRO_UTIL_COMPRESSION_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+/**
+ * @file
+ * Fast LZ77 compression in the LZ4 block format. Compression ratios are
+ * modest; decompression runs at memory speed, which is the point.
+ */
+
+namespace al {
+
+	namespace detail {
+		constexpr size_t LZMinMatch = 4;
+		constexpr size_t LZMaxOffset = 65535;
+		constexpr size_t LZLastLiterals = 5; //the last 5 bytes are always literals
+		constexpr size_t LZMatchStartLimit = 12; //no match may start within 12 bytes of the end
+		constexpr int LZHashBits = 14;
+
+		inline uint32_t LZRead32(const std::byte* p) {
+			uint32_t ret;
+			std::memcpy(&ret, p, sizeof(ret));
+			return ret;
+		}
+
+		inline uint32_t LZHash(uint32_t seq) {
+			return (seq * 2654435761u) >> (32 - LZHashBits);
+		}
+
+		inline void LZWriteLength(std::vector<std::byte>& out, size_t len) {
+			for(; len >= 255; len -= 255) {
+				out.push_back(std::byte{255});
+			}
+			out.push_back(std::byte(len));
+		}
+
+		inline void LZWriteSequence(std::vector<std::byte>& out, std::span<const std::byte> literals, size_t offset, size_t matchLen) {
+			size_t litLen = literals.size();
+			size_t matchCode = matchLen ? matchLen - LZMinMatch : 0;
+			uint8_t token = uint8_t((std::min<size_t>(litLen, 15) << 4) | std::min<size_t>(matchCode, 15));
+			out.push_back(std::byte(token));
+			if(litLen >= 15) {
+				LZWriteLength(out, litLen - 15);
+			}
+			out.insert(out.end(), literals.begin(), literals.end());
+			if(matchLen) {
+				out.push_back(std::byte(offset & 0xFF));
+				out.push_back(std::byte(offset >> 8));
+				if(matchCode >= 15) {
+					LZWriteLength(out, matchCode - 15);
+				}
+			}
+		}
+
+		/* false on truncated input */
+		inline bool LZReadLength(std::span<const std::byte> src, size_t& ip, size_t& len) {
+			uint8_t b;
+			do {
+				if(ip >= src.size()) {
+					return false;
+				}
+				b = uint8_t(src[ip++]);
+				len += b;
+			} while(b == 255);
+			return true;
+		}
+	}
+
+	/// @brief Compresses a block of memory. The result is never more than about 0.4% larger than the input.
+	inline std::vector<std::byte> CompressLZ(std::span<const std::byte> src) {
+		using namespace detail;
+		std::vector<std::byte> out;
+		out.reserve(src.size() + src.size() / 255 + 16);
+
+		const std::byte* p = src.data();
+		size_t n = src.size();
+		size_t anchor = 0;
+
+		if(n > LZMatchStartLimit) {
+			std::vector<uint32_t> table(size_t(1) << LZHashBits, 0);
+			size_t matchStartLimit = n - LZMatchStartLimit;
+			size_t matchEndLimit = n - LZLastLiterals;
+			size_t ip = 0;
+
+			while(ip < matchStartLimit) {
+				uint32_t seq = LZRead32(p + ip);
+				uint32_t h = LZHash(seq);
+				size_t ref = table[h];
+				table[h] = uint32_t(ip);
+
+				if(ref >= ip || ip - ref > LZMaxOffset || LZRead32(p + ref) != seq) {
+					/* skip ahead faster through incompressible data */
+					ip += 1 + ((ip - anchor) >> 6);
+					continue;
+				}
+
+				size_t len = LZMinMatch;
+				while(ip + len + 8 <= matchEndLimit) {
+					uint64_t a, b;
+					std::memcpy(&a, p + ip + len, 8);
+					std::memcpy(&b, p + ref + len, 8);
+					if(a != b) {
+						uint64_t diff = a ^ b;
+						len += (std::endian::native == std::endian::little ? std::countr_zero(diff) : std::countl_zero(diff)) / 8;
+						break;
+					}
+					len += 8;
+				}
+				while(ip + len < matchEndLimit && p[ip + len] == p[ref + len]) {
+					len++;
+				}
+
+				LZWriteSequence(out, src.subspan(anchor, ip - anchor), ip - ref, len);
+				ip += len;
+				anchor = ip;
+			}
+		}
+
+		LZWriteSequence(out, src.subspan(anchor), 0, 0);
+		return out;
+	}
+
+	/**
+	 * @brief Decompresses a block produced by CompressLZ() into `dst`, which must
+	 * have exactly the size of the original data. Malformed input is detected
+	 * and never causes reads or writes out of bounds.
+	 * @return Whether the input was valid and filled `dst` exactly.
+	 */
+	inline bool DecompressLZ(std::span<const std::byte> src, std::span<std::byte> dst) {
+		using namespace detail;
+		size_t ip = 0, op = 0;
+		std::byte* out = dst.data();
+
+		while(ip < src.size()) {
+			uint8_t token = uint8_t(src[ip++]);
+
+			size_t litLen = token >> 4;
+			if(litLen == 15 && !LZReadLength(src, ip, litLen)) {
+				return false;
+			}
+			if(litLen > src.size() - ip || litLen > dst.size() - op) {
+				return false;
+			}
+			if(litLen) {
+				std::memcpy(out + op, src.data() + ip, litLen);
+			}
+			ip += litLen;
+			op += litLen;
+
+			if(ip == src.size()) {
+				break;
+			}
+
+			if(src.size() - ip < 2) {
+				return false;
+			}
+			size_t offset = size_t(src[ip]) | (size_t(src[ip + 1]) << 8);
+			ip += 2;
+			if(offset == 0 || offset > op) {
+				return false;
+			}
+
+			size_t matchLen = token & 15;
+			if(matchLen == 15 && !LZReadLength(src, ip, matchLen)) {
+				return false;
+			}
+			matchLen += LZMinMatch;
+			if(matchLen > dst.size() - op) {
+				return false;
+			}
+
+			const std::byte* match = out + op - offset;
+			if(offset >= matchLen) {
+				std::memcpy(out + op, match, matchLen);
+			} else {
+				/* overlapping: repeats the last `offset` bytes */
+				for(size_t i=0; i<matchLen; i++) {
+					out[op + i] = match[i];
+				}
+			}
+			op += matchLen;
+		}
+		return op == dst.size();
+	}
+
+}
+
+#endif //AXXEGRO_UTIL_COMPRESSION_HPP
@@ -11,6 +11,12 @@
 
 namespace al {
 
+	/**
+	 * @brief Alignment used to keep data written by different threads on separate cache lines.
+	 * (std::hardware_destructive_interference_size is not usable portably in headers.)
+	 */
+	inline constexpr size_t CacheLineSize = 64;
+
 	/**
 	 * @brief std::span::subspan but it trims the returned span if out of bounds
 	 * instead of returning garbage.
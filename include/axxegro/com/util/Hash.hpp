@@ -0,0 +1,66 @@
+#ifndef AXXEGRO_UTIL_HASH_HPP
+#define AXXEGRO_UTIL_HASH_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace al {
+
+	namespace detail {
+		constexpr uint64_t HashPrime1 = 0x9E3779B185EBCA87ull;
+		constexpr uint64_t HashPrime2 = 0xC2B2AE3D27D4EB4Full;
+		constexpr uint64_t HashPrime3 = 0x165667B19E3779F9ull;
+
+		inline uint64_t HashRead64(const std::byte* p) {
+			uint64_t ret;
+			std::memcpy(&ret, p, sizeof(ret));
+			return ret;
+		}
+
+		inline uint64_t HashRound(uint64_t acc, uint64_t input) {
+			return std::rotl(acc + input * HashPrime2, 31) * HashPrime1;
+		}
+	}
+
+	/**
+	 * @brief A fast non-cryptographic 64-bit hash of a block of memory,
+	 * processing 32 bytes per iteration in four independent lanes.
+	 * Meant for detecting changed content (cache keys), not for security.
+	 * The result depends on the machine's endianness.
+	 */
+	inline uint64_t HashBytes64(std::span<const std::byte> data, uint64_t seed = 0) {
+		using namespace detail;
+		const std::byte* p = data.data();
+		size_t n = data.size();
+		size_t i = 0;
+
+		uint64_t lanes[4] = {seed + HashPrime1 + HashPrime2, seed + HashPrime2, seed, seed - HashPrime1};
+		for(; i + 32 <= n; i += 32) {
+			for(int k=0; k<4; k++) {
+				lanes[k] = HashRound(lanes[k], HashRead64(p + i + 8*k));
+			}
+		}
+
+		uint64_t h = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+		h += n;
+		for(; i + 8 <= n; i += 8) {
+			h = std::rotl(h ^ HashRound(0, HashRead64(p + i)), 27) * HashPrime1 + HashPrime3;
+		}
+		for(; i < n; i++) {
+			h = std::rotl(h ^ (uint64_t(p[i]) * HashPrime3), 11) * HashPrime1;
+		}
+
+		h ^= h >> 33;
+		h *= HashPrime2;
+		h ^= h >> 29;
+		h *= HashPrime3;
+		h ^= h >> 32;
+		return h;
+	}
+
+}
+
+#endif //AXXEGRO_UTIL_HASH_HPP
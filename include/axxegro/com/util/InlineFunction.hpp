@@ -0,0 +1,120 @@
+#ifndef AXXEGRO_UTIL_INLINEFUNCTION_HPP
+#define AXXEGRO_UTIL_INLINEFUNCTION_HPP
+
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace al {
+
+	template<typename Signature, std::size_t BufferSize = 48>
+	class InlineFunction;
+
+	/**
+	 * @brief A move-only std::function alternative that keeps callables of up to
+	 * BufferSize bytes in the object itself, so that constructing and calling
+	 * one doesn't touch the heap. Larger callables are heap-allocated.
+	 *
+	 * Calling an empty InlineFunction is undefined behavior; check with operator bool.
+	 */
+	template<typename R, typename... Args, std::size_t BufferSize>
+	class InlineFunction<R(Args...), BufferSize> {
+	public:
+		InlineFunction() = default;
+
+		template<typename Fn>
+			requires (!std::same_as<std::remove_cvref_t<Fn>, InlineFunction>) && std::is_invocable_r_v<R, std::decay_t<Fn>&, Args...>
+		explicit(false) InlineFunction(Fn&& fn) {
+			using F = std::decay_t<Fn>;
+			if constexpr(StoredInline<F>) {
+				::new(static_cast<void*>(buffer)) F(std::forward<Fn>(fn));
+				invoker = [](void* buf, Args... args) -> R {
+					return std::invoke(*std::launder(static_cast<F*>(buf)), std::forward<Args>(args)...);
+				};
+				manager = [](Op op, void* self, void* other) {
+					F* obj = std::launder(static_cast<F*>(self));
+					if(op == Op::MoveTo) {
+						::new(other) F(std::move(*obj));
+					}
+					obj->~F();
+				};
+			} else {
+				*reinterpret_cast<F**>(buffer) = new F(std::forward<Fn>(fn));
+				invoker = [](void* buf, Args... args) -> R {
+					return std::invoke(**static_cast<F**>(buf), std::forward<Args>(args)...);
+				};
+				manager = [](Op op, void* self, void* other) {
+					F** obj = static_cast<F**>(self);
+					if(op == Op::MoveTo) {
+						*static_cast<F**>(other) = *obj;
+					} else {
+						delete *obj;
+					}
+				};
+			}
+		}
+
+		InlineFunction(InlineFunction&& other) noexcept {
+			moveFrom(other);
+		}
+
+		InlineFunction& operator=(InlineFunction&& other) noexcept {
+			if(this != &other) {
+				reset();
+				moveFrom(other);
+			}
+			return *this;
+		}
+
+		InlineFunction(const InlineFunction&) = delete;
+		InlineFunction& operator=(const InlineFunction&) = delete;
+
+		~InlineFunction() {
+			reset();
+		}
+
+		R operator()(Args... args) const {
+			return invoker(const_cast<std::byte*>(buffer), std::forward<Args>(args)...);
+		}
+
+		explicit operator bool() const {
+			return invoker != nullptr;
+		}
+
+		void reset() {
+			if(manager) {
+				manager(Op::Destroy, buffer, nullptr);
+			}
+			invoker = nullptr;
+			manager = nullptr;
+		}
+
+		/// @return Whether a callable of type F would be stored without a heap allocation.
+		template<typename F>
+		static constexpr bool StoredInline =
+			sizeof(F) <= BufferSize
+			&& alignof(F) <= alignof(std::max_align_t)
+			&& std::is_nothrow_move_constructible_v<F>;
+
+	private:
+		enum class Op {MoveTo, Destroy};
+
+		void moveFrom(InlineFunction& other) noexcept {
+			if(other.manager) {
+				other.manager(Op::MoveTo, other.buffer, buffer);
+			}
+			invoker = std::exchange(other.invoker, nullptr);
+			manager = std::exchange(other.manager, nullptr);
+		}
+
+		alignas(std::max_align_t) std::byte buffer[BufferSize];
+		R (*invoker)(void*, Args...) = nullptr;
+		void (*manager)(Op, void*, void*) = nullptr;
+	};
+
+}
+
+#endif //AXXEGRO_UTIL_INLINEFUNCTION_HPP
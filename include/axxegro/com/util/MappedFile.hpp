@@ -0,0 +1,164 @@
+#ifndef AXXEGRO_UTIL_MAPPEDFILE_HPP
+#define AXXEGRO_UTIL_MAPPEDFILE_HPP
+
+#include "../Exception.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+/* The few kernel32 functions needed, declared exactly as in the Windows SDK.
+ * Including <windows.h> from a public header would turn names like LoadBitmap,
+ * DrawText, MessageBox and RGB into macros for every user of axxegro. */
+struct _SECURITY_ATTRIBUTES;
+extern "C" {
+	__declspec(dllimport) void* __stdcall CreateFileA(const char*, unsigned long, unsigned long, _SECURITY_ATTRIBUTES*, unsigned long, unsigned long, void*);
+	__declspec(dllimport) unsigned long __stdcall GetFileSize(void*, unsigned long*);
+	__declspec(dllimport) unsigned long __stdcall GetLastError();
+	__declspec(dllimport) void* __stdcall CreateFileMappingA(void*, _SECURITY_ATTRIBUTES*, unsigned long, unsigned long, unsigned long, const char*);
+#ifdef _WIN64
+	__declspec(dllimport) void* __stdcall MapViewOfFile(void*, unsigned long, unsigned long, unsigned long, unsigned long long);
+#else
+	__declspec(dllimport) void* __stdcall MapViewOfFile(void*, unsigned long, unsigned long, unsigned long, unsigned long);
+#endif
+	__declspec(dllimport) int __stdcall UnmapViewOfFile(const void*);
+	__declspec(dllimport) int __stdcall CloseHandle(void*);
+}
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace al {
+
+#ifdef _WIN32
+	namespace detail::win32 {
+		constexpr unsigned long GenericRead = 0x80000000ul;
+		constexpr unsigned long FileShareRead = 0x1;
+		constexpr unsigned long OpenExisting = 3;
+		constexpr unsigned long FileAttributeNormal = 0x80;
+		constexpr unsigned long PageReadOnly = 0x2;
+		constexpr unsigned long FileMapRead = 0x4;
+		constexpr unsigned long InvalidFileSize = 0xFFFFFFFFul;
+		constexpr unsigned long NoError = 0;
+
+		inline bool IsInvalidHandle(void* handle) {
+			return handle == reinterpret_cast<void*>(intptr_t(-1));
+		}
+	}
+#endif
+
+	/**
+	 * @brief A read-only memory mapping of a whole file.
+	 * The pages are loaded by the OS on first access, so opening is cheap
+	 * regardless of the file size.
+	 */
+	class MappedFile {
+	public:
+		/// @throws FileError if the file can't be opened or mapped.
+		explicit MappedFile(const std::string& filename) {
+#ifdef _WIN32
+			using namespace detail::win32;
+			void* file = CreateFileA(filename.c_str(), GenericRead, FileShareRead, nullptr, OpenExisting, FileAttributeNormal, nullptr);
+			if(IsInvalidHandle(file)) {
+				throw FileError("Cannot open \"%s\"", filename.c_str());
+			}
+			unsigned long sizeHigh = 0;
+			unsigned long sizeLow = GetFileSize(file, &sizeHigh);
+			if(sizeLow == InvalidFileSize && GetLastError() != NoError) {
+				CloseHandle(file);
+				throw FileError("Cannot get the size of \"%s\"", filename.c_str());
+			}
+			uint64_t fileSize = (uint64_t(sizeHigh) << 32) | sizeLow;
+			if(fileSize > uint64_t(SIZE_MAX)) {
+				CloseHandle(file);
+				throw FileError("\"%s\" is too large to be mapped into memory", filename.c_str());
+			}
+			size_ = size_t(fileSize);
+			if(size_ > 0) {
+				void* mapping = CreateFileMappingA(file, nullptr, PageReadOnly, 0, 0, nullptr);
+				if(mapping) {
+					data_ = static_cast<const std::byte*>(MapViewOfFile(mapping, FileMapRead, 0, 0, 0));
+					CloseHandle(mapping);
+				}
+			}
+			CloseHandle(file);
+#else
+			int fd = open(filename.c_str(), O_RDONLY);
+			if(fd < 0) {
+				throw FileError("Cannot open \"%s\"", filename.c_str());
+			}
+			struct stat st {};
+			if(fstat(fd, &st) != 0) {
+				close(fd);
+				throw FileError("Cannot get the size of \"%s\"", filename.c_str());
+			}
+			size_ = size_t(st.st_size);
+			if(size_ > 0) {
+				void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				data_ = (p == MAP_FAILED) ? nullptr : static_cast<const std::byte*>(p);
+			}
+			close(fd);
+#endif
+			if(size_ > 0 && !data_) {
+				throw FileError("Cannot map \"%s\" into memory", filename.c_str());
+			}
+		}
+
+		MappedFile(MappedFile&& rhs) noexcept
+			: data_(std::exchange(rhs.data_, nullptr)), size_(std::exchange(rhs.size_, 0))
+		{}
+
+		MappedFile& operator=(MappedFile&& rhs) noexcept {
+			if(this != &rhs) {
+				unmap();
+				data_ = std::exchange(rhs.data_, nullptr);
+				size_ = std::exchange(rhs.size_, 0);
+			}
+			return *this;
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		~MappedFile() {
+			unmap();
+		}
+
+		[[nodiscard]] const std::byte* data() const {
+			return data_;
+		}
+
+		[[nodiscard]] size_t size() const {
+			return size_;
+		}
+
+		[[nodiscard]] std::span<const std::byte> bytes() const {
+			return {data_, size_};
+		}
+
+	private:
+		void unmap() {
+			if(!data_) {
+				return;
+			}
+#ifdef _WIN32
+			UnmapViewOfFile(data_);
+#else
+			munmap(const_cast<std::byte*>(data_), size_);
+#endif
+			data_ = nullptr;
+		}
+
+		const std::byte* data_ = nullptr;
+		size_t size_ = 0;
+	};
+
+}
+
+#endif //AXXEGRO_UTIL_MAPPEDFILE_HPP
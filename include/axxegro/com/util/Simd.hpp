@@ -0,0 +1,23 @@
+#ifndef AXXEGRO_UTIL_SIMD_HPP
+#define AXXEGRO_UTIL_SIMD_HPP
+
+/*
+ * Compile-time SIMD feature detection for the CPU-side pixel and sample
+ * processing routines. The kernels are selected by what the compiler is
+ * allowed to emit (-msse2, -mavx2, /arch:AVX2), there is no runtime dispatch.
+ * Define AXXEGRO_NO_SIMD to force the scalar fallbacks.
+ */
+
+#ifndef AXXEGRO_NO_SIMD
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define AXXEGRO_SIMD_SSE2 1
+		#include <emmintrin.h>
+	#endif
+
+	#if defined(__AVX2__)
+		#define AXXEGRO_SIMD_AVX2 1
+		#include <immintrin.h>
+	#endif
+#endif
+
+#endif //AXXEGRO_UTIL_SIMD_HPP
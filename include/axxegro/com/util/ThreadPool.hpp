@@ -0,0 +1,174 @@
+#ifndef AXXEGRO_UTIL_THREADPOOL_HPP
+#define AXXEGRO_UTIL_THREADPOOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace al {
+
+	/**
+	 * @brief A fixed-size pool of worker threads for CPU-side processing.
+	 *
+	 * Nothing here touches Allegro, so tasks must not call Allegro functions
+	 * that depend on thread-local state (target bitmap, current display etc.)
+	 * unless they set it up themselves.
+	 */
+	class ThreadPool {
+	public:
+		/// @param numWorkers The number of worker threads. 0 makes every operation run on the calling thread.
+		explicit ThreadPool(unsigned numWorkers = DefaultNumWorkers())
+		{
+			workers.reserve(numWorkers);
+			for(unsigned i=0; i<numWorkers; i++) {
+				workers.emplace_back([this](){workerMain();});
+			}
+		}
+
+		~ThreadPool() {
+			{
+				std::lock_guard lk(mtx);
+				stopping = true;
+			}
+			cv.notify_all();
+			for(auto& t: workers) {
+				t.join();
+			}
+		}
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		/// @return The number of worker threads (not counting threads that call parallelFor()).
+		[[nodiscard]] unsigned numWorkers() const {
+			return workers.size();
+		}
+
+		/// @return true if called from one of this pool's worker threads.
+		[[nodiscard]] bool isWorkerThread() const {
+			return CurrentPool == this;
+		}
+
+		/**
+		 * @brief Enqueues a task. Tasks run in FIFO order on the first free worker.
+		 * If the pool has no workers, the task runs immediately on the calling thread.
+		 */
+		void submit(std::function<void()> task) {
+			if(workers.empty()) {
+				task();
+				return;
+			}
+			{
+				std::lock_guard lk(mtx);
+				tasks.push_back(std::move(task));
+			}
+			cv.notify_one();
+		}
+
+		/**
+		 * @brief Calls fn(i) for every i in [0, numJobs) and waits for all calls to finish.
+		 *
+		 * The calling thread takes part in the work. At most `maxThreads` threads
+		 * (including the calling one) are used; 0 means no limit. Calls made from a
+		 * worker thread of the same pool run serially to avoid deadlocks.
+		 * The first exception thrown by fn is rethrown after all jobs have finished.
+		 */
+		template<typename Fn>
+		void parallelFor(size_t numJobs, Fn&& fn, unsigned maxThreads = 0) {
+			if(numJobs == 0) {
+				return;
+			}
+			unsigned numThreads = numWorkers() + 1;
+			if(maxThreads) {
+				numThreads = std::min(numThreads, maxThreads);
+			}
+			numThreads = (unsigned)std::min<size_t>(numThreads, numJobs);
+			if(numThreads <= 1 || isWorkerThread()) {
+				for(size_t i=0; i<numJobs; i++) {
+					fn(i);
+				}
+				return;
+			}
+
+			std::atomic<size_t> nextJob = 0;
+			std::exception_ptr error;
+			std::mutex errorMtx;
+			std::latch helpersDone(numThreads - 1);
+
+			auto work = [&]() {
+				size_t i;
+				while((i = nextJob.fetch_add(1, std::memory_order_relaxed)) < numJobs) {
+					try {
+						fn(i);
+					} catch(...) {
+						std::lock_guard lk(errorMtx);
+						if(!error) {
+							error = std::current_exception();
+						}
+					}
+				}
+			};
+
+			for(unsigned t=0; t<numThreads-1; t++) {
+				submit([&]() {
+					work();
+					helpersDone.count_down();
+				});
+			}
+			work();
+			helpersDone.wait();
+
+			if(error) {
+				std::rethrow_exception(error);
+			}
+		}
+
+		/// @return A lazily created pool with one worker less than the number of hardware threads.
+		static ThreadPool& Default() {
+			static ThreadPool pool;
+			return pool;
+		}
+
+		static unsigned DefaultNumWorkers() {
+			return std::max(std::thread::hardware_concurrency(), 1u) - 1;
+		}
+
+	private:
+		void workerMain() {
+			CurrentPool = this;
+			while(true) {
+				std::function<void()> task;
+				{
+					std::unique_lock lk(mtx);
+					cv.wait(lk, [this](){return stopping || !tasks.empty();});
+					if(tasks.empty()) {
+						return;
+					}
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+				task();
+			}
+		}
+
+		static inline thread_local const ThreadPool* CurrentPool = nullptr;
+
+		std::vector<std::thread> workers;
+		std::deque<std::function<void()>> tasks;
+		std::mutex mtx;
+		std::condition_variable cv;
+		bool stopping = false;
+	};
+
+}
+
+#endif //AXXEGRO_UTIL_THREADPOOL_HPP
@@ -5,6 +5,7 @@
 #include "common.hpp"
 
 #include "core/Config.hpp"
+#include "core/File.hpp"
 #include "core/Monitor.hpp"
 #include "core/Shader.hpp"
 #include "core/System.hpp"
@@ -0,0 +1,77 @@
+#ifndef AXXEGRO_FILE_HPP
+#define AXXEGRO_FILE_HPP
+
+#include "../common.hpp"
+
+#include <allegro5/allegro_memfile.h>
+
+#include <span>
+#include <string>
+
+namespace al {
+
+	AXXEGRO_DEFINE_DELETER(ALLEGRO_FILE, al_fclose);
+
+	/**
+	 * @brief An Allegro file stream (ALLEGRO_FILE). Most *_f loading functions
+	 * accept one, which allows loading resources from memory or archives.
+	 */
+	class File:
+			RequiresInitializables<CoreAllegro>,
+			public Resource<ALLEGRO_FILE> {
+	public:
+		using Resource::Resource;
+
+		/// @see <a href="https://liballeg.org/a5docs/trunk/file.html#al_fopen">Allegro: al_fopen</a>
+		File(const std::string& filename, const std::string& mode)
+			: Resource(al_fopen(filename.c_str(), mode.c_str()))
+		{
+			if(!ptr()) {
+				throw FileError("Cannot open \"%s\" with mode \"%s\"", filename.c_str(), mode.c_str());
+			}
+		}
+
+		/**
+		 * @brief Opens a block of memory as a file. No data is copied, so the memory
+		 * must outlive the file. Only mode "r" is allowed for read-only memory.
+		 * @see <a href="https://liballeg.org/a5docs/trunk/memfile.html#al_open_memfile">Allegro: al_open_memfile</a>
+		 */
+		static File OpenMemory(void* mem, int64_t size, const char* mode = "r") {
+			auto* p = al_open_memfile(mem, size, mode);
+			if(!p) {
+				throw FileError("Cannot open a %lld-byte memory file", (long long)size);
+			}
+			return File(p);
+		}
+
+		/// @return The size of the file in bytes, or -1 if it cannot be determined.
+		[[nodiscard]] int64_t size() const {
+			return al_fsize(ptr());
+		}
+
+		/// @return The number of bytes read.
+		size_t read(std::span<std::byte> buffer) {
+			return al_fread(ptr(), buffer.data(), buffer.size());
+		}
+
+		/// @return The number of bytes written.
+		size_t write(std::span<const std::byte> buffer) {
+			return al_fwrite(ptr(), buffer.data(), buffer.size());
+		}
+
+		[[nodiscard]] int64_t tell() const {
+			return al_ftell(ptr());
+		}
+
+		bool seek(int64_t offset, int whence = ALLEGRO_SEEK_SET) {
+			return al_fseek(ptr(), offset, whence);
+		}
+
+		[[nodiscard]] bool eof() const {
+			return al_feof(ptr());
+		}
+	};
+
+}
+
+#endif //AXXEGRO_FILE_HPP
@@ -2,6 +2,7 @@
 #define INCLUDE_AXXEGRO_TRANSFORM
 
 #include "../common.hpp"
+#include "gfx/RenderStateCache.hpp"
 
 namespace al {
 	constexpr double RAD2DEG = 180.0 / ALLEGRO_PI;
@@ -26,12 +27,12 @@ namespace al {
 		
 		/// @brief Shorthand for al::TargetBitmap::useTransform(*this).
 		void use() const {
-			al_use_transform(this);
+			RenderStateCache::ThisThread().useTransform(this);
 		}
 
 		/// @brief Shorthand for al::TargetBitmap::useProjectionTransform(*this).
 		void useProjection() const {
-			al_use_projection_transform(this);
+			RenderStateCache::ThisThread().useProjectionTransform(this);
 		}
 		
 		/**
@@ -261,21 +262,21 @@ namespace al {
 	public:
 		/// @brief Set the transformation given in the parameter as current and save the old one.
 		explicit ScopedTransform(const Transform& t)
-				: originalTransform(al_get_current_transform())
+				: originalTransform(RenderStateCache::ThisThread().getCurrentTransform())
 		{
-			al_use_transform(&t);
+			RenderStateCache::ThisThread().useTransform(&t);
 		}
 
 		/// @brief Set the transformation given in the parameter as current and save the old one.
 		explicit ScopedTransform(ALLEGRO_TRANSFORM* t)
-				: originalTransform(al_get_current_transform())
+				: originalTransform(RenderStateCache::ThisThread().getCurrentTransform())
 		{
-			al_use_transform(t);
+			RenderStateCache::ThisThread().useTransform(t);
 		}
 
 		/// @brief Restore the transformation that was saved on construction.
 		~ScopedTransform() {
-			al_use_transform(&originalTransform);
+			RenderStateCache::ThisThread().useTransform(&originalTransform);
 		}
 	};
 }
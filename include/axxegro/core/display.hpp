@@ -4,5 +4,6 @@
 
 #include "display/Display.hpp"
 #include "display/DisplayModes.hpp"
+#include "display/DirtyRegionTracker.hpp"
 
 #endif //AXXEGRO_DISPLAY_HPP
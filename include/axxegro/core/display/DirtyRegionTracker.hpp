@@ -0,0 +1,322 @@
+#ifndef AXXEGRO_DIRTYREGIONTRACKER_HPP
+#define AXXEGRO_DIRTYREGIONTRACKER_HPP
+
+#include "Display.hpp"
+#include "../event/BuiltinEvents.hpp"
+#include "../gfx/TargetBitmap.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace al {
+
+	struct DirtyRegionConfig {
+		/// At most this many separate rectangles are redrawn per frame; more are merged.
+		int maxRects = 8;
+
+		/**
+		 * Two rectangles are merged if that redraws at most this many extra pixels,
+		 * i.e. this is the estimated cost of an extra clipped pass, in pixels.
+		 */
+		int64_t mergeCost = 64 * 64;
+
+		/// Damage is grown by this many pixels on every side, to cover antialiasing and filtering.
+		int padding = 1;
+
+		/// If the damaged area exceeds this fraction of the screen, the whole screen is redrawn.
+		float fullRedrawThreshold = 0.6f;
+
+		/**
+		 * How many frames a back buffer lives before it is reused. With 2 (double
+		 * buffering), the buffer drawn to in this frame last saw the damage from
+		 * two frames ago, so damage is redrawn in two consecutive frames. Use 1
+		 * for displays created with ALLEGRO_SINGLE_BUFFER.
+		 */
+		int bufferCount = 2;
+	};
+
+	namespace detail {
+		inline int64_t RectArea(const RectI& r) {
+			return int64_t(std::max(r.width(), 0)) * int64_t(std::max(r.height(), 0));
+		}
+
+		inline bool RectContains(const RectI& outer, const RectI& inner) {
+			return inner.a.x >= outer.a.x && inner.a.y >= outer.a.y && inner.b.x <= outer.b.x && inner.b.y <= outer.b.y;
+		}
+
+		/*
+		 * A small set of rectangles covering everything added to it. Rectangles are
+		 * merged greedily, cheapest union first, while a union costs at most
+		 * mergeCost extra pixels or there are more than maxRects of them.
+		 */
+		class RectSet {
+		public:
+			void add(RectI rect, const DirtyRegionConfig& cfg) {
+				if(RectArea(rect) == 0) {
+					return;
+				}
+				for(const auto& r: rects) {
+					if(RectContains(r, rect)) {
+						return;
+					}
+				}
+				std::erase_if(rects, [&](const RectI& r) {
+					return RectContains(rect, r);
+				});
+				rects.push_back(rect);
+				reduce(cfg);
+			}
+
+			void clear() {
+				rects.clear();
+			}
+
+			[[nodiscard]] int64_t area() const {
+				int64_t ret = 0;
+				for(const auto& r: rects) {
+					ret += RectArea(r);
+				}
+				return ret;
+			}
+
+			std::vector<RectI> rects;
+
+		private:
+			void reduce(const DirtyRegionConfig& cfg) {
+				while(rects.size() > 1) {
+					size_t bestI = 0, bestJ = 0;
+					int64_t bestExtra = INT64_MAX;
+					for(size_t i=0; i<rects.size(); i++) {
+						for(size_t j=i+1; j<rects.size(); j++) {
+							int64_t overlap = RectArea(rects[i].intersect(rects[j]));
+							int64_t extra = RectArea(rects[i].makeUnion(rects[j]))
+								- (RectArea(rects[i]) + RectArea(rects[j]) - overlap);
+							if(extra < bestExtra) {
+								bestExtra = extra;
+								bestI = i;
+								bestJ = j;
+							}
+						}
+					}
+					if(bestExtra > cfg.mergeCost && int(rects.size()) <= std::max(cfg.maxRects, 1)) {
+						break;
+					}
+					rects[bestI] = rects[bestI].makeUnion(rects[bestJ]);
+					rects.erase(rects.begin() + std::ptrdiff_t(bestJ));
+				}
+			}
+		};
+	}
+
+	/**
+	 * @brief Tracks which parts of the screen changed, so that only those are
+	 * redrawn and flipped.
+	 *
+	 * Report damage with invalidate() as things change (the old and the new
+	 * bounds of anything that moved), then once per frame:
+	 * @code
+	 * if(tracker.hasDamage()) {
+	 *     tracker.redraw([&](al::RectI clip) { drawScene(clip); });
+	 *     tracker.present();
+	 * }
+	 * @endcode
+	 * redraw() calls the function once per damaged rectangle with the clipping
+	 * rectangle set to it; everything outside is left as it was. present()
+	 * flips only the bounding box of the redrawn rectangles and starts the next
+	 * frame. Frames without damage can skip drawing and flipping altogether.
+	 *
+	 * Damage is kept for DirtyRegionConfig::bufferCount frames, because with
+	 * page flipping the back buffer holds the contents from that many frames ago.
+	 */
+	class DirtyRegionTracker {
+	public:
+		explicit DirtyRegionTracker(Vec2i screenSize, const DirtyRegionConfig& config = {})
+			: config(config), history(size_t(std::max(config.bufferCount, 1)))
+		{
+			resize(screenSize);
+		}
+
+		/// @brief Marks a rectangle (in screen pixels) as changed.
+		void invalidate(RectI rect) {
+			rect.a -= {config.padding, config.padding};
+			rect.b += {config.padding, config.padding};
+			rect = screen().intersect(rect);
+			if(fullDamage || detail::RectArea(rect) == 0) {
+				return;
+			}
+			current.add(rect, config);
+			if(float(current.area()) > config.fullRedrawThreshold * float(detail::RectArea(screen()))) {
+				invalidateAll();
+			}
+		}
+
+		/// @brief Marks the pixels touched by a rectangle with fractional coordinates as changed.
+		void invalidate(RectF rect) {
+			invalidate(RectI(
+				int(std::floor(rect.a.x)), int(std::floor(rect.a.y)),
+				int(std::ceil(rect.b.x)), int(std::ceil(rect.b.y))
+			));
+		}
+
+		/**
+		 * @brief Marks the screen-space bounding box of a rectangle as changed,
+		 * after mapping it through the target bitmap's current transform.
+		 */
+		void invalidateTransformed(RectF rect) {
+			Transform t = TargetBitmap.currentTransform();
+			Vec2f corners[] = {
+				t.transform(rect.a),
+				t.transform(Vec2f(rect.b.x, rect.a.y)),
+				t.transform(Vec2f(rect.a.x, rect.b.y)),
+				t.transform(rect.b)
+			};
+			RectF bounds(corners[0], corners[0]);
+			for(const auto& p: corners) {
+				bounds = bounds.makeUnion(RectF(p, p));
+			}
+			invalidate(bounds);
+		}
+
+		/// @brief Marks the whole screen as changed.
+		void invalidateAll() {
+			fullDamage = true;
+			current.clear();
+			current.rects.push_back(screen());
+		}
+
+		/// @brief Changes the screen size. Everything is redrawn in the next frames.
+		void resize(Vec2i screenSize) {
+			size = screenSize;
+			for(auto& h: history) {
+				h.clear();
+			}
+			invalidateAll();
+		}
+
+		/**
+		 * @brief Handles the display events that damage the screen: resizes,
+		 * exposes and regaining focus (ALLEGRO_EVENT_DISPLAY_SWITCH_IN and
+		 * ALLEGRO_EVENT_DISPLAY_FOUND), after which buffer contents may be lost.
+		 */
+		void handleEvent(const DisplayEvent& event) {
+			switch(event.type) {
+				case ALLEGRO_EVENT_DISPLAY_RESIZE:
+					resize({event.width, event.height});
+					break;
+				case ALLEGRO_EVENT_DISPLAY_EXPOSE:
+					invalidate(RectI::XYWH(event.x, event.y, event.width, event.height));
+					break;
+				case ALLEGRO_EVENT_DISPLAY_SWITCH_IN:
+				case ALLEGRO_EVENT_DISPLAY_FOUND:
+					invalidateAll();
+					break;
+				default:
+					break;
+			}
+		}
+
+		/// @return Whether anything has to be redrawn this frame.
+		[[nodiscard]] bool hasDamage() const {
+			if(!current.rects.empty()) {
+				return true;
+			}
+			for(size_t i=1; i<history.size(); i++) {
+				if(!previousFrame(i).rects.empty()) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		 * @return The rectangles to redraw this frame: this frame's damage and
+		 * that of the previous bufferCount-1 frames, merged.
+		 */
+		[[nodiscard]] std::span<const RectI> getRepaintRects() {
+			repaint.clear();
+			for(const auto& r: current.rects) {
+				repaint.add(r, config);
+			}
+			for(size_t i=1; i<history.size(); i++) {
+				for(const auto& r: previousFrame(i).rects) {
+					repaint.add(r, config);
+				}
+			}
+			if(float(repaint.area()) > config.fullRedrawThreshold * float(detail::RectArea(screen()))) {
+				repaint.clear();
+				repaint.rects.push_back(screen());
+			}
+			return repaint.rects;
+		}
+
+		/**
+		 * @brief Calls fn(rect) for every rectangle from getRepaintRects(), with
+		 * the target bitmap's clipping rectangle set to it. The previous clipping
+		 * rectangle is restored afterwards.
+		 */
+		template<typename Fn>
+		void redraw(Fn&& fn) {
+			RectI oldClip = TargetBitmap.getClippingRectangle();
+			try {
+				for(const auto& rect: getRepaintRects()) {
+					TargetBitmap.setClippingRectangle(rect);
+					fn(rect);
+				}
+			} catch(...) {
+				TargetBitmap.setClippingRectangle(oldClip);
+				throw;
+			}
+			TargetBitmap.setClippingRectangle(oldClip);
+		}
+
+		/**
+		 * @brief Flips the bounding box of the rectangles redrawn in this frame (the
+		 * whole display if that's most of it) and moves on to the next frame.
+		 */
+		void present() {
+			auto rects = getRepaintRects();
+			if(rects.size() == 1 && rects[0] == screen()) {
+				CurrentDisplay.flip();
+			} else {
+				CurrentDisplay.flip(rects);
+			}
+			endFrame();
+		}
+
+		/// @brief Moves on to the next frame without flipping, for code that flips by itself.
+		void endFrame() {
+			history[historyPos] = std::move(current);
+			historyPos = (historyPos + 1) % history.size();
+			current = {};
+			fullDamage = false;
+		}
+
+		[[nodiscard]] const DirtyRegionConfig& getConfig() const {
+			return config;
+		}
+
+		[[nodiscard]] RectI screen() const {
+			return {{0, 0}, size};
+		}
+
+	private:
+		/* damage from i frames ago, 1 <= i < history.size() */
+		[[nodiscard]] const detail::RectSet& previousFrame(size_t i) const {
+			return history[(historyPos + history.size() - i) % history.size()];
+		}
+
+		DirtyRegionConfig config;
+		Vec2i size;
+		bool fullDamage = false;
+		detail::RectSet current;
+		detail::RectSet repaint;
+		std::vector<detail::RectSet> history;
+		size_t historyPos = 0;
+	};
+
+}
+
+#endif //AXXEGRO_DIRTYREGIONTRACKER_HPP
@@ -11,6 +11,7 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include <span>
 
 #include <allegro5/allegro.h>
 
@@ -18,7 +19,12 @@
 
 namespace al {
 
-	AXXEGRO_DEFINE_DELETER(ALLEGRO_DISPLAY, al_destroy_display);
+	template<> struct Deleter<ALLEGRO_DISPLAY> {
+		inline void operator()(ALLEGRO_DISPLAY* p) {
+			RenderStateCache::ThisThread().invalidate();
+			al_destroy_display(p);
+		}
+	};
 
 	class Display;
 
@@ -96,6 +102,7 @@ namespace al {
 				throw DisplayCreationError("Could not create a %dx%d Allegro display.", w, h);
 			}
 			al_reset_new_display_options();
+			RenderStateCache::ThisThread().invalidate(); // the new display's backbuffer is now the target
 			initPointers();
 		}
 
@@ -155,7 +162,9 @@ namespace al {
 		 * @return false on failure
 		 */
 		bool resize(int w, int h) {
-			return al_resize_display(ptr(), w, h);
+			bool ret = al_resize_display(ptr(), w, h);
+			RenderStateCache::ThisThread().invalidate(); // the backbuffer may have been recreated
+			return ret;
 		}
 
 		/**
@@ -166,7 +175,9 @@ namespace al {
 		 * @return false on failure
 		 */
 		bool acknowledgeResize() {
-			return al_acknowledge_resize(ptr());
+			bool ret = al_acknowledge_resize(ptr());
+			RenderStateCache::ThisThread().invalidate(); // the backbuffer may have been recreated
+			return ret;
 		}
 
 		/**
@@ -337,9 +348,29 @@ namespace al {
 
 			void flip() { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
 				al_flip_display();
+				RenderStateCache::ThisThread().endFrame();
 			}
 			void flip(Rect<int> rect) { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
 				al_update_display_region(rect.a.x, rect.a.y, rect.width(), rect.height());
+				RenderStateCache::ThisThread().endFrame();
+			}
+
+			/**
+			 * @brief Updates the bounding box of the given regions of the display and
+			 * starts a new frame. Does nothing but start a new frame if rects is empty.
+			 *
+			 * The regions are updated with a single call, because where partial updates
+			 * aren't supported, every al_update_display_region() is a full buffer swap.
+			 */
+			void flip(std::span<const Rect<int>> rects) { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
+				if(!rects.empty()) {
+					Rect<int> bounds = rects[0];
+					for(const auto& rect: rects.subspan(1)) {
+						bounds = bounds.makeUnion(rect);
+					}
+					al_update_display_region(bounds.a.x, bounds.a.y, bounds.width(), bounds.height());
+				}
+				RenderStateCache::ThisThread().endFrame();
 			}
 			bool waitForVsync() { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
 				return al_wait_for_vsync();
@@ -349,7 +380,7 @@ namespace al {
 			}
 
 			void setTargetBitmap(Bitmap& bmp) { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				al_set_target_bitmap(bmp.ptr());
+				RenderStateCache::ThisThread().setTargetBitmap(bmp.ptr());
 			}
 		private:
 			[[nodiscard]] ALLEGRO_DISPLAY* getPointer() const override {
@@ -6,47 +6,17 @@
 #define AXXEGRO_EVENTDISPATCHER_HPP
 
 #include "../../com/util/Dict.hpp"
+#include "../../com/util/InlineFunction.hpp"
 #include "UserEvent.hpp"
-#include <optional>
+
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <vector>
 
 namespace al {
 	using EventDiscretizerID = uint32_t;
 
-	namespace detail {
-
-		struct EventDiscretizedValue {
-			EventDiscretizerID id;
-			int64_t value;
-
-			[[nodiscard]] std::size_t hash() const {
-				std::size_t ret = 0;
-				HashCombine(ret, id);
-				HashCombine(ret, value);
-				return ret;
-			}
-
-			friend auto operator<=>(const EventDiscretizedValue&, const EventDiscretizedValue&) = default;
-		};
-
-		struct EventHandlerCoord {
-			std::optional<EventType> type;
-			std::optional<EventDiscretizedValue> value;
-
-			friend auto operator<=>(const EventHandlerCoord&, const EventHandlerCoord&) = default;
-		};
-
-		struct EventHandlerCoordHash {
-			std::size_t operator()(const EventHandlerCoord& hc) const {
-				std::size_t ret = 1437;
-				HashCombine(ret, hc.type);
-				if(hc.value.has_value()) {
-					HashCombine(ret, hc.value->hash());
-				}
-				return ret;
-			}
-		};
-	}
-
 	enum EventHandledStatus {
 		EventHandled,
 		EventNotHandled
@@ -156,173 +126,396 @@ namespace al {
 		ByMouseBtn = 2
 	};
 
+	namespace detail {
+		template<typename Fn>
+		EventHandledStatus InvokeAndReturnStatus(Fn&& fn) {
+			if constexpr(std::is_void_v<std::invoke_result_t<Fn>>) {
+				fn();
+				return EventHandled;
+			} else {
+				return fn();
+			}
+		}
+
+		/* void EventT means a generic handler that gets the whole Event */
+		template<typename EventT, typename Fn>
+		EventHandledStatus InvokeEventHandler(Fn& fn, const Event& ev) {
+			if constexpr(std::derived_from<Fn, IEventHandler>) {
+				return fn.Fn::handle(ev); //non-virtual, the stored type is exact
+			} else if constexpr(std::is_void_v<EventT>) {
+				if constexpr(std::invocable<Fn&, const Event&>) {
+					return InvokeAndReturnStatus([&]{return fn(ev);});
+				} else {
+					return InvokeAndReturnStatus([&]{return fn();});
+				}
+			} else {
+				decltype(auto) data = EventDataGetter<EventT>{}(ev);
+				if constexpr(std::invocable<Fn&, const EventT&, const AnyEvent&>) {
+					return InvokeAndReturnStatus([&]{return fn(data, ev.any);});
+				} else if constexpr(std::invocable<Fn&, const EventT&>) {
+					return InvokeAndReturnStatus([&]{return fn(data);});
+				} else {
+					return InvokeAndReturnStatus([&]{return fn();});
+				}
+			}
+		}
 
+	}
+
+	/**
+	 * @brief Satisfied by callables that can handle events of type EventT:
+	 * ones taking (const EventT&, const AnyEvent&), (const EventT&) or nothing,
+	 * returning EventHandledStatus or void.
+	 */
+	template<typename Fn, typename EventT>
+	concept EventHandlerFn = !std::derived_from<std::remove_cvref_t<Fn>, IEventHandler> && (
+		std::invocable<Fn&, const EventT&, const AnyEvent&> ||
+		std::invocable<Fn&, const EventT&> ||
+		std::invocable<Fn&>
+	);
+
+	/**
+	 * @brief Satisfied by callables that take (const Event&) or nothing,
+	 * returning EventHandledStatus or void.
+	 */
+	template<typename Fn>
+	concept GenericEventHandlerFn = !std::derived_from<std::remove_cvref_t<Fn>, IEventHandler> && (
+		std::invocable<Fn&, const Event&> ||
+		std::invocable<Fn&>
+	);
+
+	/**
+	 * @brief Routes events to handlers registered by event type, by a discretized
+	 * value of the event (e.g. the keycode) or to a catch-all handler.
+	 *
+	 * For an incoming event, value handlers are tried first (in the order their
+	 * discretizers were first used with that event type), then the handler for
+	 * the type, then the catch-all handler. The first one to return EventHandled
+	 * stops the search.
+	 *
+	 * Registration builds a flat dispatch table, so dispatch() doesn't hash or
+	 * allocate: builtin event types (< 1024) index an array directly, user event
+	 * types are looked up in a small sorted vector, and values are found by binary
+	 * search. Handlers are stored inline (see InlineFunction) unless they are large.
+	 *
+	 * Handlers may register other handlers (or replace themselves) while they run:
+	 * registrations made during dispatch() are applied when it returns.
+	 */
 	class EventDispatcher {
 	public:
 		using EventDiscretizer = std::function<int64_t(const Event&)>;
 
+		/// @brief The type handlers are stored as. Lambdas capturing up to 48 bytes don't allocate.
+		using HandlerFn = InlineFunction<EventHandledStatus(const Event&)>;
+
 		[[nodiscard("The returned ID of the registered discretizer should be used")]]
-		EventDiscretizerID addDiscretizer(EventDiscretizer discretizer) {
+		EventDiscretizerID addDiscretizer(InlineFunction<int64_t(const Event&)> discretizer) {
 			discretizers.emplace_back(std::move(discretizer));
 			return discretizers.size() - 1;
 		}
 
 		[[nodiscard]] bool isDiscretizerRelevant(EventType eventType, EventDiscretizerID discrId) const {
-			if(auto it = relevantDiscretizers.find(eventType); it != relevantDiscretizers.end()) {
-				const auto& list = it->second;
-				return std::find(list.begin(), list.end(), discrId) != list.end();
-			} else {
-				return false;
+			if(const auto* entry = findEntry(eventType)) {
+				return std::any_of(entry->byValue.begin(), entry->byValue.end(), [discrId](const ValueTable& vt) {
+					return vt.id == discrId;
+				});
 			}
+			return false;
 		}
 
-
+		template<EventDataType EventT, EventHandlerFn<EventT> Fn>
+		EventDispatcher& setEventHandlerForValue(EventType eventType, EventDiscretizerID discrId, int64_t value, Fn&& handler) {
+			setValueHandler(eventType, discrId, value, wrap<EventT>(std::forward<Fn>(handler)));
+			return *this;
+		}
 
 		template<EventDataType EventT>
 		EventDispatcher& setEventHandlerForValue(EventType eventType, EventDiscretizerID discrId, int64_t value, EventHandler<EventT> handler) {
-			if(!isDiscretizerRelevant(eventType, discrId)) {
-				relevantDiscretizers[eventType].push_back(discrId);
-			}
-			auto key = detail::EventHandlerCoord {
-				.type = eventType,
-				.value = detail::EventDiscretizedValue {.id = discrId, .value = value}
-			};
-			handlers[key] = std::make_unique<EventHandler<EventT>>(std::move(handler));
+			setValueHandler(eventType, discrId, value, wrap<EventT>(std::move(handler)));
+			return *this;
+		}
+
+		template<EventDataType EventT, EventHandlerFn<EventT> Fn>
+		EventDispatcher& setEventHandler(EventType eventType, Fn&& handler) {
+			setTypeHandler(eventType, wrap<EventT>(std::forward<Fn>(handler)));
 			return *this;
 		}
 
 		template<EventDataType EventT>
 		EventDispatcher& setEventHandler(EventType eventType, EventHandler<EventT> handler) {
-			auto key = detail::EventHandlerCoord {
-				.type = eventType,
-				.value = std::nullopt
-			};
-			handlers[key] = std::make_unique<EventHandler<EventT>>(std::move(handler));
+			setTypeHandler(eventType, wrap<EventT>(std::move(handler)));
+			return *this;
+		}
+
+		template<GenericEventHandlerFn Fn>
+		EventDispatcher& setEventHandler(EventType eventType, Fn&& handler) {
+			setTypeHandler(eventType, wrap<void>(std::forward<Fn>(handler)));
 			return *this;
 		}
 
 		EventDispatcher& setEventHandler(EventType eventType, GenericEventHandler handler) {
-			auto key = detail::EventHandlerCoord {
-				.type = eventType,
-				.value = std::nullopt
-			};
-			handlers[key] = std::make_unique<GenericEventHandler>(std::move(handler));
+			setTypeHandler(eventType, wrap<void>(std::move(handler)));
 			return *this;
 		}
 
+		template<UserEventType EventT, EventHandlerFn<EventT> Fn>
+		EventDispatcher& setUserEventHandler(Fn&& handler) {
+			return setEventHandler<EventT>(UserEventTypeIDGetter<EventT>{}(), std::forward<Fn>(handler));
+		}
+
 		template<UserEventType EventT>
 		EventDispatcher& setUserEventHandler(EventHandler<EventT> handler) {
 			return setEventHandler<EventT>(UserEventTypeIDGetter<EventT>{}(), std::move(handler));
 		}
 
+		template<GenericEventHandlerFn Fn>
+		EventDispatcher& setCatchallHandler(Fn&& handler) {
+			setCatchall(wrap<void>(std::forward<Fn>(handler)));
+			return *this;
+		}
+
 		EventDispatcher& setCatchallHandler(GenericEventHandler handler) {
-			handlers[detail::EventHandlerCoord{}] = std::make_unique<GenericEventHandler>(std::move(handler));
+			setCatchall(wrap<void>(std::move(handler)));
 			return *this;
 		}
 
+		template<EventHandlerFn<KeyboardEvent> Fn>
+		EventDispatcher& onKeyDown(int keycode, Fn&& handler) {
+			return setEventHandlerForValue<KeyboardEvent>(ALLEGRO_EVENT_KEY_DOWN, ByKeycode, keycode, std::forward<Fn>(handler));
+		}
+
 		EventDispatcher& onKeyDown(int keycode, EventHandler<KeyboardEvent> handler) {
-			setEventHandlerForValue(ALLEGRO_EVENT_KEY_DOWN, ByKeycode, keycode, std::move(handler));
-			return *this;
+			return setEventHandlerForValue(ALLEGRO_EVENT_KEY_DOWN, ByKeycode, keycode, std::move(handler));
+		}
+
+		template<EventHandlerFn<KeyboardEvent> Fn>
+		EventDispatcher& onKeyUp(int keycode, Fn&& handler) {
+			return setEventHandlerForValue<KeyboardEvent>(ALLEGRO_EVENT_KEY_UP, ByKeycode, keycode, std::forward<Fn>(handler));
 		}
 
 		EventDispatcher& onKeyUp(int keycode, EventHandler<KeyboardEvent> handler) {
-			setEventHandlerForValue(ALLEGRO_EVENT_KEY_UP, ByKeycode, keycode, std::move(handler));
-			return *this;
+			return setEventHandlerForValue(ALLEGRO_EVENT_KEY_UP, ByKeycode, keycode, std::move(handler));
+		}
+
+		template<EventHandlerFn<KeyboardEvent> Fn>
+		EventDispatcher& onKeyChar(int unichar, Fn&& handler) {
+			return setEventHandlerForValue<KeyboardEvent>(ALLEGRO_EVENT_KEY_CHAR, ByUnichar, unichar, std::forward<Fn>(handler));
 		}
 
 		EventDispatcher& onKeyChar(int unichar, EventHandler<KeyboardEvent> handler) {
-			setEventHandlerForValue(ALLEGRO_EVENT_KEY_CHAR, ByUnichar, unichar, std::move(handler));
-			return *this;
+			return setEventHandlerForValue(ALLEGRO_EVENT_KEY_CHAR, ByUnichar, unichar, std::move(handler));
+		}
+
+		template<EventHandlerFn<KeyboardEvent> Fn>
+		EventDispatcher& onKeyCharKeycode(int keycode, Fn&& handler) {
+			return setEventHandlerForValue<KeyboardEvent>(ALLEGRO_EVENT_KEY_CHAR, ByKeycode, keycode, std::forward<Fn>(handler));
 		}
 
 		EventDispatcher& onKeyCharKeycode(int keycode, EventHandler<KeyboardEvent> handler) {
-			setEventHandlerForValue(ALLEGRO_EVENT_KEY_CHAR, ByKeycode, keycode, std::move(handler));
-			return *this;
+			return setEventHandlerForValue(ALLEGRO_EVENT_KEY_CHAR, ByKeycode, keycode, std::move(handler));
+		}
+
+		template<EventHandlerFn<MouseEvent> Fn>
+		EventDispatcher& onMouseDown(int button, Fn&& handler) {
+			return setEventHandlerForValue<MouseEvent>(ALLEGRO_EVENT_MOUSE_BUTTON_DOWN, ByMouseBtn, button, std::forward<Fn>(handler));
 		}
 
 		EventDispatcher& onMouseDown(int button, EventHandler<MouseEvent> handler) {
-			setEventHandlerForValue(ALLEGRO_EVENT_MOUSE_BUTTON_DOWN, ByMouseBtn, button, std::move(handler));
-			return *this;
+			return setEventHandlerForValue(ALLEGRO_EVENT_MOUSE_BUTTON_DOWN, ByMouseBtn, button, std::move(handler));
+		}
+
+		template<EventHandlerFn<MouseEvent> Fn>
+		EventDispatcher& onMouseUp(int button, Fn&& handler) {
+			return setEventHandlerForValue<MouseEvent>(ALLEGRO_EVENT_MOUSE_BUTTON_UP, ByMouseBtn, button, std::forward<Fn>(handler));
 		}
 
 		EventDispatcher& onMouseUp(int button, EventHandler<MouseEvent> handler) {
-			setEventHandlerForValue(ALLEGRO_EVENT_MOUSE_BUTTON_UP, ByMouseBtn, button, std::move(handler));
-			return *this;
+			return setEventHandlerForValue(ALLEGRO_EVENT_MOUSE_BUTTON_UP, ByMouseBtn, button, std::move(handler));
+		}
+
+		template<EventHandlerFn<MouseEvent> Fn>
+		EventDispatcher& onMouseMove(Fn&& handler) {
+			return setEventHandler<MouseEvent>(ALLEGRO_EVENT_MOUSE_AXES, std::forward<Fn>(handler));
 		}
 
 		EventDispatcher& onMouseMove(EventHandler<MouseEvent> handler) {
-			setEventHandler(ALLEGRO_EVENT_MOUSE_AXES, std::move(handler));
-			return *this;
+			return setEventHandler(ALLEGRO_EVENT_MOUSE_AXES, std::move(handler));
 		}
 
 		EventHandledStatus dispatch(const Event& event) {
-			if(tryDispatchByValue(event) == EventHandled) return EventHandled;
-			if(tryDispatchByType(event) == EventHandled) return EventHandled;
-			return tryDispatchToCatchall(event);
+			if(dispatchDepth == 0) {
+				applyPendingRegistrations(); //left over if a handler threw
+			}
+			EventHandledStatus status;
+			{
+				DispatchScope scope(dispatchDepth);
+				status = dispatchImpl(event);
+			}
+			if(dispatchDepth == 0) {
+				applyPendingRegistrations();
+			}
+			return status;
 		}
 
 		EventDispatcher() {
+			directSlots.fill(0);
 			discretizers.resize(3);
-			discretizers[ByKeycode] = [](const Event& ev) {return ev.keyboard.keycode;};
-			discretizers[ByUnichar] = [](const Event& ev) {return ev.keyboard.unichar;};
-			discretizers[ByMouseBtn] = [](const Event& ev) {return ev.mouse.button;};
+			discretizers[ByKeycode] = [](const Event& ev) -> int64_t {return ev.keyboard.keycode;};
+			discretizers[ByUnichar] = [](const Event& ev) -> int64_t {return ev.keyboard.unichar;};
+			discretizers[ByMouseBtn] = [](const Event& ev) -> int64_t {return ev.mouse.button;};
 		}
 	private:
+		static constexpr EventType NumDirectEventTypes = 1024;
+
+		/* a registration made by a handler during dispatch(), applied once it returns */
+		struct PendingRegistration {
+			enum Kind {ByType, ByValue, Catchall} kind;
+			EventType eventType;
+			EventDiscretizerID discrId;
+			int64_t value;
+			HandlerFn handler;
+		};
+
+		struct DispatchScope {
+			int& depth;
+			explicit DispatchScope(int& depth) : depth(depth) {++depth;}
+			~DispatchScope() {--depth;}
+			DispatchScope(const DispatchScope&) = delete;
+			DispatchScope& operator=(const DispatchScope&) = delete;
+		};
+
+		/* handlers for one (event type, discretizer) pair, sorted by value */
+		struct ValueTable {
+			EventDiscretizerID id;
+			std::vector<int64_t> values;
+			std::vector<HandlerFn> handlers;
+
+			[[nodiscard]] const HandlerFn* find(int64_t value) const {
+				auto it = std::lower_bound(values.begin(), values.end(), value);
+				if(it == values.end() || *it != value) {
+					return nullptr;
+				}
+				return &handlers[it - values.begin()];
+			}
+		};
+
+		struct TypeEntry {
+			std::vector<ValueTable> byValue;
+			HandlerFn handler;
+		};
 
-		std::vector<EventDiscretizerID>* findRelevantDiscretizerIDs(EventType type) {
-			if(auto itEntry = relevantDiscretizers.find(type); itEntry != relevantDiscretizers.end()) {
-				return &itEntry->second;
+		template<typename EventT, typename Fn>
+		static HandlerFn wrap(Fn&& fn) {
+			return [fn = std::forward<Fn>(fn)](const Event& ev) mutable {
+				return detail::InvokeEventHandler<EventT>(fn, ev);
+			};
+		}
+
+		EventHandledStatus dispatchImpl(const Event& event) const {
+			if(const auto* entry = findEntry(event.type)) {
+				for(const auto& vt: entry->byValue) {
+					if(const auto* handler = vt.find(discretizers[vt.id](event))) {
+						if((*handler)(event) == EventHandled) {
+							return EventHandled;
+						}
+					}
+				}
+				if(entry->handler && entry->handler(event) == EventHandled) {
+					return EventHandled;
+				}
 			}
-			return nullptr;
+			if(catchallHandler) {
+				return catchallHandler(event);
+			}
+			return EventNotHandled;
 		}
 
-		IEventHandler* findEventHandlerByCoord(const detail::EventHandlerCoord& coord) {
-			if(auto itEntry = handlers.find(coord); itEntry != handlers.end()) {
-				return itEntry->second.get();
+		[[nodiscard]] const TypeEntry* findEntry(EventType type) const {
+			uint32_t slot;
+			if(type < NumDirectEventTypes) {
+				slot = directSlots[type];
+			} else {
+				auto it = std::lower_bound(indirectSlots.begin(), indirectSlots.end(), type, [](const auto& p, EventType t) {
+					return p.first < t;
+				});
+				slot = (it != indirectSlots.end() && it->first == type) ? it->second : 0;
 			}
-			return nullptr;
+			return slot ? &entries[slot - 1] : nullptr;
 		}
 
-		EventHandledStatus tryDispatchCoord(const Event& event, const detail::EventHandlerCoord& coord) {
-			if(auto* handler = findEventHandlerByCoord(coord)) {
-				return handler->handle(event);
+		TypeEntry& getOrCreateEntry(EventType type) {
+			if(const auto* entry = findEntry(type)) {
+				return const_cast<TypeEntry&>(*entry);
 			}
-			return EventNotHandled;
+			entries.emplace_back();
+			uint32_t slot = entries.size();
+			if(type < NumDirectEventTypes) {
+				directSlots[type] = slot;
+			} else {
+				auto it = std::lower_bound(indirectSlots.begin(), indirectSlots.end(), type, [](const auto& p, EventType t) {
+					return p.first < t;
+				});
+				indirectSlots.insert(it, {type, slot});
+			}
+			return entries.back();
 		}
 
-		EventHandledStatus tryDispatchByValue(const Event& event) {
-			detail::EventHandlerCoord coord = {
-				.type = event.type,
-				.value = std::nullopt
-			};
-			auto* ids = findRelevantDiscretizerIDs(event.type);
-			if(!ids) {
-				return EventNotHandled;
+		void setTypeHandler(EventType eventType, HandlerFn handler) {
+			if(dispatchDepth > 0) {
+				pendingRegistrations.push_back({PendingRegistration::ByType, eventType, 0, 0, std::move(handler)});
+				return;
 			}
-			for(const auto id: *ids) {
-				coord.value = detail::EventDiscretizedValue {.id = id, .value = discretizers[id](event)};
-				if(tryDispatchCoord(event, coord) == EventHandled) {
-					return EventHandled;
-				}
+			getOrCreateEntry(eventType).handler = std::move(handler);
+		}
+
+		void setCatchall(HandlerFn handler) {
+			if(dispatchDepth > 0) {
+				pendingRegistrations.push_back({PendingRegistration::Catchall, 0, 0, 0, std::move(handler)});
+				return;
 			}
-			return EventNotHandled;
+			catchallHandler = std::move(handler);
 		}
 
-		EventHandledStatus tryDispatchByType(const Event& event) {
-			return tryDispatchCoord(event, {
-				.type = event.type,
-				.value = std::nullopt
+		void setValueHandler(EventType eventType, EventDiscretizerID discrId, int64_t value, HandlerFn handler) {
+			if(dispatchDepth > 0) {
+				pendingRegistrations.push_back({PendingRegistration::ByValue, eventType, discrId, value, std::move(handler)});
+				return;
+			}
+			auto& byValue = getOrCreateEntry(eventType).byValue;
+			auto vtIt = std::find_if(byValue.begin(), byValue.end(), [discrId](const ValueTable& vt) {
+				return vt.id == discrId;
 			});
+			if(vtIt == byValue.end()) {
+				vtIt = byValue.insert(byValue.end(), ValueTable{.id = discrId, .values = {}, .handlers = {}});
+			}
+			auto it = std::lower_bound(vtIt->values.begin(), vtIt->values.end(), value);
+			auto idx = it - vtIt->values.begin();
+			if(it != vtIt->values.end() && *it == value) {
+				vtIt->handlers[idx] = std::move(handler);
+			} else {
+				vtIt->values.insert(it, value);
+				vtIt->handlers.insert(vtIt->handlers.begin() + idx, std::move(handler));
+			}
 		}
 
-		EventHandledStatus tryDispatchToCatchall(const Event& event) {
-			return tryDispatchCoord(event, {});
+		void applyPendingRegistrations() {
+			for(auto& reg: pendingRegistrations) {
+				switch(reg.kind) {
+					case PendingRegistration::ByType: setTypeHandler(reg.eventType, std::move(reg.handler)); break;
+					case PendingRegistration::ByValue: setValueHandler(reg.eventType, reg.discrId, reg.value, std::move(reg.handler)); break;
+					case PendingRegistration::Catchall: setCatchall(std::move(reg.handler)); break;
+				}
+			}
+			pendingRegistrations.clear();
 		}
 
-		std::vector<EventDiscretizer> discretizers;
-		std::unordered_map<EventType, std::vector<EventDiscretizerID>> relevantDiscretizers;
-		std::unordered_map<detail::EventHandlerCoord, std::unique_ptr<IEventHandler>, detail::EventHandlerCoordHash> handlers;
-
+		std::vector<InlineFunction<int64_t(const Event&)>> discretizers;
+		std::array<uint32_t, NumDirectEventTypes> directSlots;
+		std::vector<std::pair<EventType, uint32_t>> indirectSlots;
+		std::vector<TypeEntry> entries;
+		HandlerFn catchallHandler;
+		int dispatchDepth = 0;
+		std::vector<PendingRegistration> pendingRegistrations;
 	};
 
 }
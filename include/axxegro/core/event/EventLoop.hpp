@@ -10,11 +10,16 @@
 #include "../io.hpp"
 #include "../time/FramerateLimiter.hpp"
 #include "../time/FPSCounter.hpp"
+#include "../time/FrameProfiler.hpp"
 
 #include <unordered_map>
 #include <optional>
 #include <memory>
 #include <functional>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <thread>
 
 
 namespace al {
@@ -35,6 +40,10 @@ namespace al {
 		uint32_t enableQuitTriggers = QuitOnDisplayClosedBit | QuitOnEscPressedBit;
 		bool autoAcknowledgeResize = true;
 		FramerateLimit framerateLimit = FPSLimit::None;
+		FramePacing framePacing = FramePacing::TimerEvents;
+
+		/// Events are popped this many at a time with EventQueue::popAll(). 0 pops them one by one.
+		uint32_t eventBatchSize = 256;
 	};
 
 	inline constexpr EventLoopConfig EmptyEventLoopConfig = {
@@ -58,6 +67,32 @@ namespace al {
 
 
 
+	struct FixedStepConfig {
+		/// At most this many updates run per rendered frame. Ticks beyond that are dropped (see FixedStepStats).
+		int maxUpdatesPerFrame = 8;
+
+		/**
+		 * Run updates on a separate thread instead of before each frame. Update and render
+		 * then run concurrently, so any state they share must be synchronized by the caller
+		 * (e.g. by double buffering). Events are still dispatched on the calling thread.
+		 */
+		bool separateUpdateThread = false;
+	};
+
+	struct FixedStepStats {
+		/// Number of updates run since runFixed() started.
+		int64_t numUpdates = 0;
+
+		/// Number of updates that ran as the second or later update in a single frame, to catch up.
+		int64_t numCatchUpUpdates = 0;
+
+		/// Number of ticks skipped because the catch-up limit was reached.
+		int64_t numDroppedTicks = 0;
+
+		/// The interpolation factor passed to the last render call.
+		double lastAlpha = 0.0;
+	};
+
 	class EventLoop: RequiresInitializables<CoreAllegro> {
 
 	public:
@@ -91,7 +126,9 @@ namespace al {
 				});
 			}
 
+			framerateLimiter.setPacing(config.framePacing);
 			framerateLimiter.setLimit(config.framerateLimit);
+			eventBatchSize = config.eventBatchSize;
 
 		}
 
@@ -101,23 +138,65 @@ namespace al {
 
 		void run(const std::function<void(void)>& loopBody) {
 			while(!exitFlag) {
-				framerateLimiter.wait();
-				while(!eventQueue.empty()) {
-					auto event = eventQueue.pop();
-					eventDispatcher.dispatch(event.get());
+				{
+					auto section = profiler.scope(waitSection);
+					framerateLimiter.wait();
 				}
-				loopBody();
-				double endTickTime = GetTime();
-				if(lastTimeOfTick > 0.0) {
-					lastTickTime = endTickTime - lastTimeOfTick;
+				{
+					auto section = profiler.scope(eventsSection);
+					processEvents();
 				}
-				lastTimeOfTick = endTickTime;
-				fpsCounter.acknowledgeFrame();
-				tick++;
+				{
+					auto section = profiler.scope(bodySection);
+					loopBody();
+				}
+				acknowledgeTick();
+			}
+			exitFlag = false;
+		}
+
+		/**
+		 * @brief Runs a fixed-timestep loop: update() is called exactly `updateRate`
+		 * times per second of wall time (on average), independently of how often
+		 * render(alpha) is called. Ticks and getFPS() count rendered frames.
+		 *
+		 * `alpha` in [0, 1) is how far the current time is between the last update
+		 * and the next one, for interpolating between the previous and current state.
+		 *
+		 * If updates can't keep up, at most FixedStepConfig::maxUpdatesPerFrame of them
+		 * run before the next frame and the remaining ticks are dropped, which keeps a
+		 * slow update from making every following frame slower ("spiral of death").
+		 */
+		template<FreqOrPeriod SpeedT>
+		void runFixed(
+			SpeedT updateRate,
+			const std::function<void(void)>& update,
+			const std::function<void(double)>& render,
+			const FixedStepConfig& config = {}
+		) {
+			double dt = Seconds(updateRate).getSeconds();
+			if(!(dt > 0.0) || config.maxUpdatesPerFrame < 1) {
+				throw Exception("Invalid fixed timestep configuration");
+			}
+			resetFixedStepStats();
+			if(config.separateUpdateThread) {
+				runFixedThreaded(dt, update, render, config);
+			} else {
+				runFixedSingleThreaded(dt, update, render, config);
 			}
 			exitFlag = false;
 		}
 
+		/// @return Update metrics for the current (or last) runFixed() call.
+		[[nodiscard]] FixedStepStats getFixedStepStats() const {
+			return {
+				.numUpdates = numUpdates.load(std::memory_order_relaxed),
+				.numCatchUpUpdates = numCatchUpUpdates.load(std::memory_order_relaxed),
+				.numDroppedTicks = numDroppedTicks.load(std::memory_order_relaxed),
+				.lastAlpha = lastAlpha
+			};
+		}
+
 		[[nodiscard]] int64_t getTick() const {
 			return tick;
 		}
@@ -128,15 +207,162 @@ namespace al {
 			return lastTickTime;
 		}
 
+		/// @brief Dispatches events until the queue is empty. Called by run() before every tick.
+		void processEvents() {
+			if(eventBatchSize == 0) {
+				while(auto event = eventQueue.tryPop()) {
+					eventDispatcher.dispatch(event->get());
+				}
+				return;
+			}
+			while(!eventQueue.popAll(eventBatch, eventBatchSize).empty()) {
+				for(const auto& event: eventBatch) {
+					eventDispatcher.dispatch(event);
+				}
+			}
+		}
+
 		EventQueue eventQueue;
 		EventDispatcher eventDispatcher;
 		FramerateLimiter framerateLimiter;
 		FPSCounter fpsCounter;
+
+		/**
+		 * Frame times of run() and runFixed(), with the sections "wait" (framerate limiter),
+		 * "events", "body" (run() only), "update" and "render" (runFixed() only). Parts of
+		 * the loop body can be measured too:
+		 * {@code auto flip = loop.profiler.addSection("flip"); ... auto s = loop.profiler.scope(flip);}
+		 * Updates on a separate thread are not measured.
+		 */
+		FrameProfiler profiler;
 	private:
+		void acknowledgeTick() {
+			double endTickTime = GetTime();
+			if(lastTimeOfTick > 0.0) {
+				lastTickTime = endTickTime - lastTimeOfTick;
+			}
+			lastTimeOfTick = endTickTime;
+			fpsCounter.acknowledgeFrame();
+			profiler.endFrame();
+			tick++;
+		}
+
+		void resetFixedStepStats() {
+			numUpdates = 0;
+			numCatchUpUpdates = 0;
+			numDroppedTicks = 0;
+			lastAlpha = 0.0;
+		}
+
+		/*
+		 * Runs the updates that are due at time `now`, given the time `nextUpdate`
+		 * at which the next one is due, and returns the new value of `nextUpdate`.
+		 */
+		double runDueUpdates(double now, double nextUpdate, double dt, const std::function<void(void)>& update, int maxUpdates) {
+			int n = 0;
+			while(now >= nextUpdate && n < maxUpdates && !exitFlag) {
+				update();
+				nextUpdate += dt;
+				n++;
+			}
+			numUpdates.fetch_add(n, std::memory_order_relaxed);
+			if(n > 1) {
+				numCatchUpUpdates.fetch_add(n - 1, std::memory_order_relaxed);
+			}
+			if(now >= nextUpdate && n == maxUpdates) {
+				auto dropped = int64_t(std::floor((now - nextUpdate) / dt)) + 1;
+				numDroppedTicks.fetch_add(dropped, std::memory_order_relaxed);
+				nextUpdate += double(dropped) * dt;
+			}
+			return nextUpdate;
+		}
+
+		void renderFixed(double now, double nextUpdate, double dt, const std::function<void(double)>& render) {
+			lastAlpha = std::clamp(1.0 - (nextUpdate - now) / dt, 0.0, std::nextafter(1.0, 0.0));
+			{
+				auto section = profiler.scope(renderSection);
+				render(lastAlpha);
+			}
+			acknowledgeTick();
+		}
+
+		void runFixedSingleThreaded(double dt, const std::function<void(void)>& update, const std::function<void(double)>& render, const FixedStepConfig& config) {
+			double nextUpdate = GetTime();
+			while(!exitFlag) {
+				{
+					auto section = profiler.scope(waitSection);
+					framerateLimiter.wait();
+				}
+				{
+					auto section = profiler.scope(eventsSection);
+					processEvents();
+				}
+				{
+					auto section = profiler.scope(updateSection);
+					nextUpdate = runDueUpdates(GetTime(), nextUpdate, dt, update, config.maxUpdatesPerFrame);
+				}
+				renderFixed(GetTime(), nextUpdate, dt, render);
+			}
+		}
+
+		void runFixedThreaded(double dt, const std::function<void(void)>& update, const std::function<void(double)>& render, const FixedStepConfig& config) {
+			std::atomic<double> sharedNextUpdate = GetTime();
+			std::exception_ptr updateException;
+
+			std::jthread updateThread([&](std::stop_token stopToken) {
+				try {
+					double nextUpdate = sharedNextUpdate.load();
+					while(!stopToken.stop_requested() && !exitFlag) {
+						double now = GetTime();
+						if(now < nextUpdate) {
+							Sleep(nextUpdate - now);
+							continue;
+						}
+						nextUpdate = runDueUpdates(now, nextUpdate, dt, update, config.maxUpdatesPerFrame);
+						sharedNextUpdate.store(nextUpdate);
+					}
+				} catch(...) {
+					updateException = std::current_exception();
+					exitFlag = true;
+				}
+			});
+
+			while(!exitFlag) {
+				{
+					auto section = profiler.scope(waitSection);
+					framerateLimiter.wait();
+				}
+				{
+					auto section = profiler.scope(eventsSection);
+					processEvents();
+				}
+				renderFixed(GetTime(), sharedNextUpdate.load(), dt, render);
+			}
+			updateThread.request_stop();
+			updateThread.join();
+			if(updateException) {
+				exitFlag = false;
+				std::rethrow_exception(updateException);
+			}
+		}
+
+		FrameProfiler::SectionID waitSection = profiler.addSection("wait");
+		FrameProfiler::SectionID eventsSection = profiler.addSection("events");
+		FrameProfiler::SectionID bodySection = profiler.addSection("body");
+		FrameProfiler::SectionID updateSection = profiler.addSection("update");
+		FrameProfiler::SectionID renderSection = profiler.addSection("render");
+
+		EventBatch eventBatch;
+		uint32_t eventBatchSize = 256;
 		int64_t tick = 0;
 		double lastTimeOfTick = -1.0;
 		double lastTickTime = 0.01;
-		bool exitFlag = false;
+		std::atomic<bool> exitFlag = false;
+
+		std::atomic<int64_t> numUpdates = 0;
+		std::atomic<int64_t> numCatchUpUpdates = 0;
+		std::atomic<int64_t> numDroppedTicks = 0;
+		double lastAlpha = 0.0;
 	};
 }
 
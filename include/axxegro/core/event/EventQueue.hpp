@@ -5,7 +5,11 @@
 #include "EventSource.hpp"
 #include "../../common.hpp"
 
+#include <algorithm>
+#include <limits>
 #include <optional>
+#include <span>
+#include <vector>
 
 
 namespace al {
@@ -40,6 +44,70 @@ namespace al {
 		Event event;
 	};
 
+	/**
+	 * @brief Releases the user event data held by events obtained with
+	 * EventQueue::drainInto(). Other events are left alone.
+	 */
+	inline void ReleaseEvents(std::span<Event> events) {
+		for(auto& ev: events) {
+			if(ALLEGRO_EVENT_TYPE_IS_USER(ev.type)) {
+				al_unref_user_event(&ev.user);
+				ev.type = 0;
+			}
+		}
+	}
+
+	/**
+	 * @brief A reusable buffer of events filled by EventQueue::popAll().
+	 * Owns the events it holds, like EventOwner does for a single one.
+	 */
+	class EventBatch {
+	public:
+		explicit EventBatch(size_t initialCapacity = 64)
+		{
+			storage.resize(initialCapacity);
+		}
+
+		EventBatch(const EventBatch&) = delete;
+		EventBatch& operator=(const EventBatch&) = delete;
+
+		~EventBatch() {
+			clear();
+		}
+
+		/// @brief Releases all held events. The buffer's capacity is kept.
+		void clear() {
+			ReleaseEvents(std::span(storage).first(count));
+			count = 0;
+		}
+
+		[[nodiscard]] std::span<const Event> events() const {
+			return std::span(storage).first(count);
+		}
+
+		[[nodiscard]] const Event* begin() const {
+			return storage.data();
+		}
+
+		[[nodiscard]] const Event* end() const {
+			return storage.data() + count;
+		}
+
+		[[nodiscard]] size_t size() const {
+			return count;
+		}
+
+		[[nodiscard]] bool empty() const {
+			return count == 0;
+		}
+
+	private:
+		friend class EventQueue;
+
+		std::vector<Event> storage;
+		size_t count = 0;
+	};
+
 	class EventQueue:
 			RequiresInitializables<CoreAllegro>,
 			public Resource<ALLEGRO_EVENT_QUEUE> {
@@ -90,10 +158,52 @@ namespace al {
 		}
 
 		std::optional<EventOwner> tryPop() {
-			if(empty()) {
-				return {};
+			ALLEGRO_EVENT ret;
+			if(!al_get_next_event(ptr(), &ret)) {
+				return std::nullopt;
+			}
+			return EventOwner(ret);
+		}
+
+		/**
+		 * @brief Pops events into `buffer` until it is full or the queue is empty.
+		 *
+		 * Unlike calling empty() and pop() in a loop, this takes the queue's
+		 * lock once per event. The caller takes ownership of the events
+		 * and must pass them to ReleaseEvents() once done with them.
+		 *
+		 * @return The number of events written to the front of the buffer.
+		 */
+		size_t drainInto(std::span<Event> buffer) {
+			size_t n = 0;
+			while(n < buffer.size() && al_get_next_event(ptr(), &buffer[n])) {
+				n++;
+			}
+			return n;
+		}
+
+		/**
+		 * @brief Replaces the contents of `batch` with up to `maxEvents` events
+		 * popped from the queue, growing the batch's buffer as needed.
+		 *
+		 * @return `batch`, to be iterated over:
+		 * {@code for(const auto& ev: queue.popAll(batch)) {...}}
+		 */
+		EventBatch& popAll(EventBatch& batch, size_t maxEvents = std::numeric_limits<size_t>::max()) {
+			batch.clear();
+			auto& storage = batch.storage;
+			while(batch.count < maxEvents) {
+				if(batch.count == storage.size()) {
+					storage.resize(std::max<size_t>(64, storage.size() * 2));
+				}
+				size_t limit = std::min(storage.size(), maxEvents);
+				size_t n = drainInto(std::span(storage).subspan(batch.count, limit - batch.count));
+				batch.count += n;
+				if(batch.count < limit) {
+					break;
+				}
 			}
-			return pop();
+			return batch;
 		}
 		
 		/**
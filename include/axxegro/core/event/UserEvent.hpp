@@ -180,7 +180,7 @@ namespace al {
 
 	template<UserEventType T>
 	struct EventDataGetter<T> {
-		const T& operator()(const Event(ev)) {
+		const T& operator()(const Event& ev) {
 			return GetUserEventData<T>(ev);
 		}
 	};
@@ -5,7 +5,14 @@
 #include "gfx/Bitmap.hpp"
 #include "gfx/TargetBitmap.hpp"
 #include "gfx/Blender.hpp"
+#include "gfx/RenderStateCache.hpp"
+#include "gfx/RenderTargetPool.hpp"
 #include "gfx/Color.hpp"
 #include "gfx/PixelFormat.hpp"
+#include "gfx/PixelConvert.hpp"
+#include "gfx/ParallelPixels.hpp"
+#include "gfx/ImageFilter.hpp"
+#include "gfx/SoftwareBlit.hpp"
+#include "gfx/TextureAtlas.hpp"
 
 #endif //AXXEGRO_GFX_HPP
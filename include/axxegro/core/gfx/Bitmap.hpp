@@ -4,6 +4,7 @@
 #include "../../common.hpp"
 #include "Color.hpp"
 #include "Pixel.hpp"
+#include "RenderStateCache.hpp"
 
 #include "axxegro/com/Exception.hpp"
 #include "axxegro/com/Resource.hpp"
@@ -16,7 +17,12 @@
  */
 
 namespace al {
-	AXXEGRO_DEFINE_DELETER(ALLEGRO_BITMAP, al_destroy_bitmap);
+	template<> struct Deleter<ALLEGRO_BITMAP> {
+		inline void operator()(ALLEGRO_BITMAP* p) {
+			RenderStateCache::ThisThread().forgetBitmap(p);
+			al_destroy_bitmap(p);
+		}
+	};
 
 	class BaseLockedBitmapRegion;
 	class Bitmap;
@@ -34,14 +40,14 @@ namespace al {
 	public:
 		explicit ScopedTargetBitmap(ALLEGRO_BITMAP* bmp)
 		{
-			oldTarget = al_get_target_bitmap();
-			al_set_target_bitmap(bmp);
+			oldTarget = RenderStateCache::ThisThread().getTargetBitmap();
+			RenderStateCache::ThisThread().setTargetBitmap(bmp);
 		}
 		explicit ScopedTargetBitmap(Bitmap& bmp);
 
 		~ScopedTargetBitmap()
 		{
-			al_set_target_bitmap(oldTarget);
+			RenderStateCache::ThisThread().setTargetBitmap(oldTarget);
 		}
 		
 		ScopedTargetBitmap(const ScopedTargetBitmap&) = delete;
@@ -96,6 +102,16 @@ namespace al {
 			return {width(), height()};
 		}
 
+		/// @return The pixel format of the bitmap.
+		[[nodiscard]] ALLEGRO_PIXEL_FORMAT getFormat() const {
+			return (ALLEGRO_PIXEL_FORMAT)al_get_bitmap_format(ptr());
+		}
+
+		/// @return The flags the bitmap was created with (e.g. ALLEGRO_MEMORY_BITMAP).
+		[[nodiscard]] int getFlags() const {
+			return al_get_bitmap_flags(ptr());
+		}
+
 		/**
 		 * @return A rectangle spanning the entire bitmap, with the top left corner at (0, 0)
 		 * and the bottom left corner at (width, height). Useful for the drawScaled() family
@@ -291,6 +307,12 @@ namespace al {
 		static void SetNewBitmapFlags(int flags) {
 			al_set_new_bitmap_flags(flags);
 		}
+		static int GetNewBitmapFormat() {
+			return al_get_new_bitmap_format();
+		}
+		static void SetNewBitmapFormat(int format) {
+			al_set_new_bitmap_format(format);
+		}
 
 		friend class Video;
 	protected:
@@ -321,6 +343,23 @@ namespace al {
 		}
 	};
 
+	/**
+	 * @brief Provides a RAII-style mechanism for setting the new bitmap format.
+	 */
+	class ScopedNewBitmapFormat {
+		int oldFormat;
+	public:
+		explicit ScopedNewBitmapFormat(int newFormat)
+		{
+			oldFormat = Bitmap::GetNewBitmapFormat();
+			Bitmap::SetNewBitmapFormat(newFormat);
+		}
+		~ScopedNewBitmapFormat()
+		{
+			Bitmap::SetNewBitmapFormat(oldFormat);
+		}
+	};
+
 
 	class SubBitmap: public Bitmap {
 	public:
@@ -335,7 +374,9 @@ namespace al {
 			if(rect.width() < 0) {
 				rect = mrect;
 			}
-			al_reparent_bitmap(bitmap.ptr(), ptr(), rect.a.x, rect.a.y, rect.width(), rect.height());
+			al_reparent_bitmap(ptr(), bitmap.ptr(), rect.a.x, rect.a.y, rect.width(), rect.height());
+			mrect = rect;
+			parent = Bitmap(bitmap.ptr(), ResourceModel::NonOwning);
 			return true;
 		}
 
@@ -4,6 +4,7 @@
 
 #include <allegro5/allegro.h>
 #include "Color.hpp"
+#include "RenderStateCache.hpp"
 
 namespace al {
 	
@@ -18,25 +19,27 @@ namespace al {
 	};
 	
 	inline Blender GetBlender() {
-		Blender ret;
-		al_get_blender(&ret.op, &ret.src, &ret.dst);
+		Blender ret, alpha;
+		RenderStateCache::ThisThread().getSeparateBlender(&ret.op, &ret.src, &ret.dst,
+														  &alpha.op, &alpha.src, &alpha.dst);
 		return ret;
 	}
 	
 	inline void SetBlender(Blender blender) {
-		al_set_blender(blender.op, blender.src, blender.dst);
+		RenderStateCache::ThisThread().setSeparateBlender(blender.op, blender.src, blender.dst,
+														  blender.op, blender.src, blender.dst);
 	}
 	
 	inline SeparateBlender GetSeparateBlender() {
 		SeparateBlender ret;
-		al_get_separate_blender(&ret.color.op, &ret.color.src, &ret.color.dst,
-								&ret.alpha.op, &ret.alpha.src, &ret.alpha.dst);
+		RenderStateCache::ThisThread().getSeparateBlender(&ret.color.op, &ret.color.src, &ret.color.dst,
+														  &ret.alpha.op, &ret.alpha.src, &ret.alpha.dst);
 		return ret;
 	}
 	
 	inline void SetSeparateBlender(SeparateBlender blender) {
-		al_set_separate_blender(blender.color.op, blender.color.src, blender.color.dst,
-								blender.alpha.op, blender.alpha.src, blender.alpha.dst);
+		RenderStateCache::ThisThread().setSeparateBlender(blender.color.op, blender.color.src, blender.color.dst,
+														  blender.alpha.op, blender.alpha.src, blender.alpha.dst);
 		
 	}
 	
@@ -64,11 +67,11 @@ namespace al {
 	
 	
 	inline Color GetBlendColor() {
-		return al_get_blend_color();
+		return RenderStateCache::ThisThread().getBlendColor();
 	}
 	
 	inline void SetBlendColor(Color color) {
-		al_set_blend_color(color);
+		RenderStateCache::ThisThread().setBlendColor(color);
 	}
 	
 }
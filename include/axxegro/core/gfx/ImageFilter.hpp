@@ -0,0 +1,688 @@
+#ifndef AXXEGRO_IMAGEFILTER_HPP
+#define AXXEGRO_IMAGEFILTER_HPP
+
+#include "Bitmap.hpp"
+#include "ParallelPixels.hpp"
+#include "PixelConvert.hpp"
+
+#include "axxegro/com/Exception.hpp"
+#include "axxegro/com/util/Simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <vector>
+
+/**
+ * @file
+ * Image filters over locked regions of 4-byte pixels (PixelARGB8888,
+ * PixelRGBA8888 and the like): blurs, convolution, color matrices, levels,
+ * threshold and grayscale. All of them work in place.
+ *
+ * Filters that look at neighbouring rows stream through the image: each band
+ * of rows (processed in parallel, see ParallelOptions) keeps only a window of
+ * 2*radius+1 intermediate rows, so no full-size temporary image is allocated.
+ * Pixels beyond the edges are treated as copies of the nearest edge pixel.
+ *
+ * Filters operate on the stored channel values. On premultiplied images this
+ * is exact for blurs and convolutions; color matrices, levels and threshold
+ * should be applied to opaque or unpremultiplied pixels.
+ */
+
+namespace al {
+
+	/**
+	 * @brief A 3x3 or 5x5 convolution kernel. Each output channel is the sum of
+	 * weight * input over the neighbourhood, plus bias (in 0..1 units).
+	 */
+	struct ConvolutionKernel {
+		int size = 3;
+		std::array<float, 25> weights {}; ///< Row-major, the first size*size are used.
+		float bias = 0.0f;
+		bool filterAlpha = false; ///< If false, alpha is left as is.
+
+		[[nodiscard]] float at(int x, int y) const {
+			return weights[y * size + x];
+		}
+
+		static ConvolutionKernel Sharpen(float amount = 1.0f) {
+			return {3, {
+				0, -amount, 0,
+				-amount, 1 + 4*amount, -amount,
+				0, -amount, 0
+			}};
+		}
+
+		static ConvolutionKernel EdgeDetect() {
+			return {3, {
+				-1, -1, -1,
+				-1, 8, -1,
+				-1, -1, -1
+			}};
+		}
+
+		static ConvolutionKernel Emboss() {
+			return {3, {
+				-2, -1, 0,
+				-1, 1, 1,
+				0, 1, 2
+			}};
+		}
+	};
+
+	/**
+	 * @brief A 4x5 matrix applied to (r, g, b, a, 1) with channels in 0..1 units.
+	 */
+	struct ColorMatrix {
+		std::array<std::array<float, 5>, 4> m {{
+			{1, 0, 0, 0, 0},
+			{0, 1, 0, 0, 0},
+			{0, 0, 1, 0, 0},
+			{0, 0, 0, 1, 0}
+		}};
+
+		static ColorMatrix Identity() {
+			return {};
+		}
+
+		/// 0 is grayscale (Rec. 709 luma), 1 leaves the image as is, >1 oversaturates.
+		static ColorMatrix Saturation(float s) {
+			constexpr float R = 0.2126f, G = 0.7152f, B = 0.0722f;
+			ColorMatrix ret;
+			ret.m[0] = {R + (1-R)*s, G - G*s, B - B*s, 0, 0};
+			ret.m[1] = {R - R*s, G + (1-G)*s, B - B*s, 0, 0};
+			ret.m[2] = {R - R*s, G - G*s, B + (1-B)*s, 0, 0};
+			return ret;
+		}
+
+		static ColorMatrix Brightness(float offset) {
+			ColorMatrix ret;
+			for(int c=0; c<3; c++) {
+				ret.m[c][4] = offset;
+			}
+			return ret;
+		}
+
+		/// Scales the distance of r, g and b from 0.5.
+		static ColorMatrix Contrast(float c) {
+			ColorMatrix ret;
+			for(int i=0; i<3; i++) {
+				ret.m[i][i] = c;
+				ret.m[i][4] = 0.5f * (1.0f - c);
+			}
+			return ret;
+		}
+
+		static ColorMatrix Invert() {
+			ColorMatrix ret;
+			for(int c=0; c<3; c++) {
+				ret.m[c][c] = -1;
+				ret.m[c][4] = 1;
+			}
+			return ret;
+		}
+
+		/// @return The matrix that applies `rhs` first, then this one.
+		[[nodiscard]] ColorMatrix operator*(const ColorMatrix& rhs) const {
+			ColorMatrix ret;
+			for(int i=0; i<4; i++) {
+				for(int j=0; j<5; j++) {
+					float v = j == 4 ? m[i][4] : 0.0f;
+					for(int k=0; k<4; k++) {
+						v += m[i][k] * rhs.m[k][j];
+					}
+					ret.m[i][j] = v;
+				}
+			}
+			return ret;
+		}
+	};
+
+	/**
+	 * @brief Photoshop-style levels for r, g and b: inputs in [inBlack, inWhite]
+	 * are stretched to [0, 1], gamma-corrected, then mapped to [outBlack, outWhite].
+	 */
+	struct Levels {
+		float inBlack = 0.0f;
+		float inWhite = 1.0f;
+		float gamma = 1.0f;
+		float outBlack = 0.0f;
+		float outWhite = 1.0f;
+	};
+
+	namespace detail::imgfilter {
+		using pxconv::Byte4Pixel;
+		using pxconv::ChannelOffsets;
+
+		constexpr int MaxGaussianRadius = 63;
+
+		/* A sliding window over the last `size` rows pushed */
+		template<typename T>
+		class RowRing {
+		public:
+			RowRing(int size, size_t rowLength)
+				: size(size), rowLength(rowLength), storage(size_t(size) * rowLength)
+			{}
+
+			/* the slot for the next row, which replaces the oldest one */
+			T* push() {
+				T* ret = storage.data() + size_t(count % size) * rowLength;
+				count++;
+				return ret;
+			}
+
+			/* i-th row of the window, 0 being the oldest */
+			[[nodiscard]] const T* window(int i) const {
+				return storage.data() + size_t((count + i) % size) * rowLength;
+			}
+
+			/* the row that the next push() will overwrite, or nullptr if the window isn't full yet */
+			[[nodiscard]] const T* oldest() const {
+				return count >= size ? window(0) : nullptr;
+			}
+
+		private:
+			int size;
+			size_t rowLength;
+			std::vector<T> storage;
+			int count = 0;
+		};
+
+		/* Copies a row into `dst` with `pad` copies of the edge pixels on both sides */
+		inline void PadRow(std::byte* dst, const std::byte* src, int width, int pad) {
+			for(int i=0; i<pad; i++) {
+				std::memcpy(dst + 4*i, src, 4);
+				std::memcpy(dst + 4*(pad + width + i), src + 4*(width - 1), 4);
+			}
+			std::memcpy(dst + 4*pad, src, 4*size_t(width));
+		}
+
+		/*
+		 * Runs a neighbourhood filter in place over row bands in parallel.
+		 * makeFilter() creates the per-band state, which must have
+		 *   push(const std::byte* row): takes the next input row, in order,
+		 *   emit(std::byte* row): writes the output for the middle row of the last 2*radius+1 pushed.
+		 * The rows just outside each band are copied before anything is written,
+		 * so that neighbouring bands see the original pixels.
+		 */
+		template<typename RegionT, typename MakeFilterFn>
+		void StreamFilter(RegionT& region, int radius, const ParallelOptions& opt, MakeFilterFn&& makeFilter) {
+			int w = region.width(), h = region.height();
+			if(w <= 0 || h <= 0) {
+				return;
+			}
+			ParallelOptions bandOpt = opt;
+			bandOpt.minRowsPerBand = std::max(opt.minRowsPerBand, 4 * radius);
+			RowBands bands = SplitRows(h, bandOpt);
+
+			size_t rowBytes = 4 * size_t(w);
+			auto rowPtr = [&](int y) {
+				return static_cast<std::byte*>(region.rawRowData(unsigned(y)));
+			};
+
+			/* halo[band] holds rows [y0 - radius, y0) and [y1, y1 + radius), clamped to the image */
+			std::vector<std::vector<std::byte>> halos(size_t(bands.numBands));
+			for(int b=0; b<bands.numBands; b++) {
+				auto& halo = halos[size_t(b)];
+				halo.resize(rowBytes * size_t(2 * radius));
+				for(int i=0; i<radius; i++) {
+					int above = std::clamp(bands.begin(b) - radius + i, 0, h - 1);
+					int below = std::clamp(bands.end(b) + i, 0, h - 1);
+					std::memcpy(halo.data() + rowBytes * size_t(i), rowPtr(above), rowBytes);
+					std::memcpy(halo.data() + rowBytes * size_t(radius + i), rowPtr(below), rowBytes);
+				}
+			}
+
+			ParallelBands(bands, [&](int band, int y0, int y1) {
+				const auto& halo = halos[size_t(band)];
+				/* rows inside the band are read only before being overwritten */
+				auto inputRow = [&](int y) -> const std::byte* {
+					if(y < y0) {
+						int i = std::max(y, y0 - radius) - (y0 - radius);
+						return halo.data() + rowBytes * size_t(i);
+					}
+					if(y >= y1) {
+						y = std::min(y, h - 1);
+						if(y >= y1) {
+							return halo.data() + rowBytes * size_t(radius + (y - y1));
+						}
+					}
+					return rowPtr(y);
+				};
+
+				auto filter = makeFilter();
+				for(int y = y0 - radius; y < y0 + radius; y++) {
+					filter.push(inputRow(y));
+				}
+				for(int y=y0; y<y1; y++) {
+					filter.push(inputRow(y + radius));
+					filter.emit(rowPtr(y));
+				}
+			});
+		}
+
+		/*
+		 * Fixed-point separable Gaussian. Weights sum to 65536 and are applied
+		 * with a high-half multiply to values with 8 fractional bits, so the
+		 * intermediate rows fit in 16 bits. Sums start at taps/2 to make up for
+		 * the truncation of each product.
+		 */
+		class GaussianRows {
+		public:
+			GaussianRows(int width, const std::vector<uint16_t>& weights)
+				: width(width), radius(int(weights.size() / 2)), weights(weights),
+				  padded(4 * size_t(width + 2 * radius)), ring(2 * radius + 1, 4 * size_t(width))
+			{}
+
+			void push(const std::byte* row) {
+				PadRow(padded.data(), row, width, radius);
+				const auto* src = reinterpret_cast<const uint8_t*>(padded.data());
+				uint16_t* dst = ring.push();
+				size_t n = 4 * size_t(width), i = 0;
+				int taps = 2 * radius + 1;
+#ifdef AXXEGRO_SIMD_SSE2
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i start = _mm_set1_epi16(short(taps / 2));
+				for(; i+16 <= n; i += 16) {
+					__m128i lo = start, hi = start;
+					for(int k=0; k<taps; k++) {
+						__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4*k));
+						__m128i wk = _mm_set1_epi16(short(weights[size_t(k)]));
+						lo = _mm_add_epi16(lo, _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, v), wk));
+						hi = _mm_add_epi16(hi, _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, v), wk));
+					}
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), lo);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 8), hi);
+				}
+#endif
+				for(; i<n; i++) {
+					uint32_t acc = uint32_t(taps / 2);
+					for(int k=0; k<taps; k++) {
+						acc += (uint32_t(src[i + 4*k]) * 256 * weights[size_t(k)]) >> 16;
+					}
+					dst[i] = uint16_t(acc);
+				}
+			}
+
+			void emit(std::byte* row) {
+				auto* dst = reinterpret_cast<uint8_t*>(row);
+				size_t n = 4 * size_t(width), i = 0;
+				int taps = 2 * radius + 1;
+#ifdef AXXEGRO_SIMD_SSE2
+				const __m128i bias = _mm_set1_epi16(128);
+				const __m128i start = _mm_set1_epi16(short(taps / 2));
+				for(; i+16 <= n; i += 16) {
+					__m128i lo = start, hi = start;
+					for(int k=0; k<taps; k++) {
+						const uint16_t* h = ring.window(k) + i;
+						__m128i wk = _mm_set1_epi16(short(weights[size_t(k)]));
+						lo = _mm_add_epi16(lo, _mm_mulhi_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)), wk));
+						hi = _mm_add_epi16(hi, _mm_mulhi_epu16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h + 8)), wk));
+					}
+					lo = _mm_srli_epi16(_mm_add_epi16(lo, bias), 8);
+					hi = _mm_srli_epi16(_mm_add_epi16(hi, bias), 8);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+				}
+#endif
+				for(; i<n; i++) {
+					uint32_t acc = uint32_t(taps / 2);
+					for(int k=0; k<taps; k++) {
+						acc += (uint32_t(ring.window(k)[i]) * weights[size_t(k)]) >> 16;
+					}
+					dst[i] = uint8_t(std::min<uint32_t>((acc + 128) >> 8, 255));
+				}
+			}
+
+		private:
+			int width;
+			int radius;
+			const std::vector<uint16_t>& weights;
+			std::vector<std::byte> padded;
+			RowRing<uint16_t> ring;
+		};
+
+		/* Gaussian weights for the given radius, rounded to integers summing to 65536 */
+		inline std::vector<uint16_t> GaussianWeights(float sigma, int radius) {
+			constexpr uint32_t Total = 65536;
+			std::vector<double> w(size_t(2 * radius + 1));
+			double sum = 0;
+			for(int i=-radius; i<=radius; i++) {
+				w[size_t(i + radius)] = std::exp(-double(i * i) / (2.0 * double(sigma) * sigma));
+				sum += w[size_t(i + radius)];
+			}
+			std::vector<uint16_t> ret(w.size());
+			uint32_t side = 0;
+			for(size_t i=0; i<w.size(); i++) {
+				if(int(i) != radius) {
+					ret[i] = uint16_t(std::lround(w[i] / sum * Total));
+					side += ret[i];
+				}
+			}
+			/* the remainder goes to the center; it must fit in 16 bits */
+			ret[size_t(radius)] = uint16_t(std::min<uint32_t>(Total - side, 65535));
+			return ret;
+		}
+
+		/* Box blur with running sums: O(1) per pixel for any radius */
+		class BoxRows {
+		public:
+			BoxRows(int width, int radius)
+				: width(width), radius(radius), padded(4 * size_t(width + 2 * radius)),
+				  ring(2 * radius + 1, 4 * size_t(width)), columnSums(4 * size_t(width), 0),
+				  scale(1.0f / float(2 * radius + 1))
+			{}
+
+			void push(const std::byte* row) {
+				size_t n = 4 * size_t(width);
+				if(const uint8_t* leaving = ring.oldest()) {
+					for(size_t i=0; i<n; i++) {
+						columnSums[i] -= leaving[i];
+					}
+				}
+
+				PadRow(padded.data(), row, width, radius);
+				const auto* src = reinterpret_cast<const uint8_t*>(padded.data());
+				uint8_t* dst = ring.push();
+				uint32_t sums[4] = {};
+				for(int k=0; k<2*radius; k++) {
+					for(int c=0; c<4; c++) {
+						sums[c] += src[4*k + c];
+					}
+				}
+				for(size_t x=0; x<size_t(width); x++) {
+					for(size_t c=0; c<4; c++) {
+						sums[c] += src[4*(x + 2*radius) + c];
+						dst[4*x + c] = uint8_t(float(sums[c]) * scale + 0.5f);
+						sums[c] -= src[4*x + c];
+					}
+				}
+				for(size_t i=0; i<n; i++) {
+					columnSums[i] += dst[i];
+				}
+			}
+
+			void emit(std::byte* row) {
+				auto* dst = reinterpret_cast<uint8_t*>(row);
+				size_t n = 4 * size_t(width), i = 0;
+#ifdef AXXEGRO_SIMD_SSE2
+				const __m128 s = _mm_set1_ps(scale);
+				auto average = [&](size_t j) {
+					__m128 v = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(columnSums.data() + j)));
+					return _mm_cvtps_epi32(_mm_mul_ps(v, s));
+				};
+				for(; i+16 <= n; i += 16) {
+					__m128i lo = _mm_packs_epi32(average(i), average(i + 4));
+					__m128i hi = _mm_packs_epi32(average(i + 8), average(i + 12));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(lo, hi));
+				}
+#endif
+				for(; i<n; i++) {
+					dst[i] = uint8_t(std::min(std::lrint(float(columnSums[i]) * scale), 255L));
+				}
+			}
+
+		private:
+			int width;
+			int radius;
+			std::vector<std::byte> padded;
+			RowRing<uint8_t> ring;
+			std::vector<uint32_t> columnSums;
+			float scale;
+		};
+
+		/* General 3x3/5x5 convolution in float, one pixel per SSE register */
+		template<typename T>
+		class ConvolutionRows {
+		public:
+			ConvolutionRows(int width, const ConvolutionKernel& kernel)
+				: width(width), radius(kernel.size / 2), kernel(kernel),
+				  padded(4 * size_t(width + 2 * radius)), ring(kernel.size, 4 * size_t(width + 2 * radius))
+			{}
+
+			void push(const std::byte* row) {
+				PadRow(padded.data(), row, width, radius);
+				float* dst = ring.push();
+				for(size_t i=0; i<padded.size(); i++) {
+					dst[i] = float(uint8_t(padded[i]));
+				}
+			}
+
+			void emit(std::byte* row) {
+				constexpr int A = ChannelOffsets<T>()[3];
+				const int size = kernel.size;
+				const float bias = kernel.bias * 255.0f;
+				size_t x = 0;
+#ifdef AXXEGRO_SIMD_SSE2
+				if constexpr(pxconv::IsLittleEndian) {
+					__m128 w[25];
+					for(int i=0; i<size*size; i++) {
+						w[i] = _mm_set1_ps(kernel.weights[size_t(i)]);
+					}
+					const __m128 vbias = _mm_set1_ps(bias);
+					const __m128i keepAlpha = kernel.filterAlpha ? _mm_setzero_si128() : _mm_setr_epi32(A == 0 ? -1 : 0, A == 1 ? -1 : 0, A == 2 ? -1 : 0, A == 3 ? -1 : 0);
+					const float* center = ring.window(radius);
+					for(; x < size_t(width); x++) {
+						__m128 acc = vbias;
+						for(int ky=0; ky<size; ky++) {
+							const float* src = ring.window(ky) + 4*x;
+							for(int kx=0; kx<size; kx++) {
+								acc = _mm_add_ps(acc, _mm_mul_ps(w[ky*size + kx], _mm_loadu_ps(src + 4*kx)));
+							}
+						}
+						__m128i v = _mm_cvtps_epi32(acc);
+						__m128i orig = _mm_cvtps_epi32(_mm_loadu_ps(center + 4*(x + radius)));
+						v = _mm_or_si128(_mm_andnot_si128(keepAlpha, v), _mm_and_si128(keepAlpha, orig));
+						v = _mm_packus_epi16(_mm_packs_epi32(v, v), _mm_setzero_si128());
+						int32_t px = _mm_cvtsi128_si32(v);
+						std::memcpy(row + 4*x, &px, 4);
+					}
+				}
+#endif
+				for(; x < size_t(width); x++) {
+					for(int c=0; c<4; c++) {
+						if(c == A && !kernel.filterAlpha) {
+							row[4*x + c] = std::byte(uint8_t(ring.window(radius)[4*(x + radius) + c]));
+							continue;
+						}
+						float acc = bias;
+						for(int ky=0; ky<size; ky++) {
+							const float* src = ring.window(ky) + 4*x + c;
+							for(int kx=0; kx<size; kx++) {
+								acc += kernel.at(kx, ky) * src[4*kx];
+							}
+						}
+						row[4*x + c] = std::byte(uint8_t(std::clamp(std::lrint(acc), 0L, 255L)));
+					}
+				}
+			}
+
+		private:
+			int width;
+			int radius;
+			const ConvolutionKernel& kernel;
+			std::vector<std::byte> padded;
+			RowRing<float> ring;
+		};
+
+		/* Replaces r, g and b through a 256-entry table */
+		template<Byte4Pixel T>
+		void ApplyTable(std::span<T> row, const std::array<uint8_t, 256>& table) {
+			for(auto& px: row) {
+				px.r = table[px.r];
+				px.g = table[px.g];
+				px.b = table[px.b];
+			}
+		}
+
+		template<Byte4Pixel T>
+		void ApplyColorMatrixRow(std::span<T> row, const ColorMatrix& cm) {
+			constexpr auto Off = ChannelOffsets<T>();
+			size_t x = 0;
+			auto* p = reinterpret_cast<uint8_t*>(row.data());
+#ifdef AXXEGRO_SIMD_SSE2
+			if constexpr(pxconv::IsLittleEndian) {
+				/* the matrix in memory-lane order: column j is multiplied by byte j */
+				std::array<std::array<float, 4>, 5> cols {};
+				for(int out=0; out<4; out++) {
+					for(int in=0; in<4; in++) {
+						cols[size_t(Off[in])][size_t(Off[out])] = cm.m[size_t(out)][size_t(in)];
+					}
+					cols[4][size_t(Off[out])] = cm.m[size_t(out)][4] * 255.0f;
+				}
+				__m128 c0 = _mm_loadu_ps(cols[0].data()), c1 = _mm_loadu_ps(cols[1].data());
+				__m128 c2 = _mm_loadu_ps(cols[2].data()), c3 = _mm_loadu_ps(cols[3].data());
+				__m128 c4 = _mm_loadu_ps(cols[4].data());
+				const __m128i zero = _mm_setzero_si128();
+				for(; x < row.size(); x++) {
+					int32_t px;
+					std::memcpy(&px, p + 4*x, 4);
+					__m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(px), zero), zero);
+					__m128 f = _mm_cvtepi32_ps(v);
+					__m128 acc = _mm_add_ps(c4, _mm_mul_ps(c0, _mm_shuffle_ps(f, f, 0x00)));
+					acc = _mm_add_ps(acc, _mm_mul_ps(c1, _mm_shuffle_ps(f, f, 0x55)));
+					acc = _mm_add_ps(acc, _mm_mul_ps(c2, _mm_shuffle_ps(f, f, 0xAA)));
+					acc = _mm_add_ps(acc, _mm_mul_ps(c3, _mm_shuffle_ps(f, f, 0xFF)));
+					__m128i r = _mm_cvtps_epi32(acc);
+					r = _mm_packus_epi16(_mm_packs_epi32(r, r), zero);
+					px = _mm_cvtsi128_si32(r);
+					std::memcpy(p + 4*x, &px, 4);
+				}
+			}
+#endif
+			for(; x < row.size(); x++) {
+				float in[4], out[4];
+				for(int c=0; c<4; c++) {
+					in[c] = p[4*x + size_t(Off[c])];
+				}
+				for(int c=0; c<4; c++) {
+					const auto& m = cm.m[size_t(c)];
+					out[c] = m[0]*in[0] + m[1]*in[1] + m[2]*in[2] + m[3]*in[3] + m[4]*255.0f;
+				}
+				for(int c=0; c<4; c++) {
+					p[4*x + size_t(Off[c])] = uint8_t(std::clamp(std::lrint(out[c]), 0L, 255L));
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Averages every pixel over the (2*radius+1)^2 square around it,
+	 * using running sums, so the cost doesn't depend on the radius.
+	 */
+	template<detail::pxconv::Byte4Pixel T>
+	void BoxBlur(LockedBitmapRegion<T, false>& region, int radius, const ParallelOptions& opt = {}) {
+		using namespace detail::imgfilter;
+		if(radius <= 0) {
+			return;
+		}
+		StreamFilter(region, radius, opt, [&]() {
+			return BoxRows(region.width(), radius);
+		});
+	}
+
+	/**
+	 * @brief Gaussian blur with the given standard deviation in pixels.
+	 *
+	 * Uses a separable kernel of radius ceil(3 * sigma) in fixed point; above
+	 * a radius of 63 it switches to three successive box blurs, which
+	 * approximate a Gaussian to within a few percent.
+	 */
+	template<detail::pxconv::Byte4Pixel T>
+	void GaussianBlur(LockedBitmapRegion<T, false>& region, float sigma, const ParallelOptions& opt = {}) {
+		using namespace detail::imgfilter;
+		if(!(sigma > 0.0f)) {
+			return;
+		}
+		int radius = int(std::ceil(3.0f * sigma));
+		if(radius > MaxGaussianRadius) {
+			/* box widths whose combined variance matches sigma^2, per Wells (1986) */
+			float ideal = std::sqrt(12.0f * sigma * sigma / 3.0f + 1.0f);
+			int lower = int(ideal);
+			lower -= (lower % 2 == 0);
+			int upper = lower + 2;
+			float m = (12.0f * sigma * sigma - 3.0f * float(lower * lower) - 12.0f * float(lower) - 9.0f) / (-4.0f * float(lower) - 4.0f);
+			int numLower = int(std::lround(m));
+			for(int i=0; i<3; i++) {
+				BoxBlur(region, ((i < numLower ? lower : upper) - 1) / 2, opt);
+			}
+			return;
+		}
+		auto weights = GaussianWeights(sigma, radius);
+		StreamFilter(region, radius, opt, [&]() {
+			return GaussianRows(region.width(), weights);
+		});
+	}
+
+	/**
+	 * @brief Applies a 3x3 or 5x5 convolution kernel.
+	 * @throws Exception if the kernel size is neither 3 nor 5.
+	 */
+	template<detail::pxconv::Byte4Pixel T>
+	void Convolve(LockedBitmapRegion<T, false>& region, const ConvolutionKernel& kernel, const ParallelOptions& opt = {}) {
+		using namespace detail::imgfilter;
+		if(kernel.size != 3 && kernel.size != 5) {
+			throw Exception("Convolution kernels must be 3x3 or 5x5, got %dx%d", kernel.size, kernel.size);
+		}
+		StreamFilter(region, kernel.size / 2, opt, [&]() {
+			return ConvolutionRows<T>(region.width(), kernel);
+		});
+	}
+
+	/// @brief Sharpens with an unsharp-mask style 3x3 kernel.
+	template<detail::pxconv::Byte4Pixel T>
+	void Sharpen(LockedBitmapRegion<T, false>& region, float amount = 1.0f, const ParallelOptions& opt = {}) {
+		Convolve(region, ConvolutionKernel::Sharpen(amount), opt);
+	}
+
+	template<detail::pxconv::Byte4Pixel T>
+	void ApplyColorMatrix(LockedBitmapRegion<T, false>& region, const ColorMatrix& matrix, const ParallelOptions& opt = {}) {
+		ForEachRow(region, [&](int, std::span<T> row) {
+			detail::imgfilter::ApplyColorMatrixRow(row, matrix);
+		}, opt);
+	}
+
+	/// @brief Replaces r, g and b with the Rec. 709 luma.
+	template<detail::pxconv::Byte4Pixel T>
+	void Grayscale(LockedBitmapRegion<T, false>& region, const ParallelOptions& opt = {}) {
+		ApplyColorMatrix(region, ColorMatrix::Saturation(0.0f), opt);
+	}
+
+	template<detail::pxconv::Byte4Pixel T>
+	void ApplyLevels(LockedBitmapRegion<T, false>& region, const Levels& levels, const ParallelOptions& opt = {}) {
+		std::array<uint8_t, 256> table;
+		float range = std::max(levels.inWhite - levels.inBlack, 1e-6f);
+		float invGamma = 1.0f / std::max(levels.gamma, 1e-6f);
+		for(int i=0; i<256; i++) {
+			float t = std::clamp((float(i) / 255.0f - levels.inBlack) / range, 0.0f, 1.0f);
+			t = std::pow(t, invGamma);
+			table[size_t(i)] = detail::pxconv::FloatToByte(levels.outBlack + t * (levels.outWhite - levels.outBlack));
+		}
+		ForEachRow(region, [&](int, std::span<T> row) {
+			detail::imgfilter::ApplyTable(row, table);
+		}, opt);
+	}
+
+	/**
+	 * @brief Sets r, g and b to 1 where the Rec. 709 luma is at least `level`
+	 * and to 0 elsewhere. Alpha is left as is.
+	 */
+	template<detail::pxconv::Byte4Pixel T>
+	void Threshold(LockedBitmapRegion<T, false>& region, float level, const ParallelOptions& opt = {}) {
+		/* luma in 8.8 fixed point; the weights sum to 256 */
+		uint32_t limit = uint32_t(std::clamp(level, 0.0f, 1.0f) * 255.0f * 256.0f + 0.5f);
+		ForEachRow(region, [&](int, std::span<T> row) {
+			for(auto& px: row) {
+				uint32_t luma = 54u * px.r + 183u * px.g + 19u * px.b;
+				uint8_t v = luma >= limit ? 255 : 0;
+				px.r = v;
+				px.g = v;
+				px.b = v;
+			}
+		}, opt);
+	}
+
+}
+
+#endif //AXXEGRO_IMAGEFILTER_HPP
@@ -0,0 +1,159 @@
+#ifndef AXXEGRO_PARALLELPIXELS_HPP
+#define AXXEGRO_PARALLELPIXELS_HPP
+
+#include "Bitmap.hpp"
+
+#include "axxegro/com/Exception.hpp"
+#include "axxegro/com/util/ThreadPool.hpp"
+
+#include <algorithm>
+#include <span>
+#include <utility>
+
+/**
+ * @file
+ * Row-wise processing of locked bitmap regions on multiple threads.
+ *
+ * Locking and unlocking still has to happen on the thread that owns the bitmap;
+ * only the per-row work is distributed. Memory bitmaps
+ * (ALLEGRO_MEMORY_BITMAP) are the natural fit, since locking a video bitmap
+ * already costs a round trip to the GPU.
+ */
+
+namespace al {
+
+	struct ParallelOptions {
+		/// Pool to run on. nullptr means ThreadPool::Default().
+		ThreadPool* pool = nullptr;
+
+		/// Upper limit on the number of threads, including the calling one. 0 means no limit, 1 runs serially.
+		unsigned maxThreads = 0;
+
+		/// Rows are processed in bands of at least this many rows.
+		int minRowsPerBand = 16;
+	};
+
+	namespace detail {
+		/* A split of [0, numRows) into bands of rowsPerBand rows (the last one may be shorter). */
+		struct RowBands {
+			int numRows;
+			int numBands;
+			int rowsPerBand;
+			unsigned numThreads;
+			ThreadPool* pool;
+
+			[[nodiscard]] int begin(int band) const {
+				return band * rowsPerBand;
+			}
+
+			[[nodiscard]] int end(int band) const {
+				return std::min(begin(band) + rowsPerBand, numRows);
+			}
+		};
+
+		inline RowBands SplitRows(int numRows, const ParallelOptions& opt) {
+			ThreadPool& pool = opt.pool ? *opt.pool : ThreadPool::Default();
+			unsigned numThreads = pool.numWorkers() + 1;
+			if(opt.maxThreads) {
+				numThreads = std::min(numThreads, opt.maxThreads);
+			}
+
+			/* a few bands per thread so that uneven rows don't leave threads idle */
+			int minRows = std::max(opt.minRowsPerBand, 1);
+			int numBands = std::clamp<int>(numRows / minRows, 1, int(numThreads) * 4);
+			int rowsPerBand = (numRows + numBands - 1) / numBands;
+			numBands = (numRows + rowsPerBand - 1) / rowsPerBand;
+			return {numRows, numBands, rowsPerBand, numThreads, &pool};
+		}
+
+		/* Calls fn(band, y0, y1) for every band, bands in parallel. */
+		template<typename Fn>
+		void ParallelBands(const RowBands& bands, Fn&& fn) {
+			if(bands.numRows <= 0) {
+				return;
+			}
+			bands.pool->parallelFor(bands.numBands, [&](size_t band) {
+				fn(int(band), bands.begin(int(band)), bands.end(int(band)));
+			}, bands.numThreads);
+		}
+
+		/* Splits [0, numRows) into bands and calls fn(y) for every row, bands in parallel. */
+		template<typename Fn>
+		void ParallelRows(int numRows, const ParallelOptions& opt, Fn&& fn) {
+			if(numRows <= 0) {
+				return;
+			}
+			ParallelBands(SplitRows(numRows, opt), [&](int, int y0, int y1) {
+				for(int y=y0; y<y1; y++) {
+					fn(y);
+				}
+			});
+		}
+	}
+
+	/**
+	 * @brief Calls fn(y, row) for every row of the region, distributing row bands
+	 * across a thread pool. `row` is the same span that region.row(y) returns.
+	 */
+	template<typename PixelT, bool TPReadOnly, typename Fn>
+	void ForEachRow(LockedBitmapRegion<PixelT, TPReadOnly>& region, Fn&& fn, const ParallelOptions& opt = {}) {
+		detail::ParallelRows(region.height(), opt, [&](int y) {
+			fn(y, region.row(y));
+		});
+	}
+
+	/**
+	 * @brief Calls fn(y, dstRow, srcRow) for every row of two equally sized regions.
+	 * @throws OutOfRangeError if the region sizes differ.
+	 */
+	template<typename DstPixelT, typename SrcPixelT, bool TPSrcReadOnly, typename Fn>
+	void ForEachRow(
+		LockedBitmapRegion<DstPixelT, false>& dst,
+		LockedBitmapRegion<SrcPixelT, TPSrcReadOnly>& src,
+		Fn&& fn,
+		const ParallelOptions& opt = {}
+	) {
+		if(dst.size() != src.size()) {
+			throw OutOfRangeError(
+				"Region size mismatch: destination is %dx%d, source is %dx%d",
+				dst.width(), dst.height(), src.width(), src.height()
+			);
+		}
+		detail::ParallelRows(dst.height(), opt, [&](int y) {
+			fn(y, dst.row(y), src.row(y));
+		});
+	}
+
+	/**
+	 * @brief Replaces every pixel p with fn(p), in parallel.
+	 */
+	template<typename PixelT, typename Fn>
+	void TransformPixels(LockedBitmapRegion<PixelT, false>& region, Fn&& fn, const ParallelOptions& opt = {}) {
+		ForEachRow(region, [&](int, std::span<PixelT> row) {
+			for(auto& px: row) {
+				px = fn(std::as_const(px));
+			}
+		}, opt);
+	}
+
+	/**
+	 * @brief Sets every destination pixel to fn(source pixel), in parallel.
+	 * @throws OutOfRangeError if the region sizes differ.
+	 */
+	template<typename DstPixelT, typename SrcPixelT, bool TPSrcReadOnly, typename Fn>
+	void TransformPixels(
+		LockedBitmapRegion<DstPixelT, false>& dst,
+		LockedBitmapRegion<SrcPixelT, TPSrcReadOnly>& src,
+		Fn&& fn,
+		const ParallelOptions& opt = {}
+	) {
+		ForEachRow(dst, src, [&](int, auto dstRow, auto srcRow) {
+			for(size_t x=0; x<dstRow.size(); x++) {
+				dstRow[x] = fn(srcRow[x]);
+			}
+		}, opt);
+	}
+
+}
+
+#endif //AXXEGRO_PARALLELPIXELS_HPP
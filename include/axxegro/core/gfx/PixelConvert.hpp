@@ -0,0 +1,554 @@
+#ifndef AXXEGRO_PIXELCONVERT_HPP
+#define AXXEGRO_PIXELCONVERT_HPP
+
+#include "Bitmap.hpp"
+#include "Color.hpp"
+#include "Pixel.hpp"
+
+#include "axxegro/com/Exception.hpp"
+#include "axxegro/com/util/Simd.hpp"
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <ranges>
+#include <span>
+#include <utility>
+
+/**
+ * @file
+ * Bulk conversions between pixel layouts (the types from Pixel.hpp and al::Color)
+ * and alpha premultiplication. 4-byte layouts and float RGBA use SSE2/AVX2
+ * when available (see com/util/Simd.hpp), everything else has a scalar path.
+ */
+
+namespace al {
+
+	namespace detail::pxconv {
+
+		template<typename T>
+		concept Byte4Pixel = std::is_trivially_copyable_v<T> && sizeof(T) == 4 && requires(T p) {
+			{p.r} -> std::same_as<uint8_t&>;
+			{p.g} -> std::same_as<uint8_t&>;
+			{p.b} -> std::same_as<uint8_t&>;
+			{p.a} -> std::same_as<uint8_t&>;
+		};
+
+		template<typename T>
+		concept Byte3Pixel = std::is_trivially_copyable_v<T> && sizeof(T) == 3 && requires(T p) {
+			{p.r} -> std::same_as<uint8_t&>;
+			{p.g} -> std::same_as<uint8_t&>;
+			{p.b} -> std::same_as<uint8_t&>;
+		};
+
+		template<typename T>
+		concept Float4Pixel = std::is_trivially_copyable_v<T> && sizeof(T) == 16 && requires(T p) {
+			{p.r} -> std::same_as<float&>;
+			{p.g} -> std::same_as<float&>;
+			{p.b} -> std::same_as<float&>;
+			{p.a} -> std::same_as<float&>;
+		};
+
+		template<typename T>
+		concept BytePixel = Byte4Pixel<T> || Byte3Pixel<T>;
+
+		constexpr bool IsLittleEndian = std::endian::native == std::endian::little;
+
+		/*
+		 * Position of the r, g, b and a channels within the pixel, in elements
+		 * (bytes or floats). -1 if the channel is absent.
+		 */
+		template<typename T>
+		consteval std::array<int, 4> ChannelOffsets() {
+			using ElemT = std::conditional_t<Float4Pixel<T>, float, uint8_t>;
+			constexpr int NumElements = sizeof(T) / sizeof(ElemT);
+			T p{};
+			p.r = 1;
+			p.g = 2;
+			p.b = 3;
+			if constexpr(NumElements == 4) {
+				p.a = 4;
+			}
+			auto elems = std::bit_cast<std::array<ElemT, NumElements>>(p);
+			std::array<int, 4> ret {-1, -1, -1, -1};
+			for(int i=0; i<NumElements; i++) {
+				if(elems[i] != 0) {
+					ret[int(elems[i]) - 1] = i;
+				}
+			}
+			return ret;
+		}
+
+		/*
+		 * Moving byte lanes around within a little-endian uint32 is at most seven
+		 * shift+mask pairs, one per distinct displacement. masks[delta+3] selects the
+		 * destination bytes that come from `delta` bytes below them.
+		 */
+		using PermuteMasks = std::array<uint32_t, 7>;
+
+		consteval PermuteMasks CalcPermuteMasks(std::array<int, 4> src, std::array<int, 4> dst) {
+			PermuteMasks masks {};
+			for(int c=0; c<4; c++) {
+				masks[dst[c] - src[c] + 3] |= 0xFFu << (8 * dst[c]);
+			}
+			return masks;
+		}
+
+		template<int Delta, uint32_t Mask>
+		inline uint32_t PermuteStep(uint32_t acc, uint32_t x) {
+			if constexpr(Mask == 0) {
+				return acc;
+			} else if constexpr(Delta >= 0) {
+				return acc | ((x << (8 * Delta)) & Mask);
+			} else {
+				return acc | ((x >> (-8 * Delta)) & Mask);
+			}
+		}
+
+#ifdef AXXEGRO_SIMD_SSE2
+		template<int Delta, uint32_t Mask>
+		inline __m128i PermuteStep(__m128i acc, __m128i x) {
+			if constexpr(Mask == 0) {
+				return acc;
+			} else {
+				__m128i shifted = x;
+				if constexpr(Delta > 0) {
+					shifted = _mm_slli_epi32(x, 8 * Delta);
+				} else if constexpr(Delta < 0) {
+					shifted = _mm_srli_epi32(x, -8 * Delta);
+				}
+				return _mm_or_si128(acc, _mm_and_si128(shifted, _mm_set1_epi32((int)Mask)));
+			}
+		}
+#endif
+
+#ifdef AXXEGRO_SIMD_AVX2
+		template<int Delta, uint32_t Mask>
+		inline __m256i PermuteStep(__m256i acc, __m256i x) {
+			if constexpr(Mask == 0) {
+				return acc;
+			} else {
+				__m256i shifted = x;
+				if constexpr(Delta > 0) {
+					shifted = _mm256_slli_epi32(x, 8 * Delta);
+				} else if constexpr(Delta < 0) {
+					shifted = _mm256_srli_epi32(x, -8 * Delta);
+				}
+				return _mm256_or_si256(acc, _mm256_and_si256(shifted, _mm256_set1_epi32((int)Mask)));
+			}
+		}
+#endif
+
+		/* Works on uint32_t, __m128i and __m256i (each 32-bit lane is one pixel) */
+		template<PermuteMasks Masks, typename VecT>
+		inline VecT PermuteBytes(VecT x) {
+			VecT acc {};
+			[&]<int... Idx>(std::integer_sequence<int, Idx...>) {
+				((acc = PermuteStep<Idx - 3, Masks[Idx]>(acc, x)), ...);
+			}(std::make_integer_sequence<int, 7>{});
+			return acc;
+		}
+
+		inline uint8_t FloatToByte(float v) {
+			v *= 255.0f;
+			if(!(v > 0.0f)) {
+				return 0;
+			}
+			if(v >= 255.0f) {
+				return 255;
+			}
+			return uint8_t(v + 0.5f);
+		}
+
+		template<typename DstT, typename SrcT>
+		void ConvertBytesScalar(const SrcT* src, DstT* dst, size_t n) {
+			constexpr auto SrcOff = ChannelOffsets<SrcT>();
+			constexpr auto DstOff = ChannelOffsets<DstT>();
+			auto* s = reinterpret_cast<const uint8_t*>(src);
+			auto* d = reinterpret_cast<uint8_t*>(dst);
+			for(size_t i=0; i<n; i++) {
+				for(int c=0; c<4; c++) {
+					if(DstOff[c] >= 0) {
+						d[DstOff[c]] = SrcOff[c] >= 0 ? s[SrcOff[c]] : 0xFF;
+					}
+				}
+				s += sizeof(SrcT);
+				d += sizeof(DstT);
+			}
+		}
+
+		template<Byte4Pixel DstT, Byte4Pixel SrcT>
+		void ConvertByte4(const SrcT* src, DstT* dst, size_t n) {
+			constexpr auto SrcOff = ChannelOffsets<SrcT>();
+			constexpr auto DstOff = ChannelOffsets<DstT>();
+			if constexpr(SrcOff == DstOff) {
+				std::memcpy(dst, src, n * sizeof(SrcT));
+			} else if constexpr(!IsLittleEndian) {
+				ConvertBytesScalar(src, dst, n);
+			} else {
+				constexpr auto Masks = CalcPermuteMasks(SrcOff, DstOff);
+				size_t i = 0;
+#ifdef AXXEGRO_SIMD_AVX2
+				for(; i+8 <= n; i += 8) {
+					__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), PermuteBytes<Masks>(v));
+				}
+#endif
+#ifdef AXXEGRO_SIMD_SSE2
+				for(; i+4 <= n; i += 4) {
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), PermuteBytes<Masks>(v));
+				}
+#endif
+				for(; i < n; i++) {
+					uint32_t v;
+					std::memcpy(&v, src + i, 4);
+					v = PermuteBytes<Masks>(v);
+					std::memcpy(dst + i, &v, 4);
+				}
+			}
+		}
+
+		template<Float4Pixel DstT, BytePixel SrcT>
+		void ConvertBytesToFloats(const SrcT* src, DstT* dst, size_t n) {
+			constexpr auto SrcOff = ChannelOffsets<SrcT>();
+			constexpr auto DstOff = ChannelOffsets<DstT>();
+			constexpr float Scale = 1.0f / 255.0f;
+			auto* d = reinterpret_cast<float*>(dst);
+			size_t i = 0;
+
+			if constexpr(Byte4Pixel<SrcT> && IsLittleEndian) {
+				/* shuffle the bytes into the float layout first, then widen in place */
+				constexpr auto Masks = CalcPermuteMasks(SrcOff, DstOff);
+#if defined(AXXEGRO_SIMD_AVX2)
+				const __m256 scale = _mm256_set1_ps(Scale);
+				for(; i+4 <= n; i += 4) {
+					__m128i v = PermuteBytes<Masks>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+					__m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+					__m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+					_mm256_storeu_ps(d + 4*i + 0, _mm256_mul_ps(lo, scale));
+					_mm256_storeu_ps(d + 4*i + 8, _mm256_mul_ps(hi, scale));
+				}
+#elif defined(AXXEGRO_SIMD_SSE2)
+				const __m128 scale = _mm_set1_ps(Scale);
+				const __m128i zero = _mm_setzero_si128();
+				for(; i+4 <= n; i += 4) {
+					__m128i v = PermuteBytes<Masks>(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+					__m128i lo16 = _mm_unpacklo_epi8(v, zero);
+					__m128i hi16 = _mm_unpackhi_epi8(v, zero);
+					_mm_storeu_ps(d + 4*i + 0, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo16, zero)), scale));
+					_mm_storeu_ps(d + 4*i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo16, zero)), scale));
+					_mm_storeu_ps(d + 4*i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi16, zero)), scale));
+					_mm_storeu_ps(d + 4*i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi16, zero)), scale));
+				}
+#else
+				(void) Masks;
+#endif
+			}
+
+			auto* s = reinterpret_cast<const uint8_t*>(src + i);
+			for(; i < n; i++) {
+				for(int c=0; c<4; c++) {
+					d[4*i + DstOff[c]] = SrcOff[c] >= 0 ? float(s[SrcOff[c]]) * Scale : 1.0f;
+				}
+				s += sizeof(SrcT);
+			}
+		}
+
+		template<BytePixel DstT, Float4Pixel SrcT>
+		void ConvertFloatsToBytes(const SrcT* src, DstT* dst, size_t n) {
+			constexpr auto SrcOff = ChannelOffsets<SrcT>();
+			constexpr auto DstOff = ChannelOffsets<DstT>();
+			auto* s = reinterpret_cast<const float*>(src);
+			size_t i = 0;
+
+#ifdef AXXEGRO_SIMD_SSE2
+			if constexpr(Byte4Pixel<DstT> && IsLittleEndian) {
+				/* same operations as FloatToByte(), so that the result doesn't depend on
+				 * the CPU or the position in the row: _mm_max_ps returns its second
+				 * operand for NaNs, and truncating v+0.5 rounds half up */
+				constexpr auto Masks = CalcPermuteMasks(SrcOff, DstOff);
+				const __m128 scale = _mm_set1_ps(255.0f);
+				const __m128 zero = _mm_setzero_ps();
+				const __m128 half = _mm_set1_ps(0.5f);
+				auto toInt = [&](const float* p) {
+					__m128 v = _mm_mul_ps(_mm_loadu_ps(p), scale);
+					v = _mm_min_ps(_mm_max_ps(v, zero), scale);
+					return _mm_cvttps_epi32(_mm_add_ps(v, half));
+				};
+				for(; i+4 <= n; i += 4) {
+					__m128i p0 = toInt(s + 4*i + 0);
+					__m128i p1 = toInt(s + 4*i + 4);
+					__m128i p2 = toInt(s + 4*i + 8);
+					__m128i p3 = toInt(s + 4*i + 12);
+					__m128i packed = _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), PermuteBytes<Masks>(packed));
+				}
+			}
+#endif
+
+			auto* d = reinterpret_cast<uint8_t*>(dst + i);
+			for(; i < n; i++) {
+				for(int c=0; c<4; c++) {
+					if(DstOff[c] >= 0) {
+						d[DstOff[c]] = FloatToByte(s[4*i + SrcOff[c]]);
+					}
+				}
+				d += sizeof(DstT);
+			}
+		}
+
+		template<Float4Pixel DstT, Float4Pixel SrcT>
+		void ConvertFloats(const SrcT* src, DstT* dst, size_t n) {
+			for(size_t i=0; i<n; i++) {
+				dst[i].r = src[i].r;
+				dst[i].g = src[i].g;
+				dst[i].b = src[i].b;
+				dst[i].a = src[i].a;
+			}
+		}
+
+		template<typename DstT, typename SrcT>
+		void ConvertPixelsImpl(const SrcT* src, DstT* dst, size_t n) {
+			if constexpr(Float4Pixel<SrcT> && Float4Pixel<DstT>) {
+				ConvertFloats(src, dst, n);
+			} else if constexpr(Float4Pixel<SrcT>) {
+				ConvertFloatsToBytes(src, dst, n);
+			} else if constexpr(Float4Pixel<DstT>) {
+				ConvertBytesToFloats(src, dst, n);
+			} else if constexpr(Byte4Pixel<SrcT> && Byte4Pixel<DstT>) {
+				ConvertByte4(src, dst, n);
+			} else {
+				ConvertBytesScalar(src, dst, n);
+			}
+		}
+
+		template<Byte4Pixel T>
+		void PremultiplyBytes(T* px, size_t n) {
+			size_t i = 0;
+#ifdef AXXEGRO_SIMD_SSE2
+			if constexpr(IsLittleEndian) {
+				constexpr int A = ChannelOffsets<T>()[3];
+				auto lane = [](int i) -> short {return (i % 4) == A ? -1 : 0;};
+				const __m128i alphaLanes = _mm_setr_epi16(lane(0), lane(1), lane(2), lane(3), lane(4), lane(5), lane(6), lane(7));
+				const __m128i alphaFactor = _mm_and_si128(alphaLanes, _mm_set1_epi16(255));
+				const __m128i bias = _mm_set1_epi16(128);
+				const __m128i zero = _mm_setzero_si128();
+
+				/* x*a/255 rounded, with the alpha lane itself multiplied by 255 (i.e. kept) */
+				auto mul = [&](__m128i v16) {
+					__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v16, _MM_SHUFFLE(A, A, A, A)), _MM_SHUFFLE(A, A, A, A));
+					a = _mm_or_si128(_mm_andnot_si128(alphaLanes, a), alphaFactor);
+					__m128i t = _mm_add_epi16(_mm_mullo_epi16(v16, a), bias);
+					return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+				};
+
+				for(; i+4 <= n; i += 4) {
+					__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(px + i));
+					__m128i lo = mul(_mm_unpacklo_epi8(v, zero));
+					__m128i hi = mul(_mm_unpackhi_epi8(v, zero));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(px + i), _mm_packus_epi16(lo, hi));
+				}
+			}
+#endif
+			auto mul = [](unsigned x, unsigned a) -> uint8_t {
+				unsigned t = x * a + 128;
+				return (t + (t >> 8)) >> 8;
+			};
+			for(; i < n; i++) {
+				T& p = px[i];
+				p.r = mul(p.r, p.a);
+				p.g = mul(p.g, p.a);
+				p.b = mul(p.b, p.a);
+			}
+		}
+
+		template<Byte4Pixel T>
+		void UnpremultiplyBytes(T* px, size_t n) {
+			static constexpr auto Reciprocals = []() {
+				std::array<float, 256> ret {};
+				for(int a=1; a<256; a++) {
+					ret[a] = 255.0f / float(a);
+				}
+				return ret;
+			}();
+			auto div = [](unsigned x, float recip) -> uint8_t {
+				float v = float(x) * recip + 0.5f;
+				return v >= 255.0f ? 255 : uint8_t(v);
+			};
+			for(size_t i=0; i<n; i++) {
+				T& p = px[i];
+				if(p.a == 255) {
+					continue;
+				}
+				float recip = Reciprocals[p.a];
+				p.r = div(p.r, recip);
+				p.g = div(p.g, recip);
+				p.b = div(p.b, recip);
+			}
+		}
+
+		template<Float4Pixel T>
+		void PremultiplyFloats(T* px, size_t n) {
+			for(size_t i=0; i<n; i++) {
+				px[i].r *= px[i].a;
+				px[i].g *= px[i].a;
+				px[i].b *= px[i].a;
+			}
+		}
+
+		template<Float4Pixel T>
+		void UnpremultiplyFloats(T* px, size_t n) {
+			for(size_t i=0; i<n; i++) {
+				float recip = px[i].a > 0.0f ? 1.0f / px[i].a : 0.0f;
+				px[i].r *= recip;
+				px[i].g *= recip;
+				px[i].b *= recip;
+			}
+		}
+
+		/* Calls fn(rowSrc, rowDst, count) once if both regions are contiguous, once per row otherwise */
+		template<typename SrcRegionT, typename DstRegionT, typename Fn>
+		void ForEachRowPair(SrcRegionT& src, DstRegionT& dst, Fn&& fn) {
+			using SrcT = typename std::remove_cvref_t<decltype(src.row(0))>::element_type;
+			using DstT = typename std::remove_cvref_t<decltype(dst.row(0))>::element_type;
+			int w = src.width(), h = src.height();
+			if(h <= 0 || w <= 0) {
+				return;
+			}
+			if(src.getPitch() == w * (int)sizeof(SrcT) && dst.getPitch() == w * (int)sizeof(DstT)) {
+				fn(src.row(0).data(), dst.row(0).data(), size_t(w) * h);
+				return;
+			}
+			for(int y=0; y<h; y++) {
+				fn(src.row(y).data(), dst.row(y).data(), size_t(w));
+			}
+		}
+	}
+
+	/**
+	 * @brief Pixel types that ConvertPixels() and the premultiplication functions accept:
+	 * 8-bit RGB(A) layouts (PixelARGB8888, detail::px::BGR888 etc.) and float RGBA
+	 * (al::Color, PixelABGR_F32).
+	 */
+	template<typename T>
+	concept ConvertiblePixelType =
+		   detail::pxconv::BytePixel<T>
+		|| detail::pxconv::Float4Pixel<T>;
+
+	/**
+	 * @brief Converts src.size() pixels from `src` into `dst`.
+	 *
+	 * Missing alpha is filled in as opaque; channels are rounded to the nearest
+	 * value and clamped when converting floats to bytes.
+	 *
+	 * @throws OutOfRangeError if `dst` is smaller than `src`.
+	 */
+	template<std::ranges::contiguous_range SrcRangeT, std::ranges::contiguous_range DstRangeT>
+		requires ConvertiblePixelType<std::ranges::range_value_t<SrcRangeT>>
+			  && ConvertiblePixelType<std::ranges::range_value_t<DstRangeT>>
+	void ConvertPixels(SrcRangeT&& src, DstRangeT&& dst) {
+		size_t n = std::ranges::size(src);
+		if(std::ranges::size(dst) < n) {
+			throw OutOfRangeError(
+				"Cannot convert %zu pixels into a buffer of %zu pixels",
+				n, size_t(std::ranges::size(dst))
+			);
+		}
+		detail::pxconv::ConvertPixelsImpl(std::ranges::data(src), std::ranges::data(dst), n);
+	}
+
+	/**
+	 * @brief Converts a whole locked region into another locked region of the same size.
+	 * @throws OutOfRangeError if the region sizes differ.
+	 */
+	template<ConvertiblePixelType SrcT, bool TPSrcReadOnly, ConvertiblePixelType DstT>
+	void ConvertPixels(LockedBitmapRegion<SrcT, TPSrcReadOnly>& src, LockedBitmapRegion<DstT, false>& dst) {
+		if(src.size() != dst.size()) {
+			throw OutOfRangeError(
+				"Cannot convert a %dx%d region into a %dx%d region",
+				src.width(), src.height(), dst.width(), dst.height()
+			);
+		}
+		detail::pxconv::ForEachRowPair(src, dst, [](const SrcT* s, DstT* d, size_t n) {
+			detail::pxconv::ConvertPixelsImpl(s, d, n);
+		});
+	}
+
+	/**
+	 * @brief Converts a locked region into a row-major buffer (e.g. a std::vector<al::Color>).
+	 * @throws OutOfRangeError if `dst` holds fewer than width*height pixels.
+	 */
+	template<ConvertiblePixelType SrcT, bool TPSrcReadOnly, std::ranges::contiguous_range DstRangeT>
+		requires ConvertiblePixelType<std::ranges::range_value_t<DstRangeT>>
+	void ConvertPixels(LockedBitmapRegion<SrcT, TPSrcReadOnly>& src, DstRangeT&& dst) {
+		size_t w = std::max(src.width(), 0);
+		size_t h = std::max(src.height(), 0);
+		if(std::ranges::size(dst) < w * h) {
+			throw OutOfRangeError("Cannot convert a %dx%d region into a buffer of %zu pixels", src.width(), src.height(), size_t(std::ranges::size(dst)));
+		}
+		auto* d = std::ranges::data(dst);
+		for(size_t y=0; y<h; y++) {
+			detail::pxconv::ConvertPixelsImpl(src.row(y).data(), d + y*w, w);
+		}
+	}
+
+	/**
+	 * @brief Converts a row-major buffer into a locked region.
+	 * @throws OutOfRangeError if `src` holds fewer than width*height pixels.
+	 */
+	template<std::ranges::contiguous_range SrcRangeT, ConvertiblePixelType DstT>
+		requires ConvertiblePixelType<std::ranges::range_value_t<SrcRangeT>>
+	void ConvertPixels(SrcRangeT&& src, LockedBitmapRegion<DstT, false>& dst) {
+		size_t w = std::max(dst.width(), 0);
+		size_t h = std::max(dst.height(), 0);
+		if(std::ranges::size(src) < w * h) {
+			throw OutOfRangeError("Cannot convert a buffer of %zu pixels into a %dx%d region", size_t(std::ranges::size(src)), dst.width(), dst.height());
+		}
+		auto* s = std::ranges::data(src);
+		for(size_t y=0; y<h; y++) {
+			detail::pxconv::ConvertPixelsImpl(s + y*w, dst.row(y).data(), w);
+		}
+	}
+
+	/// @brief Multiplies the color channels by alpha, in place.
+	template<std::ranges::contiguous_range RangeT>
+		requires ConvertiblePixelType<std::ranges::range_value_t<RangeT>>
+	void PremultiplyAlpha(RangeT&& pixels) {
+		using T = std::ranges::range_value_t<RangeT>;
+		if constexpr(detail::pxconv::Byte4Pixel<T>) {
+			detail::pxconv::PremultiplyBytes(std::ranges::data(pixels), std::ranges::size(pixels));
+		} else if constexpr(detail::pxconv::Float4Pixel<T>) {
+			detail::pxconv::PremultiplyFloats(std::ranges::data(pixels), std::ranges::size(pixels));
+		}
+	}
+
+	/// @brief Divides the color channels by alpha, in place. Fully transparent pixels become (0,0,0,0).
+	template<std::ranges::contiguous_range RangeT>
+		requires ConvertiblePixelType<std::ranges::range_value_t<RangeT>>
+	void UnpremultiplyAlpha(RangeT&& pixels) {
+		using T = std::ranges::range_value_t<RangeT>;
+		if constexpr(detail::pxconv::Byte4Pixel<T>) {
+			detail::pxconv::UnpremultiplyBytes(std::ranges::data(pixels), std::ranges::size(pixels));
+		} else if constexpr(detail::pxconv::Float4Pixel<T>) {
+			detail::pxconv::UnpremultiplyFloats(std::ranges::data(pixels), std::ranges::size(pixels));
+		}
+	}
+
+	template<ConvertiblePixelType T>
+	void PremultiplyAlpha(LockedBitmapRegion<T, false>& region) {
+		for(int y=0; y<region.height(); y++) {
+			PremultiplyAlpha(region.row(y));
+		}
+	}
+
+	template<ConvertiblePixelType T>
+	void UnpremultiplyAlpha(LockedBitmapRegion<T, false>& region) {
+		for(int y=0; y<region.height(); y++) {
+			UnpremultiplyAlpha(region.row(y));
+		}
+	}
+
+}
+
+#endif //AXXEGRO_PIXELCONVERT_HPP
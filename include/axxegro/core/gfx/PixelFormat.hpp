@@ -3,6 +3,9 @@
 
 #include "../../common.hpp"
 
+#include <algorithm>
+#include <cstddef>
+
 namespace al
 {
 	class PixelFormat
@@ -31,6 +34,14 @@ namespace al
 		Vec2i blockDimensions() {
 			return {blockWidth(), blockHeight()};
 		}
+
+		///@return Size in bytes of the pixel data of a bitmap with the given dimensions, counting whole blocks.
+		[[nodiscard]] size_t dataSize(Vec2i dimensions) const {
+			int bw = std::max(al_get_pixel_block_width(fmt), 1);
+			int bh = std::max(al_get_pixel_block_height(fmt), 1);
+			size_t numBlocks = size_t((dimensions.x + bw - 1) / bw) * size_t((dimensions.y + bh - 1) / bh);
+			return numBlocks * size_t(al_get_pixel_block_size(fmt));
+		}
 	private:
 		ALLEGRO_PIXEL_FORMAT fmt;
 	};
@@ -0,0 +1,307 @@
+#ifndef AXXEGRO_RENDERSTATECACHE_HPP
+#define AXXEGRO_RENDERSTATECACHE_HPP
+
+#include <allegro5/allegro.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+
+namespace al {
+
+	struct RenderStateCacheStats {
+		/// State changes requested through axxegro.
+		uint64_t numRequests = 0;
+
+		/// Requests that matched the known state and were not passed to Allegro.
+		uint64_t numElided = 0;
+	};
+
+	/**
+	 * @brief Remembers the render state of the calling thread and skips state
+	 * changes that would not change anything.
+	 *
+	 * Covers the target bitmap, blender, blend color, transform, projection
+	 * transform, clipping rectangle and render states (al_set_render_state), as
+	 * set through axxegro: ScopedTargetBitmap, ScopedBlender, ScopedTransform,
+	 * Transform::use(), the al::TargetBitmap setters and so on.
+	 *
+	 * The cache is disabled by default, in which case every call goes straight to
+	 * Allegro. Each thread has its own cache since Allegro's render state is per
+	 * thread. If you change any of this state with raw Allegro calls while the cache
+	 * is enabled, call invalidate() afterwards.
+	 *
+	 * State is learned from Allegro lazily: an unknown value is read back the
+	 * first time it is queried, and set unconditionally the first time it is set.
+	 * Transforms, the projection and the clipping rectangle belong to the target
+	 * bitmap and are forgotten whenever the target actually changes.
+	 */
+	class RenderStateCache {
+	public:
+		/// @return The calling thread's cache.
+		static RenderStateCache& ThisThread() {
+			static thread_local RenderStateCache instance;
+			return instance;
+		}
+
+		void enable() {
+			if(!enabled) {
+				invalidate();
+				enabled = true;
+			}
+		}
+
+		void disable() {
+			enabled = false;
+		}
+
+		[[nodiscard]] bool isEnabled() const {
+			return enabled;
+		}
+
+		/// @brief Forgets all known state, e.g. after using raw Allegro state calls.
+		void invalidate() {
+			target.reset();
+			blender.reset();
+			blendColor.reset();
+			invalidateBitmapState();
+			for(auto& rs: renderStates) {
+				rs.value.reset();
+			}
+		}
+
+		/// @brief Forgets the transforms and clipping rectangle, which belong to the target bitmap.
+		void invalidateBitmapState() {
+			transform.reset();
+			projection.reset();
+			clip.reset();
+		}
+
+		/// @brief Must be called before destroying a bitmap, since another one may later get the same address.
+		void forgetBitmap(ALLEGRO_BITMAP* bmp) {
+			if(target && *target == bmp) {
+				invalidate();
+			}
+		}
+
+		/// @brief Starts counting a new frame. Called by al::CurrentDisplay.flip().
+		void endFrame() {
+			lastFrame = currentFrame;
+			currentFrame = {};
+		}
+
+		/// @return Statistics of the last completed frame.
+		[[nodiscard]] RenderStateCacheStats getLastFrameStats() const {
+			return lastFrame;
+		}
+
+		/// @return Statistics of the frame in progress.
+		[[nodiscard]] RenderStateCacheStats getCurrentFrameStats() const {
+			return currentFrame;
+		}
+
+		[[nodiscard]] ALLEGRO_BITMAP* getTargetBitmap() {
+			if(!enabled) {
+				return al_get_target_bitmap();
+			}
+			if(!target) {
+				target = al_get_target_bitmap();
+			}
+			return *target;
+		}
+
+		void setTargetBitmap(ALLEGRO_BITMAP* bmp) {
+			if(elide(target, bmp)) {
+				return;
+			}
+			al_set_target_bitmap(bmp);
+			if(enabled) {
+				invalidateBitmapState();
+			}
+		}
+
+		void getSeparateBlender(int* op, int* src, int* dst, int* alphaOp, int* alphaSrc, int* alphaDst) {
+			if(!enabled || !blender) {
+				BlenderState b {};
+				al_get_separate_blender(&b[0], &b[1], &b[2], &b[3], &b[4], &b[5]);
+				if(enabled) {
+					blender = b;
+				}
+				*op = b[0]; *src = b[1]; *dst = b[2];
+				*alphaOp = b[3]; *alphaSrc = b[4]; *alphaDst = b[5];
+				return;
+			}
+			const auto& b = *blender;
+			*op = b[0]; *src = b[1]; *dst = b[2];
+			*alphaOp = b[3]; *alphaSrc = b[4]; *alphaDst = b[5];
+		}
+
+		void setSeparateBlender(int op, int src, int dst, int alphaOp, int alphaSrc, int alphaDst) {
+			BlenderState b {op, src, dst, alphaOp, alphaSrc, alphaDst};
+			if(elide(blender, b)) {
+				return;
+			}
+			al_set_separate_blender(op, src, dst, alphaOp, alphaSrc, alphaDst);
+		}
+
+		[[nodiscard]] ALLEGRO_COLOR getBlendColor() {
+			if(!enabled) {
+				return al_get_blend_color();
+			}
+			if(!blendColor) {
+				blendColor = al_get_blend_color();
+			}
+			return *blendColor;
+		}
+
+		void setBlendColor(ALLEGRO_COLOR color) {
+			if(elide(blendColor, color)) {
+				return;
+			}
+			al_set_blend_color(color);
+		}
+
+		/// @return The current transform; valid until the next transform change.
+		[[nodiscard]] const ALLEGRO_TRANSFORM* getCurrentTransform() {
+			if(!enabled) {
+				return al_get_current_transform();
+			}
+			if(!transform) {
+				transform = *al_get_current_transform();
+			}
+			return &*transform;
+		}
+
+		void useTransform(const ALLEGRO_TRANSFORM* t) {
+			if(elide(transform, *t)) {
+				return;
+			}
+			al_use_transform(t);
+		}
+
+		/// @return The current projection transform; valid until the next projection change.
+		[[nodiscard]] const ALLEGRO_TRANSFORM* getCurrentProjectionTransform() {
+			if(!enabled) {
+				return al_get_current_projection_transform();
+			}
+			if(!projection) {
+				projection = *al_get_current_projection_transform();
+			}
+			return &*projection;
+		}
+
+		void useProjectionTransform(const ALLEGRO_TRANSFORM* t) {
+			if(elide(projection, *t)) {
+				return;
+			}
+			al_use_projection_transform(t);
+		}
+
+		void getClippingRectangle(int* x, int* y, int* w, int* h) {
+			if(!enabled || !clip) {
+				ClipState c {};
+				al_get_clipping_rectangle(&c[0], &c[1], &c[2], &c[3]);
+				if(enabled) {
+					clip = c;
+				}
+				*x = c[0]; *y = c[1]; *w = c[2]; *h = c[3];
+				return;
+			}
+			const auto& c = *clip;
+			*x = c[0]; *y = c[1]; *w = c[2]; *h = c[3];
+		}
+
+		void setClippingRectangle(int x, int y, int w, int h) {
+			if(elide(clip, ClipState{x, y, w, h})) {
+				return;
+			}
+			al_set_clipping_rectangle(x, y, w, h);
+		}
+
+		void resetClippingRectangle() {
+			/* the result depends on the target's size, so just forget it */
+			if(enabled) {
+				currentFrame.numRequests++;
+				clip.reset();
+			}
+			al_reset_clipping_rectangle();
+		}
+
+		void setRenderState(ALLEGRO_RENDER_STATE state, int value) {
+			std::optional<int>* slot = findRenderState(state);
+			if(slot && elide(*slot, value)) {
+				return;
+			}
+			if(!slot && enabled) {
+				currentFrame.numRequests++;
+			}
+			al_set_render_state(state, value);
+		}
+
+	private:
+		using BlenderState = std::array<int, 6>;
+		using ClipState = std::array<int, 4>;
+
+		struct RenderStateSlot {
+			ALLEGRO_RENDER_STATE state;
+			std::optional<int> value;
+		};
+
+		template<typename T>
+		static bool Equal(const T& a, const T& b) {
+			if constexpr(std::is_same_v<T, ALLEGRO_TRANSFORM> || std::is_same_v<T, ALLEGRO_COLOR>) {
+				return std::memcmp(&a, &b, sizeof(T)) == 0;
+			} else {
+				return a == b;
+			}
+		}
+
+		/* true if the call can be skipped; otherwise records the new value */
+		template<typename T>
+		bool elide(std::optional<T>& known, const T& value) {
+			if(!enabled) {
+				return false;
+			}
+			currentFrame.numRequests++;
+			if(known && Equal(*known, value)) {
+				currentFrame.numElided++;
+				return true;
+			}
+			known = value;
+			return false;
+		}
+
+		std::optional<int>* findRenderState(ALLEGRO_RENDER_STATE state) {
+			for(auto& rs: renderStates) {
+				if(rs.state == state) {
+					return &rs.value;
+				}
+			}
+			return nullptr;
+		}
+
+		bool enabled = false;
+
+		std::optional<ALLEGRO_BITMAP*> target;
+		std::optional<BlenderState> blender;
+		std::optional<ALLEGRO_COLOR> blendColor;
+		std::optional<ALLEGRO_TRANSFORM> transform;
+		std::optional<ALLEGRO_TRANSFORM> projection;
+		std::optional<ClipState> clip;
+		std::array<RenderStateSlot, 6> renderStates {{
+			{ALLEGRO_ALPHA_TEST, {}},
+			{ALLEGRO_WRITE_MASK, {}},
+			{ALLEGRO_DEPTH_TEST, {}},
+			{ALLEGRO_DEPTH_FUNCTION, {}},
+			{ALLEGRO_ALPHA_FUNCTION, {}},
+			{ALLEGRO_ALPHA_TEST_VALUE, {}}
+		}};
+
+		RenderStateCacheStats currentFrame;
+		RenderStateCacheStats lastFrame;
+	};
+
+}
+
+#endif //AXXEGRO_RENDERSTATECACHE_HPP
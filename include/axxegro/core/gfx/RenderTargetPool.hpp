@@ -0,0 +1,307 @@
+#ifndef AXXEGRO_RENDERTARGETPOOL_HPP
+#define AXXEGRO_RENDERTARGETPOOL_HPP
+
+#include "Bitmap.hpp"
+#include "PixelFormat.hpp"
+#include "../../com/util/Dict.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * Reusable offscreen bitmaps for render passes
+ */
+
+namespace al {
+
+	/// @brief What a pooled bitmap has to match to be reused.
+	struct RenderTargetKey {
+		Vec2i size;
+		int format;
+		int flags;
+
+		bool operator==(const RenderTargetKey&) const = default;
+	};
+
+	struct RenderTargetPoolStats {
+		size_t numTargets = 0;
+		size_t numInUse = 0;
+
+		/// Estimated size of the pixel data of all pooled bitmaps, in use or not.
+		size_t currentBytes = 0;
+		size_t inUseBytes = 0;
+		size_t peakBytes = 0;
+
+		uint64_t numCreated = 0;
+		uint64_t numReused = 0;
+		uint64_t numTrimmed = 0;
+	};
+
+	class RenderTargetPool;
+
+	namespace detail {
+		struct RenderTargetKeyHash {
+			size_t operator()(const RenderTargetKey& key) const {
+				size_t ret = 0;
+				HashCombine(ret, key.size.x);
+				HashCombine(ret, key.size.y);
+				HashCombine(ret, key.format);
+				HashCombine(ret, key.flags);
+				return ret;
+			}
+		};
+
+		struct PooledRenderTargetEntry {
+			std::unique_ptr<Bitmap> bitmap;
+			size_t bytes = 0;
+			uint64_t lastUsedFrame = 0;
+			bool inUse = false;
+		};
+	}
+
+	/**
+	 * @brief A bitmap borrowed from a RenderTargetPool. Gives it back to the
+	 * pool when destroyed (or on release()).
+	 *
+	 * The pool has to outlive the handle.
+	 */
+	class PooledRenderTarget {
+	public:
+		PooledRenderTarget() = default;
+
+		PooledRenderTarget(PooledRenderTarget&& other) noexcept
+			: pool(other.pool), entry(other.entry)
+		{
+			other.pool = nullptr;
+			other.entry = nullptr;
+		}
+
+		PooledRenderTarget& operator=(PooledRenderTarget&& other) noexcept {
+			if(this != &other) {
+				release();
+				pool = other.pool;
+				entry = other.entry;
+				other.pool = nullptr;
+				other.entry = nullptr;
+			}
+			return *this;
+		}
+
+		PooledRenderTarget(const PooledRenderTarget&) = delete;
+		PooledRenderTarget& operator=(const PooledRenderTarget&) = delete;
+
+		~PooledRenderTarget() {
+			release();
+		}
+
+		/// @brief Returns the bitmap to the pool early. The handle becomes empty.
+		inline void release();
+
+		[[nodiscard]] Bitmap& bitmap() const {
+			return *entry->bitmap;
+		}
+
+		Bitmap& operator*() const {
+			return bitmap();
+		}
+
+		Bitmap* operator->() const {
+			return entry->bitmap.get();
+		}
+
+		explicit operator bool() const {
+			return entry != nullptr;
+		}
+
+	private:
+		friend class RenderTargetPool;
+
+		PooledRenderTarget(RenderTargetPool* pool, detail::PooledRenderTargetEntry* entry)
+			: pool(pool), entry(entry)
+		{}
+
+		RenderTargetPool* pool = nullptr;
+		detail::PooledRenderTargetEntry* entry = nullptr;
+	};
+
+	/**
+	 * @brief A pooled bitmap that is the target bitmap for as long as this
+	 * object lives. The previous target is restored before the bitmap goes
+	 * back to the pool.
+	 */
+	class ScopedRenderTarget: public PooledRenderTarget {
+	public:
+		explicit ScopedRenderTarget(PooledRenderTarget&& target)
+			: PooledRenderTarget(std::move(target)), scopedTarget(bitmap())
+		{}
+
+	private:
+		using PooledRenderTarget::release;
+
+		ScopedTargetBitmap scopedTarget;
+	};
+
+	/**
+	 * @brief Hands out temporary bitmaps for offscreen passes (post-processing,
+	 * cached UI layers) and keeps them for reuse instead of destroying them,
+	 * because creating a bitmap - a video bitmap in particular - is expensive.
+	 *
+	 * A bitmap is reused only for a request with the same size, pixel format
+	 * and bitmap flags. Its contents are whatever the previous user left there,
+	 * so clear it if that matters.
+	 * @code
+	 * {
+	 *     auto target = pool.bind(disp.size());
+	 *     al::TargetBitmap.clearToColor(al::RGBA(0, 0, 0, 0));
+	 *     drawScene();
+	 * } // the previous target is restored and the bitmap goes back to the pool
+	 * @endcode
+	 *
+	 * Call endFrame() once per frame. Bitmaps that haven't been acquired for
+	 * maxIdleFrames frames are destroyed then, so that targets for old window
+	 * sizes don't pile up.
+	 *
+	 * Not thread-safe. Use it on the thread that draws.
+	 */
+	class RenderTargetPool {
+	public:
+		explicit RenderTargetPool(int maxIdleFrames = 3)
+			: maxIdleFrames(maxIdleFrames)
+		{}
+
+		RenderTargetPool(const RenderTargetPool&) = delete;
+		RenderTargetPool& operator=(const RenderTargetPool&) = delete;
+
+		/**
+		 * @brief Gets a bitmap with the given size, pixel format and flags
+		 * (by default the current new bitmap format and flags), reusing an idle
+		 * one if there is one.
+		 * @throws ResourceLoadError if a new bitmap can't be created.
+		 */
+		[[nodiscard]] PooledRenderTarget acquire(
+			Vec2i size,
+			int format = Bitmap::GetNewBitmapFormat(),
+			int flags = Bitmap::GetNewBitmapFlags()
+		) {
+			auto& bucket = entries[RenderTargetKey{size, format, flags}];
+
+			/* the most recently used one, so that the rest can age out if they aren't needed */
+			detail::PooledRenderTargetEntry* entry = nullptr;
+			for(auto& e: bucket) {
+				if(!e->inUse && (!entry || e->lastUsedFrame > entry->lastUsedFrame)) {
+					entry = e.get();
+				}
+			}
+
+			if(entry) {
+				stats.numReused++;
+			} else {
+				auto newEntry = std::make_unique<detail::PooledRenderTargetEntry>();
+				{
+					ScopedNewBitmapFormat scopedFormat(format);
+					ScopedNewBitmapFlags scopedFlags(flags);
+					newEntry->bitmap = std::make_unique<Bitmap>(size.x, size.y);
+				}
+				newEntry->bytes = PixelFormat(newEntry->bitmap->getFormat()).dataSize(newEntry->bitmap->size());
+				entry = newEntry.get();
+				bucket.push_back(std::move(newEntry));
+
+				stats.numCreated++;
+				stats.numTargets++;
+				stats.currentBytes += entry->bytes;
+				stats.peakBytes = std::max(stats.peakBytes, stats.currentBytes);
+			}
+
+			entry->inUse = true;
+			entry->lastUsedFrame = frame;
+			stats.numInUse++;
+			stats.inUseBytes += entry->bytes;
+			return {this, entry};
+		}
+
+		/**
+		 * @brief Like acquire(), but also makes the bitmap the target bitmap
+		 * until the returned object is destroyed.
+		 */
+		[[nodiscard]] ScopedRenderTarget bind(
+			Vec2i size,
+			int format = Bitmap::GetNewBitmapFormat(),
+			int flags = Bitmap::GetNewBitmapFlags()
+		) {
+			return ScopedRenderTarget(acquire(size, format, flags));
+		}
+
+		/// @brief Ends the frame, destroying bitmaps that weren't acquired in the last maxIdleFrames frames.
+		void endFrame() {
+			trim(maxIdleFrames);
+			frame++;
+		}
+
+		/**
+		 * @brief Destroys the bitmaps that are not in use and haven't been
+		 * acquired in the last idleFrames frames. trim(0) destroys all idle
+		 * bitmaps.
+		 */
+		void trim(int idleFrames) {
+			for(auto it = entries.begin(); it != entries.end(); ) {
+				std::erase_if(it->second, [&](const std::unique_ptr<detail::PooledRenderTargetEntry>& e) {
+					if(e->inUse || int64_t(frame - e->lastUsedFrame) < idleFrames) {
+						return false;
+					}
+					stats.numTrimmed++;
+					stats.numTargets--;
+					stats.currentBytes -= e->bytes;
+					return true;
+				});
+				it = it->second.empty() ? entries.erase(it) : std::next(it);
+			}
+		}
+
+		/// @brief Destroys all bitmaps that are not in use.
+		void clear() {
+			trim(0);
+		}
+
+		[[nodiscard]] const RenderTargetPoolStats& getStats() const {
+			return stats;
+		}
+
+		[[nodiscard]] int getMaxIdleFrames() const {
+			return maxIdleFrames;
+		}
+
+		void setMaxIdleFrames(int frames) {
+			maxIdleFrames = frames;
+		}
+
+	private:
+		friend class PooledRenderTarget;
+
+		void giveBack(detail::PooledRenderTargetEntry* entry) {
+			entry->inUse = false;
+			entry->lastUsedFrame = frame;
+			stats.numInUse--;
+			stats.inUseBytes -= entry->bytes;
+		}
+
+		int maxIdleFrames;
+		uint64_t frame = 0;
+		std::unordered_map<RenderTargetKey, std::vector<std::unique_ptr<detail::PooledRenderTargetEntry>>, detail::RenderTargetKeyHash> entries;
+		RenderTargetPoolStats stats;
+	};
+
+	inline void PooledRenderTarget::release() {
+		if(entry) {
+			pool->giveBack(entry);
+			pool = nullptr;
+			entry = nullptr;
+		}
+	}
+
+}
+
+#endif //AXXEGRO_RENDERTARGETPOOL_HPP
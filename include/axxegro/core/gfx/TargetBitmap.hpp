@@ -24,7 +24,7 @@ namespace al {
 			 * https://liballeg.org/a5docs/trunk/transformations.html#al_use_transform
 			 */
 			void useTransform(const Transform& transform) { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				al_use_transform(&transform);
+				RenderStateCache::ThisThread().useTransform(&transform);
 			}
 
 			/**
@@ -33,7 +33,7 @@ namespace al {
 			 * https://liballeg.org/a5docs/trunk/transformations.html#al_use_projection_transform
 			 */
 			void useProjectionTransform(const Transform& transform) { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				al_use_projection_transform(&transform);
+				RenderStateCache::ThisThread().useProjectionTransform(&transform);
 			}
 
 			void resetTransform() {
@@ -44,17 +44,17 @@ namespace al {
 			}
 
 			Transform currentTransform() { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				return al_get_current_transform();
+				return RenderStateCache::ThisThread().getCurrentTransform();
 			}
 			Transform currentInverseTransform() { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
 				return al_get_current_inverse_transform();
 			}
 			Transform currentProjectionTransform() { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				return al_get_current_projection_transform();
+				return RenderStateCache::ThisThread().getCurrentProjectionTransform();
 			}
 
 			void setRenderState(ALLEGRO_RENDER_STATE state, int value) { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				al_set_render_state(state, value);
+				RenderStateCache::ThisThread().setRenderState(state, value);
 			}
 			void setAlphaTest(bool value) {
 				setRenderState(ALLEGRO_ALPHA_TEST, value);
@@ -79,20 +79,20 @@ namespace al {
 				al_clear_depth_buffer(x);
 			}
 			void setClippingRectangle(Rect<int> r) { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				al_set_clipping_rectangle(r.a.x, r.a.y, r.width(), r.height());
+				RenderStateCache::ThisThread().setClippingRectangle(r.a.x, r.a.y, r.width(), r.height());
 			}
 			[[nodiscard]] RectI getClippingRectangle() const { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
 				int x,y,w,h;
-				al_get_clipping_rectangle(&x, &y, &w, &h);
+				RenderStateCache::ThisThread().getClippingRectangle(&x, &y, &w, &h);
 				return RectI::XYWH(x,y,w,h);
 			}
 			void resetClippingRectangle() { AXXEGRO_SUPPRESS_CAN_BE_MADE_STATIC
-				al_reset_clipping_rectangle();
+				RenderStateCache::ThisThread().resetClippingRectangle();
 			}
 
 		private:
 			[[nodiscard]] ALLEGRO_BITMAP* getPointer() const override {
-				return al_get_target_bitmap();
+				return RenderStateCache::ThisThread().getTargetBitmap();
 			}
 		};
 	}
@@ -103,7 +103,7 @@ namespace al {
 
 	inline detail::CTargetBitmap TargetBitmap;
 
-#endif //AXXEGRO_TARGETBITMAP_HPP
+}
 
+#endif //AXXEGRO_TARGETBITMAP_HPP
 
-}
@@ -0,0 +1,363 @@
+#ifndef AXXEGRO_TEXTUREATLAS_HPP
+#define AXXEGRO_TEXTUREATLAS_HPP
+
+#include "Bitmap.hpp"
+#include "Blender.hpp"
+
+#include "axxegro/addons/image/ImageAddon.hpp"
+#include "axxegro/com/Exception.hpp"
+#include "axxegro/com/math/RectPacker.hpp"
+#include "axxegro/core/Config.hpp"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @file
+ * Packing many small images into a few large bitmaps so that Allegro can
+ * batch consecutive draws (it only does so for bitmaps that share a parent).
+ */
+
+namespace al {
+
+	/**
+	 * @brief Packs images into one or more page bitmaps and hands out SubBitmap
+	 * handles to them.
+	 *
+	 * Handles stay valid for the lifetime of the atlas, including across repack().
+	 * Removed entries leave holes in their page until the next repack().
+	 *
+	 * Pages are created with the new bitmap flags that are current when they are needed.
+	 */
+	class TextureAtlas {
+	public:
+		/**
+		 * @param pageSize Size of every page bitmap.
+		 * @param padding Number of transparent pixels kept between images,
+		 * which avoids bleeding when drawing with linear filtering.
+		 */
+		explicit TextureAtlas(Vec2i pageSize = {2048, 2048}, int padding = 1)
+			: pageSize(pageSize), padding(padding)
+		{}
+
+		TextureAtlas(const TextureAtlas&) = delete;
+		TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+		/**
+		 * @brief Copies `image` into the atlas. If an entry with the same name
+		 * exists, it is replaced (its SubBitmap handle stays valid).
+		 *
+		 * If a layout loaded with loadLayout() has an entry with the same name,
+		 * that position is used instead of searching for one.
+		 *
+		 * @throws ResourceLoadError if the image is larger than a page, or if
+		 * the loaded layout reserves a different size for this name.
+		 * @return A handle to the image inside the atlas.
+		 */
+		SubBitmap& insert(const std::string& name, const Bitmap& image) {
+			Vec2i size = image.size();
+			if(size.x + 2*padding > pageSize.x || size.y + 2*padding > pageSize.y) {
+				throw ResourceLoadError(
+					"Cannot fit a %dx%d image (\"%s\") into a %dx%d atlas page",
+					size.x, size.y, name.c_str(), pageSize.x, pageSize.y
+				);
+			}
+			/* the packer can't free the reserved slot, so a mismatch would leak it until repack() */
+			if(auto rIt = reserved.find(name); rIt != reserved.end() && rIt->second.rect.size() != size) {
+				Vec2i reservedSize = rIt->second.rect.size();
+				throw ResourceLoadError(
+					"Image \"%s\" is %dx%d, but the loaded texture atlas layout reserves %dx%d for it",
+					name.c_str(), size.x, size.y, reservedSize.x, reservedSize.y
+				);
+			}
+
+			Placement placement;
+			if(auto it = entries.find(name); it != entries.end() && it->second.rect.size() == size) {
+				placement = {it->second.page, it->second.rect};
+			} else if(auto rIt = reserved.find(name); rIt != reserved.end()) {
+				placement = rIt->second;
+			} else {
+				placement = allocate(size);
+			}
+			reserved.erase(name);
+
+			Bitmap& page = *pages[placement.page].bitmap;
+			{
+				ScopedTargetBitmap stb(page);
+				ScopedBlender sb({ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO});
+				image.draw(Vec2f(placement.rect.a));
+			}
+
+			if(auto it = entries.find(name); it != entries.end()) {
+				it->second.page = placement.page;
+				it->second.rect = placement.rect;
+				it->second.sub->reparent(page, placement.rect);
+				return *it->second.sub;
+			}
+
+			Entry entry {
+				.page = placement.page,
+				.rect = placement.rect,
+				.sub = std::unique_ptr<SubBitmap>(new SubBitmap(page.createSubBitmap(placement.rect)))
+			};
+			return *entries.emplace(name, std::move(entry)).first->second.sub;
+		}
+
+		/**
+		 * @brief Loads an image file with the image addon and copies it into the
+		 * atlas like insert(const std::string&, const Bitmap&).
+		 *
+		 * @throws ResourceLoadError if the file can't be loaded or the image can't be inserted.
+		 */
+		SubBitmap& insert(const std::string& name, const std::string& filename) {
+			InternalRequire<ImageAddon>();
+			ALLEGRO_BITMAP* p = al_load_bitmap(filename.c_str());
+			if(!p) {
+				throw ResourceLoadError("Cannot load bitmap from file \"%s\"", filename.c_str());
+			}
+			return insert(name, Bitmap(p));
+		}
+
+		/// @return The handle for the given name, or nullptr if there is no such entry.
+		[[nodiscard]] SubBitmap* find(const std::string& name) {
+			auto it = entries.find(name);
+			return it == entries.end() ? nullptr : it->second.sub.get();
+		}
+
+		/// @throws OutOfRangeError if there is no such entry.
+		[[nodiscard]] SubBitmap& at(const std::string& name) {
+			if(auto* sub = find(name)) {
+				return *sub;
+			}
+			throw OutOfRangeError("No image named \"%s\" in the texture atlas", name.c_str());
+		}
+
+		[[nodiscard]] bool contains(const std::string& name) const {
+			return entries.contains(name);
+		}
+
+		/**
+		 * @brief Removes an entry. Its handle becomes invalid.
+		 * @return false if there was no such entry.
+		 */
+		bool remove(const std::string& name) {
+			auto it = entries.find(name);
+			if(it == entries.end()) {
+				return false;
+			}
+			entries.erase(it);
+			return true;
+		}
+
+		/**
+		 * @brief Packs all entries from scratch (largest first), which reclaims
+		 * space left by removed entries and usually reduces the number of pages.
+		 * Pixels are copied to the new pages and all handles are reparented.
+		 */
+		void repack() {
+			std::vector<std::pair<const std::string*, Entry*>> order;
+			order.reserve(entries.size());
+			for(auto& [name, entry]: entries) {
+				order.emplace_back(&name, &entry);
+			}
+			std::sort(order.begin(), order.end(), [](const auto& l, const auto& r) {
+				Vec2i ls = l.second->rect.size(), rs = r.second->rect.size();
+				int lMax = std::max(ls.x, ls.y), rMax = std::max(rs.x, rs.y);
+				if(lMax != rMax) {
+					return lMax > rMax;
+				}
+				return *l.first < *r.first;
+			});
+
+			std::vector<Page> oldPages = std::move(pages);
+			pages.clear();
+			std::vector<Placement> newPlacements;
+			newPlacements.reserve(order.size());
+			for(auto& [name, entry]: order) {
+				newPlacements.push_back(allocate(entry->rect.size()));
+			}
+
+			/* copy page by page to minimize target bitmap changes */
+			for(int p=0; p<(int)pages.size(); p++) {
+				ScopedTargetBitmap stb(*pages[p].bitmap);
+				ScopedBlender sb({ALLEGRO_ADD, ALLEGRO_ONE, ALLEGRO_ZERO});
+				for(size_t i=0; i<order.size(); i++) {
+					if(newPlacements[i].page == p) {
+						order[i].second->sub->draw(Vec2f(newPlacements[i].rect.a));
+					}
+				}
+			}
+			for(size_t i=0; i<order.size(); i++) {
+				Entry& entry = *order[i].second;
+				entry.page = newPlacements[i].page;
+				entry.rect = newPlacements[i].rect;
+				entry.sub->reparent(*pages[entry.page].bitmap, entry.rect);
+			}
+			reserved.clear();
+		}
+
+		/**
+		 * @brief Saves the current layout (page size, padding and every entry's
+		 * page and rectangle) in Allegro's config format.
+		 */
+		void saveLayout(const std::string& filename) const {
+			Config cfg;
+			cfg.set("atlas.pageWidth", pageSize.x);
+			cfg.set("atlas.pageHeight", pageSize.y);
+			cfg.set("atlas.padding", padding);
+			cfg.set("atlas.numPages", int(pages.size()));
+			for(const auto& [name, entry]: entries) {
+				/* the section view keeps a pointer to the name, so it must outlive the set() calls */
+				std::string sectionName = EntrySectionPrefix + name;
+				auto section = cfg.section(sectionName);
+				section.set("page", entry.page);
+				section.set("x", entry.rect.a.x);
+				section.set("y", entry.rect.a.y);
+				section.set("w", entry.rect.width());
+				section.set("h", entry.rect.height());
+			}
+			cfg.saveToFileOrThrow(filename);
+		}
+
+		/**
+		 * @brief Loads a layout saved with saveLayout(). Subsequent insert() calls
+		 * with matching names and sizes go straight to their saved positions.
+		 * The atlas must be empty.
+		 *
+		 * @throws ResourceLoadError if the file is missing or was saved with
+		 * a different page size or padding.
+		 */
+		void loadLayout(const std::string& filename) {
+			if(!entries.empty()) {
+				throw ResourceLoadError("A texture atlas layout can only be loaded into an empty atlas");
+			}
+			Config cfg(filename);
+			auto savedSize = Vec2i(cfg.get<int>("atlas.pageWidth").value_or(-1), cfg.get<int>("atlas.pageHeight").value_or(-1));
+			int savedPadding = cfg.get<int>("atlas.padding").value_or(-1);
+			if(savedSize != pageSize || savedPadding != padding) {
+				throw ResourceLoadError(
+					"Texture atlas layout \"%s\" is for %dx%d pages with padding %d, expected %dx%d with padding %d",
+					filename.c_str(), savedSize.x, savedSize.y, savedPadding, pageSize.x, pageSize.y, padding
+				);
+			}
+
+			pages.clear();
+			reserved.clear();
+			int numPages = cfg.get<int>("atlas.numPages").value_or(0);
+			for(int i=0; i<numPages; i++) {
+				addPage();
+			}
+
+			for(const auto& section: cfg.sections()) {
+				std::string sectionName = section.name();
+				if(!sectionName.starts_with(EntrySectionPrefix)) {
+					continue;
+				}
+				int page = section.get<int>("page").value_or(-1);
+				auto rect = RectI::XYWH(
+					section.get<int>("x").value_or(0),
+					section.get<int>("y").value_or(0),
+					section.get<int>("w").value_or(0),
+					section.get<int>("h").value_or(0)
+				);
+				if(page < 0 || page >= numPages || rect.width() <= 0 || rect.height() <= 0) {
+					throw ResourceLoadError("Invalid entry \"%s\" in texture atlas layout \"%s\"", sectionName.c_str(), filename.c_str());
+				}
+				pages[page].packer.markUsed(padded(rect));
+				reserved[sectionName.substr(EntrySectionPrefix.size())] = {page, rect};
+			}
+		}
+
+		/// @return The number of page bitmaps.
+		[[nodiscard]] size_t numPages() const {
+			return pages.size();
+		}
+
+		/// @return The i-th page bitmap.
+		[[nodiscard]] Bitmap& page(size_t i) {
+			return *pages.at(i).bitmap;
+		}
+
+		/// @return The number of images in the atlas.
+		[[nodiscard]] size_t size() const {
+			return entries.size();
+		}
+
+		/// @return The fraction of page area taken by live images (including padding).
+		[[nodiscard]] float occupancy() const {
+			if(pages.empty()) {
+				return 0.0f;
+			}
+			int64_t used = 0;
+			for(const auto& [name, entry]: entries) {
+				used += entry.paddedArea(padding);
+			}
+			return float(used) / (float(pages.size()) * float(pageSize.x) * float(pageSize.y));
+		}
+
+		[[nodiscard]] Vec2i getPageSize() const {
+			return pageSize;
+		}
+
+		[[nodiscard]] int getPadding() const {
+			return padding;
+		}
+
+	private:
+		static inline const std::string EntrySectionPrefix = "image:";
+
+		struct Page {
+			std::unique_ptr<Bitmap> bitmap;
+			RectPacker packer;
+		};
+
+		struct Placement {
+			int page = 0;
+			RectI rect;
+		};
+
+		struct Entry {
+			int page;
+			RectI rect;
+			std::unique_ptr<SubBitmap> sub;
+
+			[[nodiscard]] int64_t paddedArea(int padding) const {
+				return int64_t(rect.width() + 2*padding) * (rect.height() + 2*padding);
+			}
+		};
+
+		[[nodiscard]] RectI padded(const RectI& r) const {
+			return {r.a - Vec2i(padding, padding), r.b + Vec2i(padding, padding)};
+		}
+
+		Page& addPage() {
+			auto bmp = std::make_unique<Bitmap>(pageSize.x, pageSize.y, Color(0, 0, 0, 0));
+			pages.push_back(Page{std::move(bmp), RectPacker(pageSize)});
+			return pages.back();
+		}
+
+		Placement allocate(Vec2i size) {
+			Vec2i paddedSize = size + Vec2i(2*padding, 2*padding);
+			for(int i=0; i<(int)pages.size(); i++) {
+				if(auto r = pages[i].packer.insert(paddedSize)) {
+					return {i, RectI::PosSize(r->a + Vec2i(padding, padding), size)};
+				}
+			}
+			auto r = addPage().packer.insert(paddedSize);
+			return {int(pages.size()) - 1, RectI::PosSize(r->a + Vec2i(padding, padding), size)};
+		}
+
+		Vec2i pageSize;
+		int padding;
+		std::vector<Page> pages;
+		std::unordered_map<std::string, Entry> entries;
+		std::map<std::string, Placement> reserved;
+	};
+
+}
+
+#endif //AXXEGRO_TEXTUREATLAS_HPP
@@ -0,0 +1,345 @@
+#ifndef AXXEGRO_FRAMEPROFILER_HPP
+#define AXXEGRO_FRAMEPROFILER_HPP
+
+#include "Time.hpp"
+
+#include "../../com/Exception.hpp"
+#include "../../com/util/format.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace al {
+
+	struct FrameTimeStats {
+		size_t numFrames = 0;
+		double min = 0.0;
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	struct FrameTimeHistogram {
+		double binWidth = 0.0;
+
+		/// counts[i] is the number of frames that took [i*binWidth, (i+1)*binWidth) seconds. The last bin also counts everything longer.
+		std::vector<size_t> counts;
+	};
+
+	/**
+	 * @brief Records per-frame durations, and time spent in named sections of
+	 * each frame, in a fixed-size ring of recent frames.
+	 *
+	 * Recording (endFrame(), section scopes) must happen on one thread. The ring is
+	 * lock-free, so statistics and dumps can be taken from any other thread while
+	 * frames are being recorded; they then reflect a frame or two of overlap at worst.
+	 * Sections must be added before other threads start reading.
+	 *
+	 * All times are in seconds.
+	 */
+	class FrameProfiler {
+	public:
+		using SectionID = uint32_t;
+		static constexpr size_t MaxSections = 16;
+
+		class ScopedSection {
+		public:
+			ScopedSection(FrameProfiler& profiler, SectionID id)
+				: profiler(profiler), id(id), t0(GetTime())
+			{}
+
+			~ScopedSection() {
+				profiler.addSectionTime(id, GetTime() - t0);
+			}
+
+			ScopedSection(const ScopedSection&) = delete;
+			ScopedSection& operator=(const ScopedSection&) = delete;
+		private:
+			FrameProfiler& profiler;
+			SectionID id;
+			double t0;
+		};
+
+		/// @param historySize The number of most recent frames kept for statistics.
+		explicit FrameProfiler(size_t historySize = 1024)
+			: historySize(std::max<size_t>(historySize, 1)),
+			  ring(std::make_unique<Record[]>(this->historySize))
+		{}
+
+		/**
+		 * @brief Registers a section, or returns the ID of an existing one with the same name.
+		 * @throws OutOfRangeError if there are already MaxSections sections.
+		 */
+		SectionID addSection(const std::string& name) {
+			if(auto id = findSection(name)) {
+				return *id;
+			}
+			if(sectionNames.size() >= MaxSections) {
+				throw OutOfRangeError("Cannot add profiler section \"%s\": the limit is %zu sections", name.c_str(), MaxSections);
+			}
+			sectionNames.push_back(name);
+			return SectionID(sectionNames.size() - 1);
+		}
+
+		[[nodiscard]] std::optional<SectionID> findSection(const std::string& name) const {
+			auto it = std::find(sectionNames.begin(), sectionNames.end(), name);
+			if(it == sectionNames.end()) {
+				return std::nullopt;
+			}
+			return SectionID(it - sectionNames.begin());
+		}
+
+		[[nodiscard]] const std::string& getSectionName(SectionID id) const {
+			return sectionNames.at(id);
+		}
+
+		[[nodiscard]] size_t numSections() const {
+			return sectionNames.size();
+		}
+
+		/**
+		 * @brief Measures the time until the returned object goes out of scope as part of section `id`.
+		 * @throws OutOfRangeError if `id` wasn't returned by this profiler's addSection().
+		 */
+		[[nodiscard]] ScopedSection scope(SectionID id) {
+			checkSection(id);
+			return {*this, id};
+		}
+
+		/**
+		 * @brief Adds time to a section of the current frame. A section may be entered several times per frame.
+		 * @throws OutOfRangeError if `id` wasn't returned by this profiler's addSection().
+		 */
+		void addSectionTime(SectionID id, double seconds) {
+			checkSection(id);
+			currentSections[id] += float(seconds);
+		}
+
+		/**
+		 * @brief Ends the current frame. Its duration is the time since the previous
+		 * endFrame() call; the first call only starts the clock.
+		 */
+		void endFrame() {
+			double now = GetTime();
+			if(lastFrameEnd >= 0.0) {
+				uint64_t h = head.load(std::memory_order_relaxed);
+				Record& rec = ring[h % historySize];
+				rec.total.store(float(now - lastFrameEnd), std::memory_order_relaxed);
+				for(size_t i=0; i<MaxSections; i++) {
+					rec.sections[i].store(currentSections[i], std::memory_order_relaxed);
+				}
+				head.store(h + 1, std::memory_order_release);
+			}
+			currentSections.fill(0.0f);
+			lastFrameEnd = now;
+		}
+
+		/// @brief Forgets all recorded frames. Sections stay registered.
+		void reset() {
+			head.store(0, std::memory_order_release);
+			currentSections.fill(0.0f);
+			lastFrameEnd = -1.0;
+		}
+
+		/// @return The number of frames currently held (at most the history size).
+		[[nodiscard]] size_t numFrames() const {
+			return std::min<uint64_t>(head.load(std::memory_order_acquire), historySize);
+		}
+
+		/// @return Statistics of whole-frame durations.
+		[[nodiscard]] FrameTimeStats getStats() const {
+			return CalcStats(snapshot(std::nullopt));
+		}
+
+		/**
+		 * @return Statistics of the time spent in a section per frame.
+		 * @throws OutOfRangeError if `id` wasn't returned by this profiler's addSection().
+		 */
+		[[nodiscard]] FrameTimeStats getSectionStats(SectionID id) const {
+			checkSection(id);
+			return CalcStats(snapshot(id));
+		}
+
+		/// @return A histogram of whole-frame durations.
+		[[nodiscard]] FrameTimeHistogram getHistogram(double binWidth = 0.001, size_t numBins = 50) const {
+			FrameTimeHistogram ret {.binWidth = binWidth, .counts = std::vector<size_t>(std::max<size_t>(numBins, 1), 0)};
+			for(float t: snapshot(std::nullopt)) {
+				auto bin = size_t(std::max(0.0, double(t) / binWidth));
+				ret.counts[std::min(bin, ret.counts.size() - 1)]++;
+			}
+			return ret;
+		}
+
+		/// @return One line per frame (oldest first): frame duration and section times, in milliseconds.
+		[[nodiscard]] std::string toCSV() const {
+			auto frames = snapshotAll();
+			std::string ret = "frame,total_ms";
+			for(const auto& name: sectionNames) {
+				ret += "," + name + "_ms";
+			}
+			ret += "\n";
+			for(size_t f=0; f<frames.size(); f++) {
+				ret += Format("%zu,%.4f", f, 1000.0 * frames[f][0]);
+				for(size_t s=0; s<sectionNames.size(); s++) {
+					ret += Format(",%.4f", 1000.0 * frames[f][s + 1]);
+				}
+				ret += "\n";
+			}
+			return ret;
+		}
+
+		/// @return Statistics (in milliseconds) and per-frame samples as a JSON object.
+		[[nodiscard]] std::string toJSON() const {
+			auto frames = snapshotAll();
+			auto statsJSON = [](const FrameTimeStats& s) {
+				return Format(
+					"{\"min\":%.4f,\"mean\":%.4f,\"p50\":%.4f,\"p95\":%.4f,\"p99\":%.4f,\"max\":%.4f}",
+					1000.0 * s.min, 1000.0 * s.mean, 1000.0 * s.p50, 1000.0 * s.p95, 1000.0 * s.p99, 1000.0 * s.max
+				);
+			};
+
+			std::string ret = Format("{\"numFrames\":%zu,\"unit\":\"ms\",\"total\":", frames.size());
+			ret += statsJSON(getStats());
+			ret += ",\"sections\":{";
+			for(size_t s=0; s<sectionNames.size(); s++) {
+				ret += (s ? ",\"" : "\"") + EscapeJSON(sectionNames[s]) + "\":" + statsJSON(getSectionStats(SectionID(s)));
+			}
+			ret += "},\"columns\":[\"total\"";
+			for(const auto& name: sectionNames) {
+				ret += ",\"" + EscapeJSON(name) + "\"";
+			}
+			ret += "],\"frames\":[";
+			for(size_t f=0; f<frames.size(); f++) {
+				ret += f ? ",[" : "[";
+				for(size_t c=0; c<frames[f].size(); c++) {
+					ret += Format(c ? ",%.4f" : "%.4f", 1000.0 * frames[f][c]);
+				}
+				ret += "]";
+			}
+			ret += "]}";
+			return ret;
+		}
+
+		/// @throws FileError if the file can't be written.
+		void saveCSV(const std::string& filename) const {
+			SaveText(filename, toCSV());
+		}
+
+		/// @throws FileError if the file can't be written.
+		void saveJSON(const std::string& filename) const {
+			SaveText(filename, toJSON());
+		}
+
+	private:
+		struct Record {
+			std::atomic<float> total {0.0f};
+			std::array<std::atomic<float>, MaxSections> sections {};
+		};
+
+		/* durations of the held frames, oldest first; a section's if `section` is set */
+		void checkSection(SectionID id) const {
+			if(id >= sectionNames.size()) {
+				throw OutOfRangeError("Invalid profiler section ID %u (%zu sections registered)", unsigned(id), sectionNames.size());
+			}
+		}
+
+		[[nodiscard]] std::vector<float> snapshot(std::optional<SectionID> section) const {
+			uint64_t h = head.load(std::memory_order_acquire);
+			uint64_t n = std::min<uint64_t>(h, historySize);
+			std::vector<float> ret;
+			ret.reserve(n);
+			for(uint64_t i=h-n; i<h; i++) {
+				const Record& rec = ring[i % historySize];
+				ret.push_back((section ? rec.sections[*section] : rec.total).load(std::memory_order_relaxed));
+			}
+			return ret;
+		}
+
+		/* [total, section 0, section 1, ...] of the held frames, oldest first */
+		[[nodiscard]] std::vector<std::vector<float>> snapshotAll() const {
+			uint64_t h = head.load(std::memory_order_acquire);
+			uint64_t n = std::min<uint64_t>(h, historySize);
+			std::vector<std::vector<float>> ret;
+			ret.reserve(n);
+			for(uint64_t i=h-n; i<h; i++) {
+				const Record& rec = ring[i % historySize];
+				auto& row = ret.emplace_back();
+				row.push_back(rec.total.load(std::memory_order_relaxed));
+				for(size_t s=0; s<sectionNames.size(); s++) {
+					row.push_back(rec.sections[s].load(std::memory_order_relaxed));
+				}
+			}
+			return ret;
+		}
+
+		static FrameTimeStats CalcStats(std::vector<float> samples) {
+			FrameTimeStats ret;
+			ret.numFrames = samples.size();
+			if(samples.empty()) {
+				return ret;
+			}
+			std::sort(samples.begin(), samples.end());
+			double sum = 0.0;
+			for(float s: samples) {
+				sum += s;
+			}
+			auto percentile = [&](double p) {
+				auto rank = size_t(std::ceil(p * double(samples.size())));
+				return double(samples[std::clamp<size_t>(rank, 1, samples.size()) - 1]);
+			};
+			ret.min = samples.front();
+			ret.mean = sum / double(samples.size());
+			ret.p50 = percentile(0.50);
+			ret.p95 = percentile(0.95);
+			ret.p99 = percentile(0.99);
+			ret.max = samples.back();
+			return ret;
+		}
+
+		static std::string EscapeJSON(const std::string& str) {
+			std::string ret;
+			for(char c: str) {
+				if(c == '"' || c == '\\') {
+					ret += '\\';
+					ret += c;
+				} else if((unsigned char)c < 0x20) {
+					ret += Format("\\u%04x", c);
+				} else {
+					ret += c;
+				}
+			}
+			return ret;
+		}
+
+		static void SaveText(const std::string& filename, const std::string& text) {
+			ALLEGRO_FILE* fp = al_fopen(filename.c_str(), "wb");
+			if(!fp) {
+				throw FileError("Cannot open \"%s\" for writing", filename.c_str());
+			}
+			size_t written = al_fwrite(fp, text.data(), text.size());
+			bool closed = al_fclose(fp);
+			if(written != text.size() || !closed) {
+				throw FileError("Cannot write to \"%s\"", filename.c_str());
+			}
+		}
+
+		size_t historySize;
+		std::unique_ptr<Record[]> ring;
+		std::atomic<uint64_t> head = 0;
+
+		std::vector<std::string> sectionNames;
+		std::array<float, MaxSections> currentSections {};
+		double lastFrameEnd = -1.0;
+	};
+
+}
+
+#endif //AXXEGRO_FRAMEPROFILER_HPP
@@ -12,6 +12,13 @@
 #include "../event/EventQueue.hpp"
 #include "../display.hpp"
 
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <thread>
+
 
 namespace al {
 
@@ -32,10 +39,38 @@ namespace al {
 		Hz
 	>;
 
+	enum class FramePacing {
+		/// Block on events from an Allegro timer. Cheap, but frame times jitter with the timer and event latency.
+		TimerEvents,
+
+		/**
+		 * Sleep on a monotonic clock in short steps and spin (yielding) for the last
+		 * stretch before the deadline. The spin margin adapts to how late the OS
+		 * wakes up the thread, so it costs a fraction of a core rather than a whole one.
+		 */
+		Precise
+	};
+
+	struct FramePacingStats {
+		/// Number of frames (wait() calls) measured since the limit was set or stats were reset.
+		int64_t numFrames = 0;
+
+		/// Number of frames that were skipped because the caller fell behind by more than a period.
+		int64_t numMissedFrames = 0;
+
+		/// Mean, 99th percentile and maximum time between consecutive wait() returns over the last frames, in seconds.
+		double meanInterval = 0.0;
+		double p99Interval = 0.0;
+		double maxInterval = 0.0;
+
+		/// Mean time by which wait() returned after its deadline over the last frames, in seconds. Only measured with FramePacing::Precise.
+		double meanOvershoot = 0.0;
+	};
+
 	struct FramerateLimiter {
 
-		explicit FramerateLimiter(FramerateLimit limit = FPSLimit::None)
-			: timer(1_Hz)
+		explicit FramerateLimiter(FramerateLimit limit = FPSLimit::None, FramePacing pacing = FramePacing::TimerEvents)
+			: timer(1_Hz), pacing(pacing)
 		{
 			queue.registerSource(timer.getEventSource());
 			setLimit(limit);
@@ -49,27 +84,171 @@ namespace al {
 			}
 
 			if(std::holds_alternative<Hz>(limitValue)) {
+				period = std::chrono::duration_cast<Clock::duration>(
+					std::chrono::duration<double>(Seconds(std::get<Hz>(limitValue)).getSeconds())
+				);
 				timer.setFreq(std::get<Hz>(limitValue));
-				timer.stop();
-				timer.start();
-			} else {
-				timer.stop();
 			}
+			restart();
+		}
+
+		void setPacing(FramePacing newPacing) {
+			pacing = newPacing;
+			restart();
+		}
+
+		[[nodiscard]] FramePacing getPacing() const {
+			return pacing;
 		}
 
 		void wait() {
 			if(std::holds_alternative<FPSLimit::NoneT>(limitValue)) {
+				recordFrame(std::nullopt);
 				return;
 			} else if(std::holds_alternative<Hz>(limitValue)) {
-				queue.wait();
-				queue.flush();
+				if(pacing == FramePacing::Precise) {
+					waitPrecise();
+				} else {
+					queue.wait();
+					queue.flush();
+					int64_t count = timer.getCount();
+					if(lastTimerCount >= 0 && count - lastTimerCount > 1) {
+						numMissedFrames += count - lastTimerCount - 1;
+					}
+					lastTimerCount = count;
+					recordFrame(std::nullopt);
+				}
+			}
+		}
+
+		/// @return Frame interval statistics over (at most) the last 256 frames.
+		[[nodiscard]] FramePacingStats getStats() const {
+			FramePacingStats ret;
+			ret.numFrames = numFrames;
+			ret.numMissedFrames = numMissedFrames;
+			size_t n = std::min<size_t>(numIntervals, HistorySize);
+			if(n == 0) {
+				return ret;
 			}
+
+			std::array<float, HistorySize> sorted;
+			std::copy_n(intervals.begin(), n, sorted.begin());
+			std::sort(sorted.begin(), sorted.begin() + n);
+			double sum = 0.0;
+			for(size_t i=0; i<n; i++) {
+				sum += sorted[i];
+			}
+			ret.meanInterval = sum / double(n);
+			ret.p99Interval = sorted[std::min(n - 1, size_t(std::ceil(0.99 * double(n))) - 1)];
+			ret.maxInterval = sorted[n - 1];
+
+			double overshootSum = 0.0;
+			for(size_t i=0; i<n; i++) {
+				overshootSum += overshoots[i];
+			}
+			ret.meanOvershoot = overshootSum / double(n);
+			return ret;
+		}
+
+		void resetStats() {
+			numFrames = 0;
+			numMissedFrames = 0;
+			numIntervals = 0;
+			lastReturn.reset();
 		}
 
 	private:
+		using Clock = std::chrono::steady_clock;
+		static constexpr size_t HistorySize = 256;
+
+		void restart() {
+			if(std::holds_alternative<Hz>(limitValue) && pacing == FramePacing::TimerEvents) {
+				timer.stop();
+				timer.start();
+			} else {
+				timer.stop();
+			}
+			deadline.reset();
+			lastTimerCount = -1;
+			resetStats();
+		}
+
+		void recordFrame(std::optional<Clock::duration> overshoot) {
+			auto now = Clock::now();
+			if(lastReturn) {
+				size_t idx = numIntervals % HistorySize;
+				intervals[idx] = std::chrono::duration<float>(now - *lastReturn).count();
+				overshoots[idx] = overshoot ? std::chrono::duration<float>(*overshoot).count() : 0.0f;
+				numIntervals++;
+			}
+			lastReturn = now;
+			numFrames++;
+		}
+
+		void waitPrecise() {
+			auto now = Clock::now();
+			if(!deadline) {
+				deadline = now;
+			} else {
+				/* advancing by exactly one period keeps the average rate exact even if single frames are late */
+				*deadline += period;
+				if(now > *deadline + period) {
+					/* fell behind by more than a frame: resynchronize instead of rushing several frames out */
+					numMissedFrames += (now - *deadline) / period;
+					deadline = now;
+				}
+			}
+			sleepUntil(*deadline);
+			recordFrame(Clock::now() - *deadline);
+		}
+
+		void sleepUntil(Clock::time_point target) {
+			using namespace std::chrono_literals;
+			constexpr auto SleepStep = 1ms;
+			for(;;) {
+				auto remaining = target - Clock::now();
+				if(remaining <= spinMargin()) {
+					break;
+				}
+				auto t0 = Clock::now();
+				std::this_thread::sleep_for(SleepStep);
+				updateSleepEstimate(std::chrono::duration<double>(Clock::now() - t0).count());
+			}
+			while(Clock::now() < target) {
+				std::this_thread::yield();
+			}
+		}
+
+		/* exponential moving average of how long sleep_for(1ms) actually takes, and of its variance */
+		void updateSleepEstimate(double observed) {
+			constexpr double Weight = 0.05;
+			double delta = observed - sleepMean;
+			sleepMean += Weight * delta;
+			sleepVariance = (1.0 - Weight) * (sleepVariance + Weight * delta * delta);
+		}
+
+		[[nodiscard]] Clock::duration spinMargin() const {
+			double margin = std::clamp(sleepMean + 2.0 * std::sqrt(sleepVariance), 0.0005, 0.004);
+			return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(margin));
+		}
+
 		FramerateLimit limitValue;
 		Timer timer;
 		EventQueue queue;
+		FramePacing pacing;
+
+		Clock::duration period {};
+		std::optional<Clock::time_point> deadline;
+		int64_t lastTimerCount = -1;
+		double sleepMean = 0.002;
+		double sleepVariance = 0.0;
+
+		std::optional<Clock::time_point> lastReturn;
+		std::array<float, HistorySize> intervals {};
+		std::array<float, HistorySize> overshoots {};
+		size_t numIntervals = 0;
+		int64_t numFrames = 0;
+		int64_t numMissedFrames = 0;
 	};
 
 }
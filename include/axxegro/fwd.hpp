@@ -7,6 +7,12 @@
 
 namespace al {
 	class AdapterInfo;
+	class AssetArchive;
+	class AssetArchiveBuilder;
+	class AssetCache;
+	struct AssetCacheStats;
+	struct AssetMemoryUsage;
+	class AsyncLoader;
 	struct AudioAddon;
 	struct AudioCodecAddon;
 	struct AudioFormat;
@@ -19,6 +25,10 @@ namespace al {
 	struct BufferConfig;
 	class CDefaultVoice;
 	class Color;
+	struct ColorMatrix;
+	class CommandBuffer;
+	class CommandList;
+	struct CommandBufferStats;
 	class Config;
 	struct ConfigEntry;
 	struct ConfigEntryIterator;
@@ -27,11 +37,16 @@ namespace al {
 	struct ConfigSectionIterator;
 	struct ConfigSectionView;
 	struct ConfigValue;
+	struct ConvolutionKernel;
 	struct CoreAllegro;
 
+	struct DirtyRegionConfig;
+	class DirtyRegionTracker;
 	class Display;
 	class DisplayBackbuffer;
 	class DisplayEventSource;
+	struct DrawState;
+	class EventBatch;
 	class EventDispatcher;
 	class EventLoop;
 	struct EventLoopConfig;
@@ -39,12 +54,17 @@ namespace al {
 	class EventQueue;
 	class EventSource;
 	struct Exception;
+	class File;
 	class FileDialog;
 	struct FileDialogResult;
 
 	class Font;
 	struct FontAddon;
 	struct FPSCounter;
+	struct FramePacingStats;
+	class FrameProfiler;
+	struct FrameTimeHistogram;
+	struct FrameTimeStats;
 	struct FramerateLimiter;
 	class GenericEventHandler;
 	struct Glyph;
@@ -52,12 +72,17 @@ namespace al {
 	struct ImageAddon;
 	struct KeyboardDriver;
 	class KeyboardEventSource;
+	struct Levels;
+	class MappedFile;
 	class Mixer;
 	class MouseCursor;
 	struct MouseDriver;
 	class MouseEventSource;
 	struct MouseState;
 	struct NativeDialogAddon;
+	class ParallelCommandRecorder;
+	struct ParallelOptions;
+	class PathTessellator;
 	struct PixelABGR_F32;
 	struct PixelARGB8888;
 	struct PixelBGR888;
@@ -65,21 +90,40 @@ namespace al {
 	struct PixelRGB888;
 	struct PixelRGBA8888;
 	struct PlaybackParams;
+	class PooledRenderTarget;
+	class PrimBatch;
 	struct PrimitivesAddon;
+	class RawTextureCache;
+	struct RawTextureCacheStats;
+	class RectPacker;
+	class RenderStateCache;
+	struct RenderStateCacheStats;
+	struct RenderTargetKey;
+	class RenderTargetPool;
+	struct RenderTargetPoolStats;
 	class Sample;
 	struct SampleID;
 	class SampleInstance;
 	struct ScopedBlender;
+	class ScopedRenderTarget;
+	class ScopedPrimBatch;
 	class ScopedNewBitmapFlags;
+	class ScopedNewBitmapFormat;
 	struct ScopedSeparateBlender;
 	class ScopedTargetBitmap;
 	class ScopedTransform;
 	struct SeparateBlender;
 	class Shader;
+	struct SoftwareBlitOptions;
+	class SpriteBatch;
+	class StaticSpriteBatch;
 	struct StrHash;
+	struct StrokeStyle;
 	class SubBitmap;
 	class TextLog;
+	class TextureAtlas;
 	class TextLogEventSource;
+	class ThreadPool;
 	class Timer;
 	class TimerEventSource;
 	class Transform;
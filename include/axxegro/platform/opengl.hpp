@@ -85,8 +85,9 @@ namespace al::gl {
 		return al_get_opengl_variant();
 	}
 
-	void SetCurrentContext(al::Display& display) {
-		return al_set_current_opengl_context(display.ptr());
+	inline void SetCurrentContext(al::Display& display) {
+		al_set_current_opengl_context(display.ptr());
+		RenderStateCache::ThisThread().invalidate(); // the target bitmap may have changed
 	}
 }
 
@@ -0,0 +1,40 @@
+#include <axxegro/addons/asset/AssetArchiveBuilder.hpp>
+
+#include <cstdio>
+#include <filesystem>
+
+/*
+ * Packs files and directories into an asset archive readable with al::AssetArchive.
+ *
+ * Usage: axxpack <output> <input>...
+ *
+ * Directories are added recursively, with entries named by their path relative
+ * to the directory ("data" -> "bg.jpg", "audio/uuhhh.ogg", ...). Files given
+ * directly are named by their file name.
+ */
+
+int main(int argc, char** argv)
+{
+	if(argc < 3) {
+		std::fprintf(stderr, "usage: %s <output> <input>...\n", argv[0]);
+		return 2;
+	}
+
+	try {
+		al::AssetArchiveBuilder builder;
+		for(int i=2; i<argc; i++) {
+			std::filesystem::path input(argv[i]);
+			if(std::filesystem::is_directory(input)) {
+				builder.addDirectory(input);
+			} else {
+				builder.addFile(input, input.filename().generic_string());
+			}
+		}
+		builder.write(argv[1]);
+		std::printf("%s: %zu entries\n", argv[1], builder.size());
+	} catch(const std::exception& e) {
+		std::fprintf(stderr, "axxpack: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}